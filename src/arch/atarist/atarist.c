@@ -227,6 +227,161 @@ void st_set_port_b (atari_st_t *sim, unsigned char val)
 	sim->psg_port_b = val;
 }
 
+/*
+ * The MFP and the video registers are accessed through these functions
+ * so that the devices are up to date while the CPU runs a time slice.
+ * A write to the MFP ends the slice, since it can start a timer or
+ * change an interrupt mask. A write to the video registers ends the
+ * slice if it moves the next horizontal blanking change.
+ */
+static
+unsigned char st_mfp_get_uint8 (void *ext, unsigned long addr)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	return (e68901_get_uint8 (&sim->mfp, addr));
+}
+
+static
+unsigned short st_mfp_get_uint16 (void *ext, unsigned long addr)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	return (e68901_get_uint16 (&sim->mfp, addr));
+}
+
+static
+unsigned long st_mfp_get_uint32 (void *ext, unsigned long addr)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	return (e68901_get_uint32 (&sim->mfp, addr));
+}
+
+static
+void st_mfp_set_uint8 (void *ext, unsigned long addr, unsigned char val)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	e68901_set_uint8 (&sim->mfp, addr, val);
+
+	e68_clock_break (sim->cpu);
+}
+
+static
+void st_mfp_set_uint16 (void *ext, unsigned long addr, unsigned short val)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	e68901_set_uint16 (&sim->mfp, addr, val);
+
+	e68_clock_break (sim->cpu);
+}
+
+static
+void st_mfp_set_uint32 (void *ext, unsigned long addr, unsigned long val)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	e68901_set_uint32 (&sim->mfp, addr, val);
+
+	e68_clock_break (sim->cpu);
+}
+
+static
+unsigned char st_video_reg_get_uint8 (void *ext, unsigned long addr)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	return (st_video_get_uint8 (sim->video, addr));
+}
+
+static
+unsigned short st_video_reg_get_uint16 (void *ext, unsigned long addr)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	return (st_video_get_uint16 (sim->video, addr));
+}
+
+static
+unsigned long st_video_reg_get_uint32 (void *ext, unsigned long addr)
+{
+	atari_st_t *sim = ext;
+
+	st_clock_sync (sim);
+
+	return (st_video_get_uint32 (sim->video, addr));
+}
+
+static
+void st_video_reg_set_uint8 (void *ext, unsigned long addr, unsigned char val)
+{
+	unsigned long delay;
+	atari_st_t    *sim = ext;
+
+	st_clock_sync (sim);
+
+	delay = st_video_get_delay (sim->video);
+
+	st_video_set_uint8 (sim->video, addr, val);
+
+	if (st_video_get_delay (sim->video) != delay) {
+		e68_clock_break (sim->cpu);
+	}
+}
+
+static
+void st_video_reg_set_uint16 (void *ext, unsigned long addr, unsigned short val)
+{
+	unsigned long delay;
+	atari_st_t    *sim = ext;
+
+	st_clock_sync (sim);
+
+	delay = st_video_get_delay (sim->video);
+
+	st_video_set_uint16 (sim->video, addr, val);
+
+	if (st_video_get_delay (sim->video) != delay) {
+		e68_clock_break (sim->cpu);
+	}
+}
+
+static
+void st_video_reg_set_uint32 (void *ext, unsigned long addr, unsigned long val)
+{
+	unsigned long delay;
+	atari_st_t    *sim = ext;
+
+	st_clock_sync (sim);
+
+	delay = st_video_get_delay (sim->video);
+
+	st_video_set_uint32 (sim->video, addr, val);
+
+	if (st_video_get_delay (sim->video) != delay) {
+		e68_clock_break (sim->cpu);
+	}
+}
+
+
 static
 void st_setup_system (atari_st_t *sim, ini_sct_t *ini)
 {
@@ -246,8 +401,11 @@ void st_setup_system (atari_st_t *sim, ini_sct_t *ini)
 	ini_get_bool (sct, "fastboot", &fastboot, 0);
 	ini_get_string (sct, "parport", &parport, NULL);
 	ini_get_string (sct, "serport", &serport, NULL);
+	ini_get_bool (sct, "idle", &sim->idle_enable, 1);
 
-	pce_log_tag (MSG_INF, "SYSTEM:", "model=%s fastboot=%d\n", model, fastboot);
+	pce_log_tag (MSG_INF, "SYSTEM:", "model=%s fastboot=%d idle=%d\n",
+		model, fastboot, sim->idle_enable
+	);
 
 	if (strcmp (model, "st") == 0) {
 		sim->model = PCE_ST_ST;
@@ -315,19 +473,44 @@ void st_setup_mem (atari_st_t *sim, ini_sct_t *ini)
 	}
 }
 
+/*
+ * Mark the pages of read-only memory blocks as ROM for the
+ * instruction cache
+ */
+void st_setup_icache_rom (atari_st_t *sim)
+{
+	unsigned long addr;
+	mem_page_t    *pg;
+
+	for (addr = 0; addr < E68_IC_PAGE_CNT * MEM_PAGE_SIZE; addr += MEM_PAGE_SIZE) {
+		if ((pg = mem_get_page (sim->mem, addr)) == NULL) {
+			continue;
+		}
+
+		if ((pg->rd != NULL) && mem_blk_get_readonly (pg->blk)) {
+			e68_set_icache_rom (sim->cpu, addr, MEM_PAGE_SIZE, 1);
+		}
+	}
+}
+
 static
 void st_setup_cpu (atari_st_t *sim, ini_sct_t *ini)
 {
 	ini_sct_t  *sct;
 	const char *model;
 	unsigned   speed;
+	int        jit, history;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
 	ini_get_string (sct, "model", &model, "68000");
 	ini_get_uint16 (sct, "speed", &speed, 0);
+	ini_get_bool (sct, "jit", &jit, 0);
+	ini_get_bool (sct, "history", &history, 1);
 
-	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d\n", model, speed);
+	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d jit=%d history=%d\n",
+		model, speed, jit, history
+	);
 
 	if ((sim->cpu = e68_new()) == NULL) {
 		return;
@@ -346,13 +529,58 @@ void st_setup_cpu (atari_st_t *sim, ini_sct_t *ini)
 		&mem_set_uint32_be
 	);
 
+	if (sim->ram != NULL) {
+		e68_set_ram (sim->cpu,
+			mem_blk_get_data (sim->ram),
+			mem_blk_get_size (sim->ram)
+		);
+	}
+
 	e68_set_inta_fct (sim->cpu, sim, st_inta);
 
 	e68_set_flags (sim->cpu, E68_FLAG_NORESET, 1);
 
+	e68_set_pc_history (sim->cpu, history);
+
+	if (jit) {
+		if (e68_set_jit (sim->cpu, 1)) {
+			pce_log (MSG_ERR, "*** dynamic translation is not available\n");
+		}
+		else {
+			st_setup_icache_rom (sim);
+		}
+	}
+
 	sim->speed_factor = speed;
 }
 
+static
+void st_setup_idle (atari_st_t *sim, ini_sct_t *ini)
+{
+	ini_sct_t     *sct;
+	unsigned long addr, size;
+
+	if (sim->cpu == NULL) {
+		return;
+	}
+
+	sct = NULL;
+
+	while ((sct = ini_next_sct (ini, sct, "idle_range")) != NULL) {
+		ini_get_uint32 (sct, "address", &addr, 0);
+		ini_get_uint32 (sct, "size", &size, 0);
+
+		pce_log_tag (MSG_INF, "IDLE:", "addr=0x%06lx size=%lu\n",
+			addr, size
+		);
+
+		if (e68_add_idle_range (sim->cpu, addr, size)) {
+			pce_log (MSG_ERR, "*** too many idle ranges\n");
+			break;
+		}
+	}
+}
+
 static
 void st_setup_midi (atari_st_t *sim, ini_sct_t *ini)
 {
@@ -404,9 +632,9 @@ void st_setup_mfp (atari_st_t *sim, ini_sct_t *ini)
 		return;
 	}
 
-	mem_blk_set_fct (blk, &sim->mfp,
-		e68901_get_uint8, e68901_get_uint16, e68901_get_uint32,
-		e68901_set_uint8, e68901_set_uint16, e68901_set_uint32
+	mem_blk_set_fct (blk, sim,
+		st_mfp_get_uint8, st_mfp_get_uint16, st_mfp_get_uint32,
+		st_mfp_set_uint8, st_mfp_set_uint16, st_mfp_set_uint32
 	);
 
 	mem_add_blk (sim->mem, blk, 1);
@@ -529,6 +757,7 @@ void st_setup_dma (atari_st_t *sim, ini_sct_t *ini)
 
 	st_dma_init (&sim->dma);
 	st_dma_set_memory (&sim->dma, sim->mem);
+	st_dma_set_cpu (&sim->dma, sim->cpu);
 	st_dma_set_fdc (&sim->dma, &sim->fdc.wd179x);
 	st_dma_set_acsi (&sim->dma, &sim->acsi);
 }
@@ -580,6 +809,11 @@ void st_setup_video (atari_st_t *sim, ini_sct_t *ini)
 		st_video_set_terminal (sim->video, sim->trm);
 	}
 
+	mem_blk_set_fct (&sim->video->reg, sim,
+		st_video_reg_get_uint8, st_video_reg_get_uint16, st_video_reg_get_uint32,
+		st_video_reg_set_uint8, st_video_reg_set_uint16, st_video_reg_set_uint32
+	);
+
 	mem_add_blk (sim->mem, &sim->video->reg, 0);
 }
 
@@ -601,12 +835,21 @@ void st_init (atari_st_t *sim, ini_sct_t *ini)
 	sim->speed_factor = 1;
 	sim->speed_clock_extra = 0;
 
+	sim->idle_enable = 1;
+	sim->idle_clk = 0;
+
 	sim->clk_cnt = 0;
 
 	for (i = 0; i < 4; i++) {
 		sim->clk_div[i] = 0;
 	}
 
+	sim->slice_clk = 0;
+	sim->slice_cpu = 0;
+	sim->slice_cpu_done = 0;
+	sim->slice_n = 0;
+	sim->slice_n_done = 0;
+
 	sim->ser_buf_i = 0;
 	sim->ser_buf_n = 0;
 
@@ -615,6 +858,7 @@ void st_init (atari_st_t *sim, ini_sct_t *ini)
 	st_setup_system (sim, ini);
 	st_setup_mem (sim, ini);
 	st_setup_cpu (sim, ini);
+	st_setup_idle (sim, ini);
 	st_setup_midi (sim, ini);
 	st_setup_mfp (sim, ini);
 	st_setup_acia (sim, ini);
@@ -784,6 +1028,9 @@ void st_reset (atari_st_t *sim)
 		mem_set_uint32_be (sim->mem, 0x04ba, 16000);
 	}
 
+	/* memory has been modified behind the CPU's back */
+	e68_icache_flush (sim->cpu);
+
 	st_clock_discontinuity (sim);
 
 	sim->reset = 0;
@@ -805,7 +1052,8 @@ void st_realtime_sync (atari_st_t *sim, unsigned long n)
 		if (us1 < us2) {
 			sim->sync_sleep += us2 - us1;
 
-			if (sim->sync_sleep > 0) {
+			/* don't speed up the CPU to make up for idle time */
+			if ((sim->sync_sleep > 0) && (sim->idle_clk == 0)) {
 				sim->speed_clock_extra += 1;
 			}
 		}
@@ -827,27 +1075,134 @@ void st_realtime_sync (atari_st_t *sim, unsigned long n)
 			st_log_deb ("system too slow, skipping 1 second\n");
 			sim->sync_sleep += 1000000;
 		}
+
+		sim->idle_clk = 0;
 	}
 }
 
-void st_clock (atari_st_t *sim, unsigned n)
+static
+unsigned long st_get_acia_delay (const e6850_t *acia)
 {
-	unsigned long clk, cpuclk;
+	unsigned long n;
 
-	if (n == 0) {
-		n = 16;
+	n = 0x10000000UL;
+
+	if ((acia->recv_timer > 0) && (acia->recv_timer < n)) {
+		n = acia->recv_timer;
 	}
 
-	if (sim->speed_factor == 0) {
-		cpuclk = n + sim->speed_clock_extra;
+	if ((acia->send_timer > 0) && (acia->send_timer < n)) {
+		n = acia->send_timer;
 	}
-	else {
-		cpuclk = sim->speed_factor * n;
+
+	return (16 * n);
+}
+
+/*
+ * Get the number of clocks until the next device event, but at most
+ * max: the next horizontal blanking change, the next MFP timer
+ * interrupt, the ACIA timers and the floppy disk controller. The MFP,
+ * the ACIAs and the FDC are clocked in multiples of 16 clocks.
+ */
+static
+unsigned long st_get_delay (atari_st_t *sim, unsigned long max)
+{
+	unsigned long n, tmp;
+	const wd179x_t *fdc;
+
+	n = max;
+
+	tmp = st_video_get_delay (sim->video);
+
+	if (tmp < n) {
+		n = tmp;
 	}
 
-	sim->clk_cnt += n;
+	tmp = (e68901_get_delay (&sim->mfp) + 3) / 4;
+	tmp = ((tmp + 15) & ~15UL) - sim->clk_div[0];
 
-	e68_clock (sim->cpu, cpuclk);
+	if (tmp < n) {
+		n = tmp;
+	}
+
+	tmp = st_get_acia_delay (&sim->acia0) - sim->clk_div[0];
+
+	if (tmp < n) {
+		n = tmp;
+	}
+
+	tmp = st_get_acia_delay (&sim->acia1) - sim->clk_div[0];
+
+	if (tmp < n) {
+		n = tmp;
+	}
+
+	fdc = &sim->fdc.wd179x;
+
+	if (fdc->clock != NULL) {
+		/* a data transfer is clocked every 16 clocks */
+		tmp = 16 - sim->clk_div[0];
+
+		if (tmp < n) {
+			n = tmp;
+		}
+	}
+	else if (fdc->cont != NULL) {
+		tmp = (fdc->delay > 16) ? ((fdc->delay + 15) & ~15UL) : 16;
+		tmp -= sim->clk_div[0];
+
+		if (tmp < n) {
+			n = tmp;
+		}
+	}
+
+	return (n);
+}
+
+/*
+ * Get the number of clocks that can be skipped while the CPU is idle
+ * or 0 if the floppy disk controller is busy. This is limited by the
+ * next device event and the next terminal check.
+ */
+static
+unsigned long st_get_idle_clk (atari_st_t *sim)
+{
+	unsigned long pend;
+
+	if ((sim->fdc.wd179x.clock != NULL) || (sim->fdc.wd179x.cont != NULL)) {
+		return (0);
+	}
+
+	pend = sim->clk_div[0] + sim->clk_div[1] + sim->clk_div[2];
+
+	return (st_get_delay (sim, (pend < 8192) ? (8192 - pend) : 1));
+}
+
+/*
+ * Get the number of clocks in the next CPU time slice. A slice ends at
+ * the next device event or when the serial port is checked every 256
+ * clocks.
+ */
+static
+unsigned long st_get_slice (atari_st_t *sim)
+{
+	unsigned long n;
+
+	n = sim->clk_div[0] + sim->clk_div[1];
+	n = (n < 256) ? (256 - n) : (16 - sim->clk_div[0]);
+
+	return (st_get_delay (sim, n));
+}
+
+/*
+ * Clock the devices that are clocked with the CPU
+ */
+static
+void st_clock_dev (atari_st_t *sim, unsigned long n)
+{
+	unsigned long clk;
+
+	sim->clk_cnt += n;
 
 	st_video_clock (sim->video, n);
 
@@ -868,7 +1223,14 @@ void st_clock (atari_st_t *sim, unsigned n)
 	e6850_clock (&sim->acia1, clk >> 4);
 
 	e68901_clock (&sim->mfp, clk << 2);
+}
 
+/*
+ * Clock the devices that are clocked every 256 and every 8192 clocks
+ */
+static
+void st_clock_slow (atari_st_t *sim)
+{
 	if (sim->clk_div[1] < 256) {
 		return;
 	}
@@ -913,3 +1275,113 @@ void st_clock (atari_st_t *sim, unsigned n)
 
 	sim->clk_div[2] -= 8192;
 }
+
+void st_clock_sync (atari_st_t *sim)
+{
+	unsigned long cpuclk, n;
+
+	if (sim->slice_cpu == 0) {
+		return;
+	}
+
+	cpuclk = e68_get_clkcnt (sim->cpu) - sim->slice_clk;
+
+	if (cpuclk > sim->slice_cpu) {
+		cpuclk = sim->slice_cpu;
+	}
+
+	if (cpuclk <= sim->slice_cpu_done) {
+		return;
+	}
+
+	n = ((unsigned long long) cpuclk * sim->slice_n) / sim->slice_cpu;
+
+	st_clock_dev (sim, n - sim->slice_n_done);
+
+	sim->slice_cpu_done = cpuclk;
+	sim->slice_n_done = n;
+}
+
+/*
+ * Run the CPU for up to n clocks and return the number of clocks that
+ * were run. The slice ends early if the CPU writes to a device that
+ * can change the time of the next event. The devices catch up when the
+ * CPU accesses them and at the end of the slice.
+ */
+static
+unsigned long st_clock_cpu (atari_st_t *sim, unsigned long n)
+{
+	unsigned long cpuclk;
+
+	if (sim->speed_factor == 0) {
+		/* speed_clock_extra is in CPU clocks per 16 clocks */
+		cpuclk = n + ((n * sim->speed_clock_extra) >> 4);
+	}
+	else {
+		cpuclk = sim->speed_factor * n;
+	}
+
+	sim->slice_clk = e68_get_clkcnt (sim->cpu);
+	sim->slice_cpu = cpuclk;
+	sim->slice_cpu_done = 0;
+	sim->slice_n = n;
+	sim->slice_n_done = 0;
+
+	e68_clock (sim->cpu, cpuclk);
+
+	st_clock_sync (sim);
+
+	n = sim->slice_n_done;
+
+	sim->slice_cpu = 0;
+
+	st_clock_slow (sim);
+
+	return (n);
+}
+
+static
+void st_clock_idle (atari_st_t *sim, unsigned long n)
+{
+	if (sim->speed_factor == 0) {
+		e68_skip (sim->cpu, n);
+	}
+	else {
+		e68_skip (sim->cpu, sim->speed_factor * n);
+	}
+
+	sim->idle_clk += n;
+
+	st_clock_dev (sim, n);
+	st_clock_slow (sim);
+}
+
+void st_clock (atari_st_t *sim, unsigned n)
+{
+	unsigned long m;
+
+	if (n == 0) {
+		if (sim->idle_enable && e68_get_idle (sim->cpu)) {
+			m = st_get_idle_clk (sim);
+
+			if (m > 0) {
+				st_clock_idle (sim, m);
+				return;
+			}
+		}
+
+		st_clock_cpu (sim, st_get_slice (sim));
+
+		return;
+	}
+
+	while (n > 0) {
+		m = st_get_slice (sim);
+
+		if (m > n) {
+			m = n;
+		}
+
+		n -= st_clock_cpu (sim, m);
+	}
+}
@@ -100,6 +100,12 @@ struct atari_st_s {
 	unsigned      speed_factor;
 	unsigned long speed_clock_extra;
 
+	/* skip ahead in time while the guest is idle */
+	int           idle_enable;
+
+	/* the number of clocks skipped since the last sync */
+	unsigned long idle_clk;
+
 	unsigned long sync_clk;
 	unsigned long sync_us;
 	long          sync_sleep;
@@ -107,6 +113,18 @@ struct atari_st_s {
 	unsigned long clk_cnt;
 	unsigned long clk_div[4];
 
+	/*
+	 * The current CPU time slice. The devices that are clocked with
+	 * st_clock() have been clocked for slice_cpu_done of the slice_cpu
+	 * CPU clocks that started at CPU clock slice_clk. slice_cpu is 0
+	 * outside of a slice.
+	 */
+	unsigned long slice_clk;
+	unsigned long slice_cpu;
+	unsigned long slice_cpu_done;
+	unsigned long slice_n;
+	unsigned long slice_n_done;
+
 	unsigned      ser_buf_i;
 	unsigned      ser_buf_n;
 	unsigned char ser_buf[128];
@@ -156,14 +174,25 @@ int st_set_msg_trm (atari_st_t *sim, const char *msg, const char *val);
 
 int st_set_cpu_model (atari_st_t *sim, const char *model);
 
+void st_setup_icache_rom (atari_st_t *sim);
+
 /*****************************************************************************
  * @short Reset the simulation
  *****************************************************************************/
 void st_reset (atari_st_t *sim);
 
+/*****************************************************************************
+ * @short Bring the devices up to date with the CPU
+ *
+ * This must be called before a device is accessed by the CPU while
+ * it is running a time slice.
+ *****************************************************************************/
+void st_clock_sync (atari_st_t *sim);
+
 /*****************************************************************************
  * @short Clock the simulator
- * @param n The number of clock cycles.
+ * @param n The number of clock cycles. If n is 0, the simulator runs
+ *          until the next device event.
  *****************************************************************************/
 void st_clock (atari_st_t *sim, unsigned n);
 
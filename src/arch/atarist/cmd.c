@@ -40,6 +40,7 @@
 
 
 mon_cmd_t par_cmd[] = {
+	{ "bench", "[cnt]", "compare the interpreter and translator speed" },
 	{ "c", "[cnt]", "clock" },
 	{ "gb", "[addr..]", "run with breakpoints at addr" },
 	{ "ge", "[exception]", "run until exception" },
@@ -456,6 +457,8 @@ void st_run (atari_st_t *sim)
 
 	st_clock_discontinuity (sim);
 
+	sim->cpu->jit_disable = 0;
+
 	while (1) {
 		st_clock (par_sim, 0);
 		st_clock (par_sim, 0);
@@ -516,10 +519,12 @@ void st_run_emscripten_step ()
 {
 	// for each 'emscripten step' we'll run a bunch of actual cycles
 	// to minimise overhead from emscripten's main loop management
-	int i;
-	for (i = 0; i < 10000; ++i)
-	{	
-		st_clock (atari_st_sim, 0);
+	unsigned long clk;
+
+	clk = atari_st_sim->clk_cnt;
+
+	while ((atari_st_sim->clk_cnt - clk) < 320000)
+	{
 		st_clock (atari_st_sim, 0);
 
 		if (atari_st_sim->brk) {
@@ -653,6 +658,96 @@ void st_log_exception (void *ext, unsigned tn)
 }
 
 
+static
+double st_cmd_bench_run (atari_st_t *sim, unsigned long cnt)
+{
+	unsigned long us, tmp;
+	unsigned long start, end;
+
+	start = e68_get_opcnt (sim->cpu);
+	end = start + cnt;
+
+	pce_get_interval_us (&tmp);
+
+	while (e68_get_opcnt (sim->cpu) < end) {
+		st_clock (sim, 0);
+
+		if (sim->brk) {
+			break;
+		}
+	}
+
+	us = pce_get_interval_us (&tmp);
+
+	if (us == 0) {
+		us = 1;
+	}
+
+	return ((double) (e68_get_opcnt (sim->cpu) - start) / (double) us);
+}
+
+/*
+ * bench - compare the interpreter and translator speed
+ */
+static
+void st_cmd_bench (cmd_t *cmd, atari_st_t *sim)
+{
+	unsigned long cnt;
+	int           have_ic, have_jit;
+	double        mips;
+	e68000_t      *c;
+
+	cnt = 10000000;
+
+	cmd_match_uint32 (cmd, &cnt);
+
+	if (!cmd_match_end (cmd)) {
+		return;
+	}
+
+	c = sim->cpu;
+
+	have_ic = (c->ic != NULL);
+	have_jit = (c->jit != NULL);
+
+	pce_start (&sim->brk);
+
+	st_clock_discontinuity (sim);
+
+	c->jit_disable = 1;
+
+	mips = st_cmd_bench_run (sim, cnt);
+
+	pce_printf ("interpreter: %8.2f MIPS\n", mips);
+
+	if ((sim->brk == 0) && (e68_set_jit (c, 1) == 0)) {
+		if (have_ic == 0) {
+			st_setup_icache_rom (sim);
+		}
+
+		c->jit_disable = 0;
+
+		mips = st_cmd_bench_run (sim, cnt);
+
+		c->jit_disable = 1;
+
+		pce_printf ("translator:  %8.2f MIPS\n", mips);
+	}
+	else {
+		pce_printf ("translator:  not available\n");
+	}
+
+	if (have_jit == 0) {
+		e68_set_jit (c, 0);
+	}
+
+	if (have_ic == 0) {
+		e68_set_icache (c, 0);
+	}
+
+	pce_stop();
+}
+
 /*
  * c - clock
  */
@@ -1207,7 +1302,16 @@ int st_cmd (atari_st_t *sim, cmd_t *cmd)
 		trm_check (sim->trm);
 	}
 
-	if (cmd_match (cmd, "b")) {
+	/* memory may have been modified by a previous monitor command */
+	e68_icache_flush (sim->cpu);
+
+	/* translated blocks would step over breakpoints */
+	sim->cpu->jit_disable = 1;
+
+	if (cmd_match (cmd, "bench")) {
+		st_cmd_bench (cmd, sim);
+	}
+	else if (cmd_match (cmd, "b")) {
 		cmd_do_b (cmd, &sim->bps);
 	}
 	else if (cmd_match (cmd, "c")) {
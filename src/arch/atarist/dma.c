@@ -25,6 +25,7 @@
 #include "dma.h"
 
 #include <chipset/wd179x.h>
+#include <cpu/e68000/e68000.h>
 #include <devices/memory.h>
 
 #ifndef DEBUG_DMA
@@ -41,6 +42,7 @@ int st_dma_init (st_dma_t *dma)
 	dma->fifo_idx = 0;
 
 	dma->mem = NULL;
+	dma->cpu = NULL;
 	dma->fdc = NULL;
 	dma->acsi = NULL;
 
@@ -52,6 +54,11 @@ void st_dma_set_memory (st_dma_t *dma, memory_t *mem)
 	dma->mem = mem;
 }
 
+void st_dma_set_cpu (st_dma_t *dma, e68000_t *cpu)
+{
+	dma->cpu = cpu;
+}
+
 void st_dma_set_fdc (st_dma_t *dma, wd179x_t *fdc)
 {
 	dma->fdc = fdc;
@@ -107,6 +114,11 @@ void st_dma_dreq_read (st_dma_t *dma)
 			dma->addr += 1;
 		}
 
+		/* the memory was modified behind the CPU's back */
+		if (dma->cpu != NULL) {
+			e68_icache_invalidate (dma->cpu, dma->addr - 16, 16);
+		}
+
 		dma->fifo_idx = (dma->fifo_idx + 1) & 1;
 		dma->fifo[dma->fifo_idx].idx = 0;
 		dma->fifo[dma->fifo_idx].cnt = 0;
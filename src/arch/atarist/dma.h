@@ -27,6 +27,7 @@
 #include "acsi.h"
 
 #include <chipset/wd179x.h>
+#include <cpu/e68000/e68000.h>
 #include <devices/memory.h>
 
 
@@ -50,6 +51,7 @@ typedef struct {
 	st_dma_fifo_t  fifo[2];
 
 	memory_t       *mem;
+	e68000_t       *cpu;
 	wd179x_t       *fdc;
 	st_acsi_t      *acsi;
 } st_dma_t;
@@ -58,6 +60,7 @@ typedef struct {
 int st_dma_init (st_dma_t *dma);
 
 void st_dma_set_memory (st_dma_t *dma, memory_t *mem);
+void st_dma_set_cpu (st_dma_t *dma, e68000_t *cpu);
 void st_dma_set_fdc (st_dma_t *dma, wd179x_t *fdc);
 void st_dma_set_acsi (st_dma_t *dma, st_acsi_t *acsi);
 
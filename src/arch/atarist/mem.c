@@ -38,6 +38,8 @@ unsigned char st_mem_get_uint8 (void *ext, unsigned long addr)
 		return (0);
 	}
 
+	st_clock_sync (sim);
+
 	if ((addr >= 0xfffc20) && (addr < 0xfffc40)) {
 		return (rp5c15_get_uint8 (&sim->rtc, (addr - 0xfffc20) / 2));
 	}
@@ -111,6 +113,8 @@ unsigned short st_mem_get_uint16 (void *ext, unsigned long addr)
 		return (0);
 	}
 
+	st_clock_sync (sim);
+
 	switch (addr) {
 	case 0xff8900: /* DMA sound */
 	case 0xff8a00: /* blitter */
@@ -160,6 +164,8 @@ void st_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 		return;
 	}
 
+	st_clock_sync (sim);
+
 	if ((addr >= 0xfffc20) && (addr < 0xfffc40)) {
 		rp5c15_set_uint8 (&sim->rtc, (addr - 0xfffc20) / 2, val);
 		return;
@@ -204,18 +210,22 @@ void st_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 
 	case 0xfffc00:
 		e6850_set_uint8 (&sim->acia0, 0, val);
+		e68_clock_break (sim->cpu);
 		break;
 
 	case 0xfffc02:
 		e6850_set_uint8 (&sim->acia0, 1, val);
+		e68_clock_break (sim->cpu);
 		break;
 
 	case 0xfffc04:
 		e6850_set_uint8 (&sim->acia1, 0, val);
+		e68_clock_break (sim->cpu);
 		break;
 
 	case 0xfffc06:
 		e6850_set_uint8 (&sim->acia1, 1, val);
+		e68_clock_break (sim->cpu);
 		break;
 
 	default:
@@ -232,6 +242,8 @@ void st_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 		return;
 	}
 
+	st_clock_sync (sim);
+
 	switch (addr) {
 	case 0xff8800:
 		st_psg_set_select (&sim->psg, val >> 8);
@@ -249,6 +261,7 @@ void st_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 
 	case 0xff8604:
 		st_dma_set_disk (&sim->dma, val);
+		e68_clock_break (sim->cpu);
 		break;
 
 	case 0xff8606:
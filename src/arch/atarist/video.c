@@ -33,14 +33,6 @@
 #endif
 
 
-static unsigned char st_video_get_uint8 (st_video_t *vid, unsigned long addr);
-static unsigned short st_video_get_uint16 (st_video_t *vid, unsigned long addr);
-static unsigned long st_video_get_uint32 (st_video_t *vid, unsigned long addr);
-static void st_video_set_uint8 (st_video_t *vid, unsigned long addr, unsigned char val);
-static void st_video_set_uint16 (st_video_t *vid, unsigned long addr, unsigned short val);
-static void st_video_set_uint32 (st_video_t *vid, unsigned long addr, unsigned long val);
-
-
 int st_video_init (st_video_t *vid, unsigned long addr, int mono)
 {
 	vid->mem = NULL;
@@ -269,7 +261,6 @@ void st_video_set_palette (st_video_t *vid, unsigned idx, unsigned short val)
 	}
 }
 
-static
 unsigned char st_video_get_uint8 (st_video_t *vid, unsigned long addr)
 {
 	unsigned char val;
@@ -322,7 +313,6 @@ unsigned char st_video_get_uint8 (st_video_t *vid, unsigned long addr)
 	return (val);
 }
 
-static
 unsigned short st_video_get_uint16 (st_video_t *vid, unsigned long addr)
 {
 	unsigned short val;
@@ -338,7 +328,6 @@ unsigned short st_video_get_uint16 (st_video_t *vid, unsigned long addr)
 	return (val);
 }
 
-static
 unsigned long st_video_get_uint32 (st_video_t *vid, unsigned long addr)
 {
 	unsigned long val;
@@ -355,7 +344,6 @@ unsigned long st_video_get_uint32 (st_video_t *vid, unsigned long addr)
 	return (val);
 }
 
-static
 void st_video_set_uint8 (st_video_t *vid, unsigned long addr, unsigned char val)
 {
 	switch (addr) {
@@ -385,7 +373,6 @@ void st_video_set_uint8 (st_video_t *vid, unsigned long addr, unsigned char val)
 	}
 }
 
-static
 void st_video_set_uint16 (st_video_t *vid, unsigned long addr, unsigned short val)
 {
 	if ((addr >= 0x0040) && (addr < 0x0060)) {
@@ -396,7 +383,6 @@ void st_video_set_uint16 (st_video_t *vid, unsigned long addr, unsigned short va
 	}
 }
 
-static
 void st_video_set_uint32 (st_video_t *vid, unsigned long addr, unsigned long val)
 {
 	if (addr == 0) {
@@ -608,6 +594,19 @@ void st_video_update_terminal (st_video_t *vid)
 	trm_update (vid->trm);
 }
 
+unsigned long st_video_get_delay (const st_video_t *vid)
+{
+	if (vid->clk < vid->hb1) {
+		return (vid->hb1 - vid->clk);
+	}
+
+	if (vid->clk < vid->hb2) {
+		return (vid->hb2 - vid->clk);
+	}
+
+	return (1);
+}
+
 void st_video_clock (st_video_t *vid, unsigned cnt)
 {
 	vid->clk += cnt;
@@ -91,10 +91,23 @@ void st_video_set_terminal (st_video_t *vid, terminal_t *trm);
 
 void st_video_set_frame_skip (st_video_t *vid, unsigned skip);
 
+unsigned char st_video_get_uint8 (st_video_t *vid, unsigned long addr);
+unsigned short st_video_get_uint16 (st_video_t *vid, unsigned long addr);
+unsigned long st_video_get_uint32 (st_video_t *vid, unsigned long addr);
+void st_video_set_uint8 (st_video_t *vid, unsigned long addr, unsigned char val);
+void st_video_set_uint16 (st_video_t *vid, unsigned long addr, unsigned short val);
+void st_video_set_uint32 (st_video_t *vid, unsigned long addr, unsigned long val);
+
 void st_video_redraw (st_video_t *vid);
 
 void st_video_reset (st_video_t *vid);
 
+/*
+ * Get the number of clocks until the next horizontal blanking change.
+ * st_video_clock() must not be called with more clocks than this.
+ */
+unsigned long st_video_get_delay (const st_video_t *vid);
+
 void st_video_clock (st_video_t *vid, unsigned cnt);
 
 
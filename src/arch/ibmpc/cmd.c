@@ -25,6 +25,7 @@
 #include "cmd.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <lib/brkpt.h>
@@ -38,6 +39,7 @@
 
 
 static mon_cmd_t par_cmd[] = {
+	{ "bench", "[cnt]", "compare the interpreter and threaded code speed [10000000]" },
 	{ "boot", "[drive]", "set the boot drive" },
 	{ "c", "[cnt]", "clock [1]" },
 	{ "gb", "[addr...]", "run with breakpoints" },
@@ -50,6 +52,11 @@ static mon_cmd_t par_cmd[] = {
 	{ "log", "int n [expr]", "set interrupt n log expression to expr" },
 	{ "o", "[b|w] port val", "output a byte or word to a port" },
 	{ "pq", "[c|f|s]", "prefetch queue clear/fill/status" },
+	{ "prof", "on [period]", "start profiling, sample CS:IP every period instructions [1]" },
+	{ "prof", "off", "stop profiling" },
+	{ "prof", "c", "clear the profile" },
+	{ "prof", "[s [cnt]]", "print the cnt hottest opcodes and addresses [20]" },
+	{ "prof", "w fname [cg]", "write the profile as text or in callgrind format" },
 	{ "p", "[cnt]", "execute cnt instructions, without trace in calls [1]" },
 	{ "r", "[reg val]", "set a register" },
 	{ "s", "[what]", "print status (pc|cpu|mem|pit|ppi|pic|time|uart|video|xms)" },
@@ -410,7 +417,7 @@ void prt_state_cpu (e8086_t *c)
 
 	pce_printf ("CS=%04X  DS=%04X  ES=%04X  SS=%04X  IP=%04X  F =%04X",
 		e86_get_cs (c), e86_get_ds (c), e86_get_es (c), e86_get_ss (c),
-		e86_get_ip (c), c->flg
+		e86_get_ip (c), e86_get_flags (c)
 	);
 
 	pce_printf ("  I%c D%c O%c S%c Z%c A%c P%c C%c\n",
@@ -512,9 +519,11 @@ void pc_run (ibmpc_t *pc)
 
 	pc_clock_discontinuity (pc);
 
+	pc->cpu->jit_disable = 0;
+
 	while (pc->brk == 0) {
 		if (pc->pause == 0) {
-			pc_clock (pc, 4 * pc->speed_current);
+			pc_clock (pc, 0);
 		}
 		else {
 			pce_usleep (100000);
@@ -572,7 +581,7 @@ void pc_run_emscripten_step ()
 	int i;
 	for (i = 0; i < 10000; ++i)
 	{
-		pc_clock (ibmpc_sim, 4 * ibmpc_sim->speed_current);
+		pc_clock (ibmpc_sim, 0);
 
 		if (ibmpc_sim->brk) {
 			pce_stop();
@@ -589,7 +598,6 @@ void pc_run_emscripten_step ()
 
 
 
-#if 0
 static
 void pce_op_stat (void *ext, unsigned char op1, unsigned char op2)
 {
@@ -597,8 +605,8 @@ void pce_op_stat (void *ext, unsigned char op1, unsigned char op2)
 
 	pc = (ibmpc_t *) ext;
 
+	pc_prof_insn (&pc->prof, pc->cpu, op1, op2);
 }
-#endif
 
 static
 void pce_op_int (void *ext, unsigned char n)
@@ -610,6 +618,8 @@ void pce_op_int (void *ext, unsigned char n)
 
 	pc->current_int = n | 0x100;
 
+	pc_idle_int (pc, n);
+
 	if (pc_intlog_check (pc, n)) {
 		pce_printf ("%04X:%04X: int %02X"
 			" [AX=%04X BX=%04X CX=%04X DX=%04X DS=%04X ES=%04X]\n",
@@ -680,6 +690,289 @@ void pce_op_undef (void *ext, unsigned char op1, unsigned char op2)
 }
 
 
+typedef struct {
+	e8086_t       cpu;
+	ibmpc_t       pc;
+	e8250_t       uart[4];
+	unsigned long dotclk[3];
+	unsigned char *ram;
+	unsigned char *vmem;
+} pc_bench_t;
+
+
+/*
+ * Save the CPU, the ram and the state of the devices the guest can
+ * observe for pc_cmd_bench_restore()
+ */
+static
+int pc_cmd_bench_save (ibmpc_t *pc, pc_bench_t *sav)
+{
+	unsigned  i;
+	mem_blk_t *blk;
+
+	sav->cpu = *pc->cpu;
+	sav->pc = *pc;
+
+	sav->ram = malloc (pc->cpu->ram_cnt + 1);
+
+	if (sav->ram == NULL) {
+		return (1);
+	}
+
+	if (pc->cpu->ram_cnt > 0) {
+		memcpy (sav->ram, pc->cpu->ram, pc->cpu->ram_cnt);
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (pc->serport[i] != NULL) {
+			sav->uart[i] = pc->serport[i]->uart;
+		}
+	}
+
+	sav->vmem = NULL;
+
+	if (pc->video != NULL) {
+		for (i = 0; i < 3; i++) {
+			sav->dotclk[i] = pc->video->dotclk[i];
+		}
+
+		blk = pce_video_get_mem (pc->video);
+
+		if ((blk != NULL) && (blk->size > 0)) {
+			sav->vmem = malloc (blk->size);
+
+			if (sav->vmem == NULL) {
+				free (sav->ram);
+				return (1);
+			}
+
+			memcpy (sav->vmem, blk->data, blk->size);
+		}
+	}
+
+	return (0);
+}
+
+static
+void pc_cmd_bench_free (pc_bench_t *sav)
+{
+	free (sav->vmem);
+	free (sav->ram);
+}
+
+/*
+ * Restore the state saved by pc_cmd_bench_save(), so that every
+ * benchmark run starts from the same CPU, ram and device state and
+ * executes the same guest code. The disk controllers and the host
+ * side of the speaker and the serial ports are not restored.
+ */
+static
+void pc_cmd_bench_restore (ibmpc_t *pc, const pc_bench_t *sav)
+{
+	unsigned long i, n;
+	e8086_t       *c;
+	const e8086_t *cpu;
+	const ibmpc_t *spc;
+	mem_blk_t     *blk;
+
+	c = pc->cpu;
+	cpu = &sav->cpu;
+
+	memcpy (c->dreg, cpu->dreg, sizeof (c->dreg));
+	memcpy (c->sreg, cpu->sreg, sizeof (c->sreg));
+
+	c->ip = cpu->ip;
+	c->flg = cpu->flg;
+	c->lflg = cpu->lflg;
+	c->cur_ip = cpu->cur_ip;
+
+	c->pq = c->pq_buf;
+	c->pq_fill = cpu->pq_fill;
+	c->pq_cnt = (c->ic != NULL) ? 0 : cpu->pq_cnt;
+	memcpy (c->pq_buf, cpu->pq_buf, sizeof (c->pq_buf));
+
+	c->prefix = cpu->prefix;
+	c->seg_override = cpu->seg_override;
+	c->halt = cpu->halt;
+	c->enable_int = cpu->enable_int;
+	c->delay = cpu->delay;
+	c->clocks = cpu->clocks;
+
+	/* only invalidate threaded code in the parts that changed */
+	for (i = 0; i < c->ram_cnt; i += n) {
+		n = ((c->ram_cnt - i) < 4096) ? (c->ram_cnt - i) : 4096;
+
+		if (memcmp (c->ram + i, sav->ram + i, n) != 0) {
+			memcpy (c->ram + i, sav->ram + i, n);
+			e86_icache_invalidate (c, i, n);
+		}
+	}
+
+	spc = &sav->pc;
+
+	pc->dma = spc->dma;
+	pc->pit = spc->pit;
+	pc->ppi = spc->ppi;
+	pc->pic = spc->pic;
+	pc->kbd = spc->kbd;
+
+	memcpy (pc->ppi_port_a, spc->ppi_port_a, sizeof (pc->ppi_port_a));
+	pc->ppi_port_b = spc->ppi_port_b;
+	memcpy (pc->ppi_port_c, spc->ppi_port_c, sizeof (pc->ppi_port_c));
+
+	memcpy (pc->dma_page, spc->dma_page, sizeof (pc->dma_page));
+
+	pc->timer1_out = spc->timer1_out;
+	pc->dack0 = spc->dack0;
+	pc->refresh_cnt = spc->refresh_cnt;
+	pc->current_int = spc->current_int;
+
+	memcpy (pc->clk_div, spc->clk_div, sizeof (pc->clk_div));
+
+	pc->clock1 = spc->clock1;
+	pc->clock2 = spc->clock2;
+	pc->clk_sync = spc->clk_sync;
+
+	pc->idle = spc->idle;
+	pc->idle_src = spc->idle_src;
+	pc->idle_val = spc->idle_val;
+	pc->idle_cnt = spc->idle_cnt;
+	pc->idle_clk = spc->idle_clk;
+	pc->idle_kbd = spc->idle_kbd;
+	pc->idle_ticks = spc->idle_ticks;
+
+	for (i = 0; i < 4; i++) {
+		if (pc->serport[i] != NULL) {
+			pc->serport[i]->uart = sav->uart[i];
+		}
+	}
+
+	if (pc->video != NULL) {
+		for (i = 0; i < 3; i++) {
+			pc->video->dotclk[i] = sav->dotclk[i];
+		}
+
+		blk = pce_video_get_mem (pc->video);
+
+		if ((blk != NULL) && (sav->vmem != NULL)) {
+			memcpy (blk->data, sav->vmem, blk->size);
+		}
+	}
+
+	pc_clock_discontinuity (pc);
+}
+
+static
+double pc_cmd_bench_run (ibmpc_t *pc, unsigned long cnt)
+{
+	unsigned long      us, tmp;
+	unsigned long long start, end;
+
+	start = e86_get_opcnt (pc->cpu);
+	end = start + cnt;
+
+	pce_get_interval_us (&tmp);
+
+	while (e86_get_opcnt (pc->cpu) < end) {
+		pc_clock (pc, 0);
+
+		if (pc->brk) {
+			break;
+		}
+	}
+
+	us = pce_get_interval_us (&tmp);
+
+	if (us == 0) {
+		us = 1;
+	}
+
+	return ((double) (e86_get_opcnt (pc->cpu) - start) / (double) us);
+}
+
+/*
+ * Run the same guest code three times: with the interpreter, with
+ * threaded code starting without any blocks and with threaded code
+ * again, reusing the blocks from the second run.
+ */
+static
+void pc_cmd_bench (cmd_t *cmd, ibmpc_t *pc)
+{
+	unsigned long cnt;
+	int           have_ic, have_jit;
+	double        mips;
+	e8086_t       *c;
+	pc_bench_t    sav;
+
+	cnt = 10000000;
+
+	cmd_match_uint32 (cmd, &cnt);
+
+	if (!cmd_match_end (cmd)) {
+		return;
+	}
+
+	c = pc->cpu;
+
+	pc_clock_discontinuity (pc);
+
+	if (pc_cmd_bench_save (pc, &sav)) {
+		pce_printf ("not enough memory\n");
+		return;
+	}
+
+	have_ic = (c->ic != NULL);
+	have_jit = (c->jit != NULL);
+
+	pce_start (&pc->brk);
+
+	c->jit_disable = 1;
+
+	mips = pc_cmd_bench_run (pc, cnt);
+
+	pce_printf ("interpreter:        %8.2f MIPS\n", mips);
+
+	/* start without threaded blocks */
+	e86_set_jit (c, 0);
+
+	if ((pc->brk == 0) && (e86_set_jit (c, 1) == 0)) {
+		c->jit_disable = 0;
+
+		pc_cmd_bench_restore (pc, &sav);
+
+		mips = pc_cmd_bench_run (pc, cnt);
+
+		pce_printf ("threaded (cold):    %8.2f MIPS\n", mips);
+
+		if (pc->brk == 0) {
+			pc_cmd_bench_restore (pc, &sav);
+
+			mips = pc_cmd_bench_run (pc, cnt);
+
+			pce_printf ("threaded (warm):    %8.2f MIPS\n", mips);
+		}
+
+		c->jit_disable = 1;
+	}
+	else {
+		pce_printf ("threaded:           not available\n");
+	}
+
+	if (have_jit == 0) {
+		e86_set_jit (c, 0);
+	}
+
+	if (have_ic == 0) {
+		e86_set_icache (c, 0);
+	}
+
+	pc_cmd_bench_free (&sav);
+
+	pc->current_int &= 0xff;
+
+	pce_stop();
+}
+
 static
 void pc_cmd_boot (cmd_t *cmd, ibmpc_t *pc)
 {
@@ -1095,6 +1388,107 @@ void pc_cmd_pq (cmd_t *cmd, ibmpc_t *pc)
 	}
 }
 
+static
+void pc_cmd_prof_print (cmd_t *cmd, ibmpc_t *pc)
+{
+	unsigned long cnt;
+	FILE          *fp;
+
+	cnt = 0x20;
+
+	cmd_match_uint32 (cmd, &cnt);
+
+	if (!cmd_match_end (cmd)) {
+		return;
+	}
+
+	pc_prof_print (&pc->prof, pc->cpu, pce_get_fp_out(), cnt);
+
+	fp = pce_get_redir_out();
+	if (fp != NULL) {
+		pc_prof_print (&pc->prof, pc->cpu, fp, cnt);
+	}
+}
+
+static
+void pc_cmd_prof_write (cmd_t *cmd, ibmpc_t *pc)
+{
+	int  cg;
+	char fname[256];
+	FILE *fp;
+
+	if (!cmd_match_str (cmd, fname, 256)) {
+		cmd_error (cmd, "need a file name");
+		return;
+	}
+
+	cg = cmd_match (cmd, "cg");
+
+	if (!cmd_match_end (cmd)) {
+		return;
+	}
+
+	fp = fopen (fname, "w");
+
+	if (fp == NULL) {
+		pce_printf ("can't open file (%s)\n", fname);
+		return;
+	}
+
+	if (cg) {
+		pc_prof_print_callgrind (&pc->prof, fp);
+	}
+	else {
+		pc_prof_print (&pc->prof, pc->cpu, fp, 0);
+	}
+
+	fclose (fp);
+}
+
+static
+void pc_cmd_prof (cmd_t *cmd, ibmpc_t *pc)
+{
+	unsigned long period;
+
+	if (cmd_match (cmd, "on")) {
+		period = 1;
+
+		cmd_match_uint32 (cmd, &period);
+
+		if (!cmd_match_end (cmd)) {
+			return;
+		}
+
+		pc_prof_start (&pc->prof, period);
+
+		/* this also disables threaded code and the string fast paths */
+		pc->cpu->op_stat = &pce_op_stat;
+	}
+	else if (cmd_match (cmd, "off")) {
+		if (!cmd_match_end (cmd)) {
+			return;
+		}
+
+		pc_prof_stop (&pc->prof);
+
+		pc->cpu->op_stat = NULL;
+	}
+	else if (cmd_match (cmd, "c")) {
+		if (!cmd_match_end (cmd)) {
+			return;
+		}
+
+		pc_prof_clear (&pc->prof);
+	}
+	else if (cmd_match (cmd, "w")) {
+		pc_cmd_prof_write (cmd, pc);
+	}
+	else {
+		cmd_match (cmd, "s");
+		pc_cmd_prof_print (cmd, pc);
+	}
+}
+
 static
 void pc_cmd_p (cmd_t *cmd, ibmpc_t *pc)
 {
@@ -1356,7 +1750,16 @@ int pc_cmd (ibmpc_t *pc, cmd_t *cmd)
 		trm_check (pc->trm);
 	}
 
-	if (cmd_match (cmd, "boot")) {
+	/* memory may have been modified by a previous monitor command */
+	e86_icache_flush (pc->cpu);
+
+	/* threaded blocks would step over breakpoints */
+	pc->cpu->jit_disable = 1;
+
+	if (cmd_match (cmd, "bench")) {
+		pc_cmd_bench (cmd, pc);
+	}
+	else if (cmd_match (cmd, "boot")) {
 		pc_cmd_boot (cmd, pc);
 	}
 	else if (cmd_match (cmd, "b")) {
@@ -1386,6 +1789,9 @@ int pc_cmd (ibmpc_t *pc, cmd_t *cmd)
 	else if (cmd_match (cmd, "pq")) {
 		pc_cmd_pq (cmd, pc);
 	}
+	else if (cmd_match (cmd, "prof")) {
+		pc_cmd_prof (cmd, pc);
+	}
 	else if (cmd_match (cmd, "p")) {
 		pc_cmd_p (cmd, pc);
 	}
@@ -1415,8 +1821,4 @@ void pc_cmd_init (ibmpc_t *pc, monitor_t *mon)
 
 	pc->cpu->op_int = &pce_op_int;
 	pc->cpu->op_undef = &pce_op_undef;
-#if 0
-	pc->cpu->op_stat = pce_op_stat;
-#endif
-
 }
@@ -74,9 +74,34 @@
 
 #define PCE_IBMPC_SLEEP 25000
 
+/* the maximum number of system clock ticks between device updates */
+#define PCE_IBMPC_CLK_MAX 64
+
+/*
+ * The PIT counters whose output changes are device events. Counter 1
+ * only requests DRAM refresh cycles, these are handed to the DMAC
+ * in bulk.
+ */
+#define PCE_IBMPC_PIT_EVENTS 0x05
+
+/* the number of identical polls before the guest is considered idle */
+#define PCE_IBMPC_IDLE_CNT 16
+
+/* the maximum number of CPU clocks between two identical polls */
+#define PCE_IBMPC_IDLE_CLK 4096
+
+/* skip to the next device update */
+#define PC_IDLE_PORT  1
+/* skip to the next event that can end the idle state */
+#define PC_IDLE_WAIT  2
+
+#define PC_IDLE_SRC_INT16 0x10000UL
+
 
 void pc_e86_hook (void *ext, unsigned char op1, unsigned char op2);
 
+static void pc_clock_sync (ibmpc_t *pc);
+
 
 static char *par_intlog[256];
 
@@ -170,6 +195,7 @@ static
 void pc_dma2_set_mem8 (ibmpc_t *pc, unsigned long addr, unsigned char val)
 {
 	mem_set_uint8 (pc->mem, pc->dma_page[2] + addr, val);
+	e86_icache_invalidate (pc->cpu, pc->dma_page[2] + addr, 1);
 }
 
 static
@@ -182,6 +208,7 @@ static
 void pc_dma3_set_mem8 (ibmpc_t *pc, unsigned long addr, unsigned char val)
 {
 	mem_set_uint8 (pc->mem, pc->dma_page[3] + addr, val);
+	e86_icache_invalidate (pc->cpu, pc->dma_page[3] + addr, 1);
 }
 
 static
@@ -291,7 +318,12 @@ void pc_set_timer1_out (ibmpc_t *pc, unsigned char val)
 {
 	if (pc->dack0 == 0) {
 		if ((pc->timer1_out == 0) && (val != 0)) {
-			e8237_set_dreq0 (&pc->dma, 1);
+			if (e8237_get_state (&pc->dma, 0) & E8237_STATE_DREQ) {
+				pc->refresh_cnt += 1;
+			}
+			else {
+				e8237_set_dreq0 (&pc->dma, 1);
+			}
 		}
 	}
 
@@ -427,10 +459,11 @@ void pc_setup_system (ibmpc_t *pc, ini_sct_t *ini)
 	ini_get_bool (sct, "patch_bios_init", &patch_init, 1);
 	ini_get_bool (sct, "patch_bios_int19", &patch_int19, 1);
 	ini_get_bool (sct, "memtest", &memtest, 1);
+	ini_get_bool (sct, "idle", &pc->idle_enable, 0);
 
 	pce_log_tag (MSG_INF, "SYSTEM:",
-		"model=%s floppies=%u patch-init=%d patch-int19=%d\n",
-		model, fdcnt, patch_init, patch_int19
+		"model=%s floppies=%u patch-init=%d patch-int19=%d idle=%d\n",
+		model, fdcnt, patch_init, patch_int19, pc->idle_enable
 	);
 
 	if (strcmp (model, "5150") == 0) {
@@ -539,20 +572,288 @@ void pc_setup_nvram (ibmpc_t *pc, ini_sct_t *ini)
 	}
 }
 
+static
+void pc_update_mem_map (ibmpc_t *pc)
+{
+	unsigned long addr;
+	mem_page_t    *pg;
+
+	for (addr = 0; addr < (E86_MAP_CNT * E86_MAP_SIZE); addr += MEM_PAGE_SIZE) {
+		if ((pg = mem_get_page (pc->mem, addr)) != NULL) {
+			e86_set_mem_map (pc->cpu, addr, MEM_PAGE_SIZE, pg->rd, pg->wr);
+		}
+	}
+}
+
+static
+void pc_idle_reset (ibmpc_t *pc)
+{
+	pc->idle = 0;
+	pc->idle_cnt = 0;
+}
+
+/*
+ * A port write ends a port poll but not a keyboard poll, because
+ * interrupt handlers write to the PIC.
+ */
+static
+void pc_idle_port_write (ibmpc_t *pc)
+{
+	if (pc->idle_src < PC_IDLE_SRC_INT16) {
+		pc_idle_reset (pc);
+	}
+}
+
+/*
+ * Record a poll. If the same poll returns the same value several times
+ * in a row, the guest is considered idle and the CPU returns to
+ * pc_clock(), which then skips ahead.
+ */
+static
+void pc_idle_poll (ibmpc_t *pc, unsigned type, unsigned long src, unsigned long val)
+{
+	unsigned long long clk;
+
+	clk = e86_get_clock (pc->cpu);
+
+	if ((src != pc->idle_src) || (val != pc->idle_val)) {
+		pc->idle_src = src;
+		pc->idle_val = val;
+		pc->idle_cnt = 0;
+	}
+	else if ((clk - pc->idle_clk) > PCE_IBMPC_IDLE_CLK) {
+		pc->idle_cnt = 0;
+	}
+	else if (pc->idle_cnt < PCE_IBMPC_IDLE_CNT) {
+		pc->idle_cnt += 1;
+	}
+	else {
+		pc->idle = type;
+		e86_clock_break (pc->cpu);
+	}
+
+	pc->idle_clk = clk;
+}
+
+static
+int pc_idle_kbd_empty (ibmpc_t *pc)
+{
+	unsigned short head, tail;
+
+	head = e86_get_mem16 (pc->cpu, 0x0040, 0x001a);
+	tail = e86_get_mem16 (pc->cpu, 0x0040, 0x001c);
+
+	return (head == tail);
+}
+
+void pc_idle_int (ibmpc_t *pc, unsigned n)
+{
+	unsigned ah;
+
+	if ((pc->idle_enable == 0) || (n != 0x16)) {
+		return;
+	}
+
+	if (e86_get_if (pc->cpu) == 0) {
+		/* nothing can end the idle state */
+		return;
+	}
+
+	ah = e86_get_ah (pc->cpu);
+
+	if ((ah == 0x01) || (ah == 0x11)) {
+		/* a keyboard status poll */
+		if (pc_idle_kbd_empty (pc)) {
+			pc_idle_poll (pc, PC_IDLE_WAIT, PC_IDLE_SRC_INT16, ah);
+		}
+		else {
+			pc_idle_reset (pc);
+		}
+	}
+	else if ((ah == 0x00) || (ah == 0x10)) {
+		/* the BIOS waits for a key without calling int 16h again */
+		if (pc_idle_kbd_empty (pc)) {
+			pc->idle_kbd = 1;
+			pc->idle_kbd_ss = e86_get_ss (pc->cpu);
+			pc->idle_kbd_sp = e86_get_sp (pc->cpu);
+			pc->idle_kbd_sp2 = 0;
+		}
+	}
+}
+
+/*
+ * Check if the CPU is in the BIOS loop waiting for a key. The CPU is
+ * considered to be in that loop if it is at about the same place
+ * with the same stack pointer as the last time.
+ */
+static
+int pc_idle_check_kbd (ibmpc_t *pc)
+{
+	unsigned short cs, ip, sp;
+	int            ret;
+
+	cs = e86_get_cs (pc->cpu);
+	ip = e86_get_ip (pc->cpu);
+	sp = e86_get_sp (pc->cpu);
+
+	if (e86_get_ss (pc->cpu) != pc->idle_kbd_ss) {
+		pc->idle_kbd = 0;
+		return (0);
+	}
+
+	if ((sp >= pc->idle_kbd_sp) || (pc_idle_kbd_empty (pc) == 0)) {
+		/* returned from int 16h or a key is available */
+		pc->idle_kbd = 0;
+		return (0);
+	}
+
+	ret = (sp == pc->idle_kbd_sp2) && (cs == pc->idle_kbd_cs);
+	ret = ret && ((unsigned short) (ip - pc->idle_kbd_ip + 16) < 32);
+
+	pc->idle_kbd_cs = cs;
+	pc->idle_kbd_ip = ip;
+	pc->idle_kbd_sp2 = sp;
+
+	return (ret);
+}
+
+/*
+ * Get the number of system clock ticks to skip if the guest is idle
+ */
+static
+unsigned long pc_idle_get_ticks (ibmpc_t *pc)
+{
+	unsigned      type;
+	unsigned long ticks, tmp;
+
+	type = pc->idle;
+
+	pc->idle = 0;
+
+	if (pc->cpu->irq) {
+		/* an interrupt is pending */
+		return (0);
+	}
+
+	if (pc->cpu->halt) {
+		if (e86_get_if (pc->cpu) == 0) {
+			return (0);
+		}
+
+		type = PC_IDLE_WAIT;
+	}
+	else if (pc->idle_kbd && pc_idle_check_kbd (pc)) {
+		type = PC_IDLE_WAIT;
+	}
+
+	if (type == PC_IDLE_PORT) {
+		/* the next update of the devices clocked in pc_clock_ticks() */
+		ticks = 8 - pc->clk_div[0];
+	}
+	else if (type == PC_IDLE_WAIT) {
+		/* the next terminal check and disk update */
+		ticks = 1024 - pc->clk_div[1] - pc->clk_div[0];
+
+		if (pc->kbd.key_i != pc->kbd.key_j) {
+			tmp = pc->kbd.delay + 8;
+
+			if (tmp < ticks) {
+				ticks = tmp;
+			}
+		}
+	}
+	else {
+		return (0);
+	}
+
+	tmp = e8253_get_delay (&pc->pit, PCE_IBMPC_PIT_EVENTS);
+
+	if (tmp < ticks) {
+		ticks = tmp;
+	}
+
+	return (ticks);
+}
+
+/*
+ * The devices are only clocked from time to time. They are brought
+ * up to date before the CPU accesses an I/O port. A port write can
+ * change the time of the next device event, so the CPU returns to
+ * pc_clock() after the current instruction.
+ */
+static
+unsigned char pc_e86_get_port8 (ibmpc_t *pc, unsigned long addr)
+{
+	unsigned char val;
+
+	pc_clock_sync (pc);
+
+	val = mem_get_uint8 (pc->prt, addr);
+
+	if (pc->idle_enable) {
+		pc_idle_poll (pc, PC_IDLE_PORT, addr, val);
+	}
+
+	return (val);
+}
+
+static
+unsigned short pc_e86_get_port16 (ibmpc_t *pc, unsigned long addr)
+{
+	unsigned short val;
+
+	pc_clock_sync (pc);
+
+	val = mem_get_uint16_le (pc->prt, addr);
+
+	if (pc->idle_enable) {
+		pc_idle_poll (pc, PC_IDLE_PORT, addr, val);
+	}
+
+	return (val);
+}
+
+static
+void pc_e86_set_port8 (ibmpc_t *pc, unsigned long addr, unsigned char val)
+{
+	pc_clock_sync (pc);
+
+	mem_set_uint8 (pc->prt, addr, val);
+
+	pc_idle_port_write (pc);
+
+	e86_clock_break (pc->cpu);
+}
+
+static
+void pc_e86_set_port16 (ibmpc_t *pc, unsigned long addr, unsigned short val)
+{
+	pc_clock_sync (pc);
+
+	mem_set_uint16_le (pc->prt, addr, val);
+
+	pc_idle_port_write (pc);
+
+	e86_clock_break (pc->cpu);
+}
+
 static
 void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 {
 	ini_sct_t     *sct;
 	const char    *model;
 	unsigned      speed;
+	int           prefetch, jit;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
 	ini_get_string (sct, "model", &model, "8088");
 	ini_get_uint16 (sct, "speed", &speed, 0);
+	ini_get_bool (sct, "prefetch", &prefetch, 1);
+	ini_get_bool (sct, "jit", &jit, 0);
 
-	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%uX\n",
-		model, speed
+	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%uX prefetch=%d jit=%d\n",
+		model, speed, prefetch, jit
 	);
 
 	pc->cpu = e86_new();
@@ -568,11 +869,11 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 		(e86_set_uint16_f) &mem_set_uint16_le
 	);
 
-	e86_set_prt (pc->cpu, pc->prt,
-		(e86_get_uint8_f) &mem_get_uint8,
-		(e86_set_uint8_f) &mem_set_uint8,
-		(e86_get_uint16_f) &mem_get_uint16_le,
-		(e86_set_uint16_f) &mem_set_uint16_le
+	e86_set_prt (pc->cpu, pc,
+		(e86_get_uint8_f) &pc_e86_get_port8,
+		(e86_set_uint8_f) &pc_e86_set_port8,
+		(e86_get_uint16_f) &pc_e86_get_port16,
+		(e86_set_uint16_f) &pc_e86_set_port16
 	);
 
 	if (pc->ram != NULL) {
@@ -582,6 +883,20 @@ void pc_setup_cpu (ibmpc_t *pc, ini_sct_t *ini)
 		e86_set_ram (pc->cpu, NULL, 0);
 	}
 
+	e86_set_mem_map_fct (pc->cpu, pc, pc_update_mem_map, &mem_map_gen);
+
+	if (prefetch == 0) {
+		if (e86_set_icache (pc->cpu, 1)) {
+			pce_log (MSG_ERR, "*** can't allocate the instruction cache\n");
+		}
+	}
+
+	if (jit) {
+		if (e86_set_jit (pc->cpu, 1)) {
+			pce_log (MSG_ERR, "*** threaded code is not available\n");
+		}
+	}
+
 	pc->cpu->op_ext = pc;
 	pc->cpu->op_hook = &pc_e86_hook;
 
@@ -680,6 +995,7 @@ void pc_setup_pit (ibmpc_t *pc, ini_sct_t *ini)
 	);
 
 	pc->timer1_out = 0;
+	pc->refresh_cnt = 0;
 
 	e8253_init (&pc->pit);
 
@@ -1489,6 +1805,8 @@ ibmpc_t *pc_new (ini_sct_t *ini)
 
 	bps_init (&pc->bps);
 
+	pc_prof_init (&pc->prof);
+
 	pc_setup_system (pc, ini);
 	pc_setup_m24 (pc, ini);
 
@@ -1573,6 +1891,8 @@ void pc_del (ibmpc_t *pc)
 
 	bps_free (&pc->bps);
 
+	pc_prof_free (&pc->prof);
+
 	pc_del_xms (pc);
 	pc_del_ems (pc);
 	pc_del_parport (pc);
@@ -1818,6 +2138,16 @@ void pc_clock_reset (ibmpc_t *pc)
 
 	pc->clock1 = 0;
 	pc->clock2 = 0;
+
+	pc->clk_sync = e86_get_clock (pc->cpu);
+
+	pc->idle = 0;
+	pc->idle_src = 0;
+	pc->idle_val = 0;
+	pc->idle_cnt = 0;
+	pc->idle_clk = 0;
+	pc->idle_kbd = 0;
+	pc->idle_ticks = 0;
 }
 
 void pc_clock_discontinuity (ibmpc_t *pc)
@@ -1837,9 +2167,13 @@ void pc_clock_delay (ibmpc_t *pc)
 	unsigned long vclk;
 	unsigned long rclk;
 	unsigned long us;
+	unsigned long idle;
 
 	vclk = pc->sync_clock2_sim;
 
+	idle = pc->idle_ticks;
+	pc->idle_ticks = 0;
+
 	rclk = pce_get_interval_us (&pc->sync_interval);
 	rclk = (PCE_IBMPC_CLK2 * (unsigned long long) rclk) / 1000000;
 	rclk += pc->sync_clock2_real;
@@ -1859,7 +2193,8 @@ void pc_clock_delay (ibmpc_t *pc)
 
 		return;
 	}
-	else {
+	else if (idle == 0) {
+		/* only speed up the CPU if the guest was not idle */
 		pc->speed_clock_extra += 1;
 	}
 
@@ -1875,42 +2210,93 @@ void pc_clock_delay (ibmpc_t *pc)
 	}
 }
 
-void pc_clock (ibmpc_t *pc, unsigned long cnt)
+/*
+ * Get the number of CPU clock cycles per system clock tick
+ */
+static
+unsigned long pc_get_clk_per_tick (const ibmpc_t *pc)
 {
-	unsigned      i;
-	unsigned long spd;
-	unsigned long clk;
-
-	if (cnt == 0) {
-		cnt = 4;
-	}
-
 	if (pc->speed_current == 0) {
-		e86_clock (pc->cpu, cnt + pc->speed_clock_extra);
-		spd = 4;
-	}
-	else {
-		e86_clock (pc->cpu, cnt);
-		spd = 4 * pc->speed_current;
+		return (4 + pc->speed_clock_extra);
 	}
 
-	pc->clock1 += cnt;
+	return (4 * pc->speed_current);
+}
 
-	if (pc->clock1 < spd) {
-		return;
+/*
+ * Clock the DMAC for the refresh requests from PIT counter 1. Counter 1
+ * is not a device event, so several requests can arrive between two
+ * DMAC updates. The ones that arrived while DREQ0 was still pending
+ * are serviced here, one DMAC clock each.
+ */
+static
+void pc_clock_refresh (ibmpc_t *pc)
+{
+	while (pc->refresh_cnt > 0) {
+		e8237_clock (&pc->dma, 1);
+
+		if (e8237_get_state (&pc->dma, 0) & E8237_STATE_DREQ) {
+			break;
+		}
+
+		e8237_set_dreq0 (&pc->dma, 1);
+
+		pc->refresh_cnt -= 1;
 	}
 
-	pc->clock1 -= spd;
+	pc->refresh_cnt = 0;
+}
+
+/*
+ * Clock the PIT and the video device for n system clock ticks
+ */
+static
+void pc_clock_pit (ibmpc_t *pc, unsigned long n)
+{
+	unsigned long clk;
+
+	while (n > 0) {
+		/* the PIT is clocked in steps up to the next output change */
+		clk = e8253_get_delay (&pc->pit, PCE_IBMPC_PIT_EVENTS);
+
+		if (clk > n) {
+			clk = n;
+		}
+
+		pc->sync_clock2_sim += clk;
+		pc->clock2 += clk;
 
-	pc->sync_clock2_sim += 1;
+		pce_video_clock0 (pc->video, clk, 1);
 
-	pc->clock2 += 1;
+		e8253_clock (&pc->pit, clk);
 
-	pce_video_clock0 (pc->video, 1, 1);
+		pc->clk_div[0] += clk;
 
-	e8253_clock (&pc->pit, 1);
+		n -= clk;
+	}
+}
 
-	pc->clk_div[0] += 1;
+/*
+ * Clock the devices for n system clock ticks
+ */
+static
+void pc_clock_ticks (ibmpc_t *pc, unsigned long n)
+{
+	unsigned      i;
+	unsigned long clk, rem;
+
+	/*
+	 * The other devices are clocked at multiples of 8 ticks. Clock
+	 * the PIT up to the last one first, so that the DMAC does not see
+	 * refresh requests from the remaining ticks too early.
+	 */
+	rem = (pc->clk_div[0] + n) & 7;
+
+	if (rem > n) {
+		rem = n;
+	}
+
+	pc_clock_pit (pc, n - rem);
 
 	if (pc->clk_div[0] >= 8) {
 		clk = pc->clk_div[0] & ~7UL;
@@ -1923,6 +2309,8 @@ void pc_clock (ibmpc_t *pc, unsigned long cnt)
 			pc_cas_clock (pc->cas, clk);
 		}
 
+		pc_clock_refresh (pc);
+
 		e8237_clock (&pc->dma, clk);
 
 		pce_video_clock1 (pc->video, 0);
@@ -1938,10 +2326,6 @@ void pc_clock (ibmpc_t *pc, unsigned long cnt)
 			pc->clk_div[1] &= 1023;
 			pc->clk_div[2] += clk;
 
-			if (pc->trm != NULL) {
-				trm_check (pc->trm);
-			}
-
 			if (pc->fdc != NULL) {
 				e8272_clock (&pc->fdc->e8272, clk);
 			}
@@ -1957,13 +2341,108 @@ void pc_clock (ibmpc_t *pc, unsigned long cnt)
 					ser_clock (pc->serport[i], clk);
 				}
 			}
+		}
+	}
 
-			if (pc->clk_div[2] >= 16384) {
-				pc->clk_div[2] &= 16383;
-				pc_clock_delay (pc);
-			}
+	pc_clock_pit (pc, rem);
+}
+
+/*
+ * Check the terminal and synchronize with real time. This is not done
+ * in pc_clock_sync(), which can be called while the CPU executes an
+ * instruction.
+ */
+static
+void pc_clock_host (ibmpc_t *pc)
+{
+	if (pc->clk_div[2] < 1024) {
+		return;
+	}
+
+	if (pc->trm != NULL) {
+		trm_check (pc->trm);
+	}
+
+	pc->clk_div[3] += pc->clk_div[2];
+	pc->clk_div[2] = 0;
+
+	if (pc->clk_div[3] >= 16384) {
+		pc->clk_div[3] &= 16383;
+		pc_clock_delay (pc);
+	}
+}
+
+/*
+ * Clock the devices up to the current CPU clock
+ */
+static
+void pc_clock_sync (ibmpc_t *pc)
+{
+	unsigned long      cpt;
+	unsigned long long clk;
+
+	clk = e86_get_clock (pc->cpu);
+
+	pc->clock1 += clk - pc->clk_sync;
+	pc->clk_sync = clk;
+
+	cpt = pc_get_clk_per_tick (pc);
+
+	if (pc->clock1 < cpt) {
+		return;
+	}
+
+	clk = pc->clock1 / cpt;
+	pc->clock1 -= clk * cpt;
+
+	pc_clock_ticks (pc, clk);
+}
+
+void pc_clock (ibmpc_t *pc, unsigned long cnt)
+{
+	unsigned long cpt, tick;
+
+	if ((cnt == 0) && pc->idle_enable) {
+		tick = pc_idle_get_ticks (pc);
+
+		if (tick > 0) {
+			cnt = tick * pc_get_clk_per_tick (pc);
+			cnt = (cnt > pc->clock1) ? (cnt - pc->clock1) : 1;
+
+			pc->idle_ticks += tick;
+
+			e86_skip (pc->cpu, cnt);
+
+			pc_clock_sync (pc);
+			pc_clock_host (pc);
+
+			return;
+		}
+	}
+
+	if (cnt == 0) {
+		/* run the CPU up to the next device event */
+		cpt = pc_get_clk_per_tick (pc);
+		tick = e8253_get_delay (&pc->pit, PCE_IBMPC_PIT_EVENTS);
+
+		if (tick > PCE_IBMPC_CLK_MAX) {
+			tick = PCE_IBMPC_CLK_MAX;
+		}
+
+		cnt = tick * cpt;
+
+		if (cnt > pc->clock1) {
+			cnt -= pc->clock1;
+		}
+		else {
+			cnt = 1;
 		}
 	}
+
+	e86_clock (pc->cpu, cnt);
+
+	pc_clock_sync (pc);
+	pc_clock_host (pc);
 }
 
 int pc_set_cpu_model (ibmpc_t *pc, const char *str)
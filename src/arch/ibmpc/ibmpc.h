@@ -27,6 +27,7 @@
 #include "cassette.h"
 #include "ems.h"
 #include "keyboard.h"
+#include "profile.h"
 #include "speaker.h"
 #include "xms.h"
 
@@ -102,6 +103,8 @@ typedef struct ibmpc_t {
 
 	bp_set_t           bps;
 
+	pc_prof_t          prof;
+
 	unsigned           bootdrive;
 
 	unsigned long      dma_page[4];
@@ -109,6 +112,9 @@ typedef struct ibmpc_t {
 	unsigned char      timer1_out;
 	unsigned char      dack0;
 
+	/* refresh requests from PIT counter 1 not yet seen by the DMAC */
+	unsigned long      refresh_cnt;
+
 	char               patch_bios_init;
 	char               patch_bios_int19;
 
@@ -136,6 +142,32 @@ typedef struct ibmpc_t {
 	unsigned long      clock1;
 	unsigned long      clock2;
 
+	/* the CPU clock up to which the devices have been clocked */
+	unsigned long long clk_sync;
+
+	/* skip ahead in time while the guest is idle */
+	int                idle_enable;
+
+	/* the pending idle skip or 0 */
+	unsigned           idle;
+
+	/* the last poll (an I/O port or an int 16h function) */
+	unsigned long      idle_src;
+	unsigned long      idle_val;
+	unsigned           idle_cnt;
+	unsigned long long idle_clk;
+
+	/* waiting for a key in int 16h */
+	char               idle_kbd;
+	unsigned short     idle_kbd_ss;
+	unsigned short     idle_kbd_sp;
+	unsigned short     idle_kbd_cs;
+	unsigned short     idle_kbd_ip;
+	unsigned short     idle_kbd_sp2;
+
+	/* the system clock ticks skipped since the last real time sync */
+	unsigned long      idle_ticks;
+
 	unsigned           brk;
 	char               pause;
 } ibmpc_t;
@@ -177,8 +209,18 @@ void pc_clock_reset (ibmpc_t *pc);
  *****************************************************************************/
 void pc_clock_discontinuity (ibmpc_t *pc);
 
+/*!***************************************************************************
+ * @short Check for an idle loop in a software interrupt
+ *
+ * This is called by the CPU for every interrupt.
+ *****************************************************************************/
+void pc_idle_int (ibmpc_t *pc, unsigned n);
+
 /*!***************************************************************************
  * @short Clock the pc
+ * @param cnt The number of CPU clock cycles to run. If cnt is 0, the CPU
+ *            runs until the next device event. If the guest is idle, it
+ *            skips ahead to that event.
  *****************************************************************************/
 void pc_clock (ibmpc_t *pc, unsigned long cnt);
 
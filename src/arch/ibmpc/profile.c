@@ -0,0 +1,559 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/arch/ibmpc/profile.c                                     *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include "main.h"
+#include "profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define PC_PROF_ADDR_MIN 4096
+
+
+void pc_prof_init (pc_prof_t *prof)
+{
+	prof->enabled = 0;
+
+	prof->period = 1;
+
+	prof->addr_cnt = 0;
+	prof->addr_max = 0;
+	prof->addr = NULL;
+
+	pc_prof_clear (prof);
+}
+
+void pc_prof_free (pc_prof_t *prof)
+{
+	free (prof->addr);
+
+	prof->addr = NULL;
+	prof->addr_cnt = 0;
+	prof->addr_max = 0;
+}
+
+void pc_prof_clear (pc_prof_t *prof)
+{
+	unsigned long i;
+
+	prof->phase = 0;
+
+	prof->last_op = -1;
+	prof->last_addr = NULL;
+	prof->last_clk = 0;
+
+	prof->insn_cnt = 0;
+	prof->sample_cnt = 0;
+
+	for (i = 0; i < PC_PROF_OP_CNT; i++) {
+		prof->op[i].cnt = 0;
+		prof->op[i].clk = 0;
+	}
+
+	for (i = 0; i < prof->addr_max; i++) {
+		prof->addr[i].cnt = 0;
+		prof->addr[i].clk = 0;
+	}
+
+	prof->addr_cnt = 0;
+}
+
+void pc_prof_start (pc_prof_t *prof, unsigned long period)
+{
+	prof->enabled = 1;
+	prof->period = (period > 0) ? period : 1;
+	prof->phase = 0;
+
+	prof->last_op = -1;
+	prof->last_addr = NULL;
+}
+
+void pc_prof_stop (pc_prof_t *prof)
+{
+	prof->enabled = 0;
+
+	prof->last_op = -1;
+	prof->last_addr = NULL;
+}
+
+static
+int pc_prof_is_group (unsigned char op)
+{
+	switch (op) {
+	case 0x80:
+	case 0x81:
+	case 0x82:
+	case 0x83:
+	case 0x8f:
+	case 0xc0:
+	case 0xc1:
+	case 0xc6:
+	case 0xc7:
+	case 0xd0:
+	case 0xd1:
+	case 0xd2:
+	case 0xd3:
+	case 0xf6:
+	case 0xf7:
+	case 0xfe:
+	case 0xff:
+		return (1);
+	}
+
+	return (0);
+}
+
+static
+unsigned long pc_prof_hash (unsigned short seg, unsigned short ofs)
+{
+	unsigned long v;
+
+	v = ((unsigned long) seg << 16) | ofs;
+	v = (v ^ (v >> 13)) * 0x9e3b;
+
+	return (v ^ (v >> 16));
+}
+
+/*
+ * Find the entry for seg:ofs in a hash table or the free entry where it
+ * should be inserted
+ */
+static
+pc_prof_addr_t *pc_prof_find (pc_prof_addr_t *tab, unsigned long max,
+	unsigned short seg, unsigned short ofs)
+{
+	unsigned long i;
+
+	i = pc_prof_hash (seg, ofs) & (max - 1);
+
+	while (tab[i].cnt != 0) {
+		if ((tab[i].seg == seg) && (tab[i].ofs == ofs)) {
+			break;
+		}
+
+		i = (i + 1) & (max - 1);
+	}
+
+	return (tab + i);
+}
+
+static
+int pc_prof_grow (pc_prof_t *prof)
+{
+	unsigned long  i, max;
+	pc_prof_addr_t *tab, *ent;
+
+	max = (prof->addr_max < PC_PROF_ADDR_MIN) ? PC_PROF_ADDR_MIN : (2 * prof->addr_max);
+
+	tab = malloc (max * sizeof (pc_prof_addr_t));
+
+	if (tab == NULL) {
+		return (1);
+	}
+
+	for (i = 0; i < max; i++) {
+		tab[i].cnt = 0;
+		tab[i].clk = 0;
+	}
+
+	for (i = 0; i < prof->addr_max; i++) {
+		if (prof->addr[i].cnt != 0) {
+			ent = pc_prof_find (tab, max, prof->addr[i].seg, prof->addr[i].ofs);
+			*ent = prof->addr[i];
+		}
+	}
+
+	if (prof->last_addr != NULL) {
+		prof->last_addr = pc_prof_find (tab, max,
+			prof->last_addr->seg, prof->last_addr->ofs
+		);
+	}
+
+	free (prof->addr);
+
+	prof->addr = tab;
+	prof->addr_max = max;
+
+	return (0);
+}
+
+static
+void pc_prof_sample (pc_prof_t *prof, unsigned short seg, unsigned short ofs)
+{
+	pc_prof_addr_t *ent;
+
+	if ((4 * (prof->addr_cnt + 1)) > (3 * prof->addr_max)) {
+		if (pc_prof_grow (prof)) {
+			return;
+		}
+	}
+
+	ent = pc_prof_find (prof->addr, prof->addr_max, seg, ofs);
+
+	if (ent->cnt == 0) {
+		ent->seg = seg;
+		ent->ofs = ofs;
+		prof->addr_cnt += 1;
+	}
+
+	ent->cnt += 1;
+
+	prof->sample_cnt += 1;
+
+	prof->last_addr = ent;
+}
+
+void pc_prof_insn (pc_prof_t *prof, e8086_t *cpu, unsigned char op1, unsigned char op2)
+{
+	unsigned long long clk, dclk;
+
+	if (prof->enabled == 0) {
+		return;
+	}
+
+	/* this includes interrupts and halt cycles after an instruction */
+	clk = e86_get_clock (cpu) + cpu->delay;
+	dclk = clk - prof->last_clk;
+	prof->last_clk = clk;
+
+	if (prof->last_op >= 0) {
+		prof->op[prof->last_op].clk += dclk;
+	}
+
+	if (prof->last_addr != NULL) {
+		prof->last_addr->clk += dclk;
+		prof->last_addr = NULL;
+	}
+
+	prof->last_op = (unsigned) op1 << 3;
+
+	if (pc_prof_is_group (op1)) {
+		prof->last_op |= (op2 >> 3) & 7;
+	}
+
+	prof->op[prof->last_op].cnt += 1;
+
+	prof->insn_cnt += 1;
+
+	prof->phase += 1;
+
+	if (prof->phase >= prof->period) {
+		prof->phase = 0;
+		pc_prof_sample (prof, e86_get_cs (cpu), e86_get_ip (cpu));
+	}
+}
+
+static
+void pc_prof_disasm (char *dst, e86_disasm_t *op)
+{
+	if (op->arg_n == 0) {
+		sprintf (dst, "%s", op->op);
+	}
+	else if (op->arg_n == 1) {
+		sprintf (dst, "%-6s %s", op->op, op->arg1);
+	}
+	else {
+		sprintf (dst, "%-6s %s, %s", op->op, op->arg1, op->arg2);
+	}
+}
+
+/*
+ * Get the mnemonic of an opcode. The operands are not known.
+ */
+static
+void pc_prof_disasm_op (char *dst, unsigned idx)
+{
+	unsigned      i;
+	unsigned char src[16];
+	e86_disasm_t  op;
+
+	for (i = 0; i < 16; i++) {
+		src[i] = 0;
+	}
+
+	src[0] = idx >> 3;
+	src[1] = 0xc0 | ((idx & 7) << 3);
+
+	e86_disasm (&op, src, 0);
+
+	sprintf (dst, "%s", op.op);
+}
+
+static
+double pc_prof_pct (unsigned long long val, unsigned long long tot)
+{
+	if (tot == 0) {
+		return (0.0);
+	}
+
+	return ((100.0 * val) / tot);
+}
+
+static
+int pc_prof_cmp_op (const void *p1, const void *p2)
+{
+	const pc_prof_op_t *o1, *o2;
+
+	o1 = *(const pc_prof_op_t **) p1;
+	o2 = *(const pc_prof_op_t **) p2;
+
+	if (o1->clk != o2->clk) {
+		return ((o1->clk < o2->clk) ? 1 : -1);
+	}
+
+	if (o1->cnt != o2->cnt) {
+		return ((o1->cnt < o2->cnt) ? 1 : -1);
+	}
+
+	return ((o1 < o2) ? -1 : 1);
+}
+
+static
+int pc_prof_cmp_addr_cnt (const void *p1, const void *p2)
+{
+	const pc_prof_addr_t *a1, *a2;
+
+	a1 = *(const pc_prof_addr_t **) p1;
+	a2 = *(const pc_prof_addr_t **) p2;
+
+	if (a1->cnt != a2->cnt) {
+		return ((a1->cnt < a2->cnt) ? 1 : -1);
+	}
+
+	if (a1->seg != a2->seg) {
+		return ((a1->seg < a2->seg) ? -1 : 1);
+	}
+
+	return ((a1->ofs < a2->ofs) ? -1 : 1);
+}
+
+static
+int pc_prof_cmp_addr_pos (const void *p1, const void *p2)
+{
+	const pc_prof_addr_t *a1, *a2;
+
+	a1 = *(const pc_prof_addr_t **) p1;
+	a2 = *(const pc_prof_addr_t **) p2;
+
+	if (a1->seg != a2->seg) {
+		return ((a1->seg < a2->seg) ? -1 : 1);
+	}
+
+	if (a1->ofs != a2->ofs) {
+		return ((a1->ofs < a2->ofs) ? -1 : 1);
+	}
+
+	return (0);
+}
+
+/*
+ * Get a sorted list of all sampled addresses
+ */
+static
+pc_prof_addr_t **pc_prof_get_addr_list (pc_prof_t *prof,
+	int (*cmp) (const void *p1, const void *p2))
+{
+	unsigned long  i, n;
+	pc_prof_addr_t **lst;
+
+	lst = malloc ((prof->addr_cnt + 1) * sizeof (pc_prof_addr_t *));
+
+	if (lst == NULL) {
+		return (NULL);
+	}
+
+	n = 0;
+
+	for (i = 0; i < prof->addr_max; i++) {
+		if (prof->addr[i].cnt != 0) {
+			lst[n++] = &prof->addr[i];
+		}
+	}
+
+	qsort (lst, n, sizeof (pc_prof_addr_t *), cmp);
+
+	return (lst);
+}
+
+static
+void pc_prof_print_op (pc_prof_t *prof, FILE *fp, unsigned cnt)
+{
+	unsigned           i, n;
+	unsigned long long clk;
+	pc_prof_op_t       *lst[PC_PROF_OP_CNT];
+	char               str[256];
+
+	n = 0;
+	clk = 0;
+
+	for (i = 0; i < PC_PROF_OP_CNT; i++) {
+		if (prof->op[i].cnt != 0) {
+			lst[n++] = &prof->op[i];
+			clk += prof->op[i].clk;
+		}
+	}
+
+	qsort (lst, n, sizeof (pc_prof_op_t *), pc_prof_cmp_op);
+
+	fprintf (fp, "# opcodes: %llu instructions, %llu cycles\n",
+		prof->insn_cnt, clk
+	);
+
+	fprintf (fp, "# %-8s %14s %6s %14s %6s %7s  %s\n",
+		"OP", "COUNT", "%", "CYCLES", "%", "CPI", "INSTRUCTION"
+	);
+
+	if ((cnt == 0) || (cnt > n)) {
+		cnt = n;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		unsigned idx;
+
+		idx = lst[i] - prof->op;
+
+		pc_prof_disasm_op (str, idx);
+
+		if (pc_prof_is_group (idx >> 3)) {
+			fprintf (fp, "  %02X /%u    ", idx >> 3, idx & 7);
+		}
+		else {
+			fprintf (fp, "  %02X       ", idx >> 3);
+		}
+
+		fprintf (fp, "%14llu %6.2f %14llu %6.2f %7.2f  %s\n",
+			lst[i]->cnt, pc_prof_pct (lst[i]->cnt, prof->insn_cnt),
+			lst[i]->clk, pc_prof_pct (lst[i]->clk, clk),
+			(double) lst[i]->clk / lst[i]->cnt,
+			str
+		);
+	}
+}
+
+static
+void pc_prof_print_addr (pc_prof_t *prof, e8086_t *cpu, FILE *fp, unsigned cnt)
+{
+	unsigned long  i;
+	pc_prof_addr_t **lst, *ent;
+	e86_disasm_t   op;
+	char           str[256];
+
+	fprintf (fp, "# addresses: %llu samples, one every %lu instructions\n",
+		prof->sample_cnt, prof->period
+	);
+
+	fprintf (fp, "# %-9s %-5s %14s %6s %14s  %s\n",
+		"ADDR", "LIN", "SAMPLES", "%", "CYCLES", "INSTRUCTION"
+	);
+
+	if (prof->addr_cnt == 0) {
+		return;
+	}
+
+	lst = pc_prof_get_addr_list (prof, pc_prof_cmp_addr_cnt);
+
+	if (lst == NULL) {
+		return;
+	}
+
+	if ((cnt == 0) || (cnt > prof->addr_cnt)) {
+		cnt = prof->addr_cnt;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		ent = lst[i];
+
+		e86_disasm_mem (cpu, &op, ent->seg, ent->ofs);
+		pc_prof_disasm (str, &op);
+
+		fprintf (fp, "  %04X:%04X %05lX %14llu %6.2f %14llu  %s\n",
+			ent->seg, ent->ofs,
+			e86_get_linear (ent->seg, ent->ofs) & 0xfffffUL,
+			ent->cnt, pc_prof_pct (ent->cnt, prof->sample_cnt),
+			ent->clk, str
+		);
+	}
+
+	free (lst);
+}
+
+void pc_prof_print (pc_prof_t *prof, e8086_t *cpu, FILE *fp, unsigned cnt)
+{
+	pc_prof_print_op (prof, fp, cnt);
+	fputs ("\n", fp);
+	pc_prof_print_addr (prof, cpu, fp, cnt);
+}
+
+/*
+ * Every code segment is a function. The samples of an address are
+ * reported as its cost, in linear addresses.
+ */
+void pc_prof_print_callgrind (pc_prof_t *prof, FILE *fp)
+{
+	unsigned long      i;
+	unsigned           seg;
+	unsigned long long clk;
+	pc_prof_addr_t     **lst, *ent;
+
+	clk = 0;
+
+	for (i = 0; i < prof->addr_max; i++) {
+		clk += prof->addr[i].clk;
+	}
+
+	fprintf (fp, "# callgrind format\n");
+	fprintf (fp, "version: 1\n");
+	fprintf (fp, "creator: pce-ibmpc\n");
+	fprintf (fp, "positions: instr\n");
+	fprintf (fp, "events: Samples Cycles\n");
+	fprintf (fp, "summary: %llu %llu\n", prof->sample_cnt, clk);
+	fprintf (fp, "\nob=guest\n");
+
+	if (prof->addr_cnt == 0) {
+		return;
+	}
+
+	lst = pc_prof_get_addr_list (prof, pc_prof_cmp_addr_pos);
+
+	if (lst == NULL) {
+		return;
+	}
+
+	seg = 0x10000;
+
+	for (i = 0; i < prof->addr_cnt; i++) {
+		ent = lst[i];
+
+		if (ent->seg != seg) {
+			seg = ent->seg;
+			fprintf (fp, "\nfn=%04X\n", seg);
+		}
+
+		fprintf (fp, "0x%05lx %llu %llu\n",
+			e86_get_linear (ent->seg, ent->ofs) & 0xfffffUL,
+			ent->cnt, ent->clk
+		);
+	}
+
+	free (lst);
+}
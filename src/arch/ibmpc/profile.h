@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/arch/ibmpc/profile.h                                     *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#ifndef PCE_IBMPC_PROFILE_H
+#define PCE_IBMPC_PROFILE_H 1
+
+
+#include <stdio.h>
+
+#include <cpu/e8086/e8086.h>
+
+
+/* opcodes are counted separately for each reg field of group opcodes */
+#define PC_PROF_OP_CNT 2048
+
+
+typedef struct {
+	unsigned long long cnt;
+	unsigned long long clk;
+} pc_prof_op_t;
+
+typedef struct {
+	unsigned short     seg;
+	unsigned short     ofs;
+	unsigned long long cnt;
+	unsigned long long clk;
+} pc_prof_addr_t;
+
+typedef struct {
+	char               enabled;
+
+	/* sample CS:IP every period instructions */
+	unsigned long      period;
+	unsigned long      phase;
+
+	/* the previous instruction, its cycles are known at the next one */
+	int                last_op;
+	pc_prof_addr_t     *last_addr;
+	unsigned long long last_clk;
+
+	unsigned long long insn_cnt;
+	unsigned long long sample_cnt;
+
+	pc_prof_op_t       op[PC_PROF_OP_CNT];
+
+	/* the CS:IP hash table */
+	unsigned long      addr_cnt;
+	unsigned long      addr_max;
+	pc_prof_addr_t     *addr;
+} pc_prof_t;
+
+
+void pc_prof_init (pc_prof_t *prof);
+void pc_prof_free (pc_prof_t *prof);
+
+/*!***************************************************************************
+ * @short Reset all counters
+ *****************************************************************************/
+void pc_prof_clear (pc_prof_t *prof);
+
+/*!***************************************************************************
+ * @short Start profiling
+ * @param period Sample CS:IP every period instructions
+ *****************************************************************************/
+void pc_prof_start (pc_prof_t *prof, unsigned long period);
+
+/*!***************************************************************************
+ * @short Stop profiling
+ *****************************************************************************/
+void pc_prof_stop (pc_prof_t *prof);
+
+/*!***************************************************************************
+ * @short Record an instruction
+ *
+ * This is called from the CPU's op_stat hook before the instruction is
+ * executed. Prefixes are recorded as separate instructions.
+ *****************************************************************************/
+void pc_prof_insn (pc_prof_t *prof, e8086_t *cpu, unsigned char op1, unsigned char op2);
+
+/*!***************************************************************************
+ * @short Print the cnt hottest opcodes and addresses as text
+ *****************************************************************************/
+void pc_prof_print (pc_prof_t *prof, e8086_t *cpu, FILE *fp, unsigned cnt);
+
+/*!***************************************************************************
+ * @short Write the address profile in callgrind format
+ *****************************************************************************/
+void pc_prof_print_callgrind (pc_prof_t *prof, FILE *fp);
+
+
+#endif
@@ -581,6 +581,23 @@ void adb_clock_idle (mac_adb_t *adb, unsigned cnt)
 	}
 }
 
+unsigned long mac_adb_get_delay (const mac_adb_t *adb)
+{
+	if (adb->bit_cnt > 0) {
+		return ((adb->clock > 0) ? adb->clock : 1);
+	}
+
+	if (adb->state == 3) {
+		if (adb->scan_clock < 86170) {
+			return (86170 - adb->scan_clock);
+		}
+
+		return (1);
+	}
+
+	return (MAC_DELAY_MAX);
+}
+
 void mac_adb_clock (mac_adb_t *adb, unsigned cnt)
 {
 	if (adb->bit_cnt == 0) {
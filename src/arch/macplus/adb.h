@@ -106,6 +106,12 @@ int adb_add_device (mac_adb_t *adb, adb_dev_t *dev);
 
 void mac_adb_set_state (mac_adb_t *adb, unsigned char val);
 
+/*****************************************************************************
+ * @short Get the number of clocks until the next bit is shifted or the
+ *        next idle poll or MAC_DELAY_MAX if there is neither
+ *****************************************************************************/
+unsigned long mac_adb_get_delay (const mac_adb_t *adb);
+
 void mac_adb_clock (mac_adb_t *adb, unsigned cnt);
 
 
@@ -41,6 +41,7 @@
 #include <emscripten.h>
 
 mon_cmd_t par_cmd[] = {
+	{ "bench", "[cnt]", "compare the interpreter and translator speed" },
 	{ "c", "[cnt]", "clock" },
 	{ "gb", "[addr..]", "run with breakpoints at addr" },
 	{ "ge", "[exception]", "run until exception" },
@@ -373,9 +374,11 @@ void mac_run (macplus_t *sim)
 
 	mac_clock_discontinuity (sim);
 
+	sim->cpu->jit_disable = 0;
+
 	while (1) {
-		mac_clock (par_sim, 0);
-		mac_clock (par_sim, 0);
+		mac_clock_slice (par_sim);
+		mac_clock_slice (par_sim);
 
 		if (sim->brk) {
 			break;
@@ -517,6 +520,7 @@ void mac_log_exception (void *ext, unsigned tn)
 
 	case 0x0a:
 		mac_sony_patch (&sim->sony);
+		e68_icache_flush (sim->cpu);
 		return;
 
 	case 0x19:
@@ -553,6 +557,96 @@ void mac_log_mem (void *ext, unsigned long addr, unsigned type)
 }
 
 
+static
+double mac_cmd_bench_run (macplus_t *sim, unsigned long cnt)
+{
+	unsigned long us, tmp;
+	unsigned long start, end;
+
+	start = e68_get_opcnt (sim->cpu);
+	end = start + cnt;
+
+	pce_get_interval_us (&tmp);
+
+	while (e68_get_opcnt (sim->cpu) < end) {
+		mac_clock_slice (sim);
+
+		if (sim->brk) {
+			break;
+		}
+	}
+
+	us = pce_get_interval_us (&tmp);
+
+	if (us == 0) {
+		us = 1;
+	}
+
+	return ((double) (e68_get_opcnt (sim->cpu) - start) / (double) us);
+}
+
+/*
+ * bench - compare the interpreter and translator speed
+ */
+static
+void mac_cmd_bench (cmd_t *cmd, macplus_t *sim)
+{
+	unsigned long cnt;
+	int           have_ic, have_jit;
+	double        mips;
+	e68000_t      *c;
+
+	cnt = 10000000;
+
+	cmd_match_uint32 (cmd, &cnt);
+
+	if (!cmd_match_end (cmd)) {
+		return;
+	}
+
+	c = sim->cpu;
+
+	have_ic = (c->ic != NULL);
+	have_jit = (c->jit != NULL);
+
+	pce_start (&sim->brk);
+
+	mac_clock_discontinuity (sim);
+
+	c->jit_disable = 1;
+
+	mips = mac_cmd_bench_run (sim, cnt);
+
+	pce_printf ("interpreter: %8.2f MIPS\n", mips);
+
+	if ((sim->brk == 0) && (e68_set_jit (c, 1) == 0)) {
+		if (have_ic == 0) {
+			mac_setup_icache_rom (sim);
+		}
+
+		c->jit_disable = 0;
+
+		mips = mac_cmd_bench_run (sim, cnt);
+
+		c->jit_disable = 1;
+
+		pce_printf ("translator:  %8.2f MIPS\n", mips);
+	}
+	else {
+		pce_printf ("translator:  not available\n");
+	}
+
+	if (have_jit == 0) {
+		e68_set_jit (c, 0);
+	}
+
+	if (have_ic == 0) {
+		e68_set_icache (c, 0);
+	}
+
+	pce_stop();
+}
+
 /*
  * c - clock
  */
@@ -1021,7 +1115,16 @@ int mac_cmd (macplus_t *sim, cmd_t *cmd)
 		trm_check (sim->trm);
 	}
 
-	if (cmd_match (cmd, "b")) {
+	/* memory may have been modified by a previous monitor command */
+	e68_icache_flush (sim->cpu);
+
+	/* translated blocks would step over breakpoints */
+	sim->cpu->jit_disable = 1;
+
+	if (cmd_match (cmd, "bench")) {
+		mac_cmd_bench (cmd, sim);
+	}
+	else if (cmd_match (cmd, "b")) {
 		cmd_do_b (cmd, &sim->bps);
 	}
 	else if (cmd_match (cmd, "c")) {
@@ -498,6 +498,19 @@ void mac_kbd_set_data (mac_kbd_t *kbd, unsigned char val)
 	kbd->data = val;
 }
 
+unsigned long mac_kbd_get_delay (const mac_kbd_t *kbd)
+{
+	if ((kbd->data == 0) || (kbd->send_byte == 0)) {
+		return (MAC_DELAY_MAX);
+	}
+
+	if ((kbd->buf_n > 0) || (kbd->timeout == 0)) {
+		return (1);
+	}
+
+	return (kbd->timeout);
+}
+
 void mac_kbd_clock (mac_kbd_t *kbd, unsigned cnt)
 {
 	unsigned char val;
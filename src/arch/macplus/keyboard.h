@@ -84,6 +84,12 @@ void mac_kbd_set_uint8 (mac_kbd_t *kbd, unsigned char val);
 
 void mac_kbd_set_data (mac_kbd_t *kbd, unsigned char val);
 
+/*****************************************************************************
+ * @short Get the number of clocks until the keyboard sends a byte or
+ *        MAC_DELAY_MAX if the host does not wait for one
+ *****************************************************************************/
+unsigned long mac_kbd_get_delay (const mac_kbd_t *kbd);
+
 void mac_kbd_clock (mac_kbd_t *kbd, unsigned cnt);
 
 
@@ -556,6 +556,81 @@ void mac_scc_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 		e8530_set_data_a (&sim->scc, val);
 		break;
 	}
+
+	e68_clock_break (sim->cpu);
+}
+
+
+/*
+ * The VIA is accessed through these functions so that its timers are
+ * up to date while the CPU runs a time slice. A write ends the slice,
+ * since it can change the time of the next VIA, ADB, keyboard or sound
+ * event.
+ */
+static
+unsigned char mac_via_get_uint8 (void *ext, unsigned long addr)
+{
+	macplus_t *sim = ext;
+
+	mac_clock_sync (sim);
+
+	return (e6522_get_uint8 (&sim->via, addr));
+}
+
+static
+unsigned short mac_via_get_uint16 (void *ext, unsigned long addr)
+{
+	macplus_t *sim = ext;
+
+	mac_clock_sync (sim);
+
+	return (e6522_get_uint16 (&sim->via, addr));
+}
+
+static
+unsigned long mac_via_get_uint32 (void *ext, unsigned long addr)
+{
+	macplus_t *sim = ext;
+
+	mac_clock_sync (sim);
+
+	return (e6522_get_uint32 (&sim->via, addr));
+}
+
+static
+void mac_via_set_uint8 (void *ext, unsigned long addr, unsigned char val)
+{
+	macplus_t *sim = ext;
+
+	mac_clock_sync (sim);
+
+	e6522_set_uint8 (&sim->via, addr, val);
+
+	e68_clock_break (sim->cpu);
+}
+
+static
+void mac_via_set_uint16 (void *ext, unsigned long addr, unsigned short val)
+{
+	macplus_t *sim = ext;
+
+	mac_clock_sync (sim);
+
+	e6522_set_uint16 (&sim->via, addr, val);
+
+	e68_clock_break (sim->cpu);
+}
+
+static
+void mac_via_set_uint32 (void *ext, unsigned long addr, unsigned long val)
+{
+	macplus_t *sim = ext;
+
+	mac_clock_sync (sim);
+
+	e6522_set_uint32 (&sim->via, addr, val);
+
+	e68_clock_break (sim->cpu);
 }
 
 
@@ -572,8 +647,11 @@ void mac_setup_system (macplus_t *sim, ini_sct_t *ini)
 	}
 
 	ini_get_string (sct, "model", &model, "mac-plus");
+	ini_get_bool (sct, "idle", &sim->idle_enable, 1);
 
-	pce_log_tag (MSG_INF, "SYSTEM:", "model=%s\n", model);
+	pce_log_tag (MSG_INF, "SYSTEM:", "model=%s idle=%d\n",
+		model, sim->idle_enable
+	);
 
 	if (strcmp (model, "mac-plus") == 0) {
 		sim->model = PCE_MAC_PLUS;
@@ -611,6 +689,8 @@ void mac_setup_mem (macplus_t *sim, ini_sct_t *ini)
 	sim->ram_ovl = NULL;
 	sim->rom_ovl = NULL;
 
+	mac_map_update (sim);
+
 	if (sim->ram == NULL) {
 		pce_log (MSG_ERR, "*** RAM not found at 000000\n");
 		return;
@@ -647,19 +727,46 @@ void mac_setup_mem (macplus_t *sim, ini_sct_t *ini)
 	}
 }
 
+/*
+ * Mark the pages of read-only memory blocks as ROM for the
+ * instruction cache
+ */
+void mac_setup_icache_rom (macplus_t *sim)
+{
+	unsigned long addr;
+	mem_page_t    *pg;
+
+	for (addr = 0; addr < E68_IC_PAGE_CNT * MEM_PAGE_SIZE; addr += MEM_PAGE_SIZE) {
+		if ((pg = mem_get_page (sim->mem, addr)) == NULL) {
+			continue;
+		}
+
+		if ((pg->rd != NULL) && mem_blk_get_readonly (pg->blk)) {
+			e68_set_icache_rom (sim->cpu, addr, MEM_PAGE_SIZE, 1);
+		}
+	}
+}
+
 static
 void mac_setup_cpu (macplus_t *sim, ini_sct_t *ini)
 {
 	ini_sct_t  *sct;
 	const char *model;
 	unsigned   speed;
+	int        icache, jit, history;
 
 	sct = ini_next_sct (ini, NULL, "cpu");
 
 	ini_get_string (sct, "model", &model, "68000");
 	ini_get_uint16 (sct, "speed", &speed, 0);
+	ini_get_bool (sct, "icache", &icache, 0);
+	ini_get_bool (sct, "jit", &jit, 0);
+	ini_get_bool (sct, "history", &history, 1);
 
-	pce_log_tag (MSG_INF, "CPU:", "model=%s speed=%d\n", model, speed);
+	pce_log_tag (MSG_INF, "CPU:",
+		"model=%s speed=%d icache=%d jit=%d history=%d\n",
+		model, speed, icache, jit, history
+	);
 
 	sim->cpu = e68_new();
 	if (sim->cpu == NULL) {
@@ -670,13 +777,13 @@ void mac_setup_cpu (macplus_t *sim, ini_sct_t *ini)
 		pce_log (MSG_ERR, "*** unknown cpu model (%s)\n", model);
 	}
 
-	e68_set_mem_fct (sim->cpu, sim->mem,
-		&mem_get_uint8,
-		&mem_get_uint16_be,
-		&mem_get_uint32_be,
-		&mem_set_uint8,
-		&mem_set_uint16_be,
-		&mem_set_uint32_be
+	e68_set_mem_fct (sim->cpu, sim,
+		&mac_get_uint8,
+		&mac_get_uint16,
+		&mac_get_uint32,
+		&mac_set_uint8,
+		&mac_set_uint16,
+		&mac_set_uint32
 	);
 
 	e68_set_reset_fct (sim->cpu, sim, mac_set_reset);
@@ -685,10 +792,54 @@ void mac_setup_cpu (macplus_t *sim, ini_sct_t *ini)
 
 	e68_set_address_check (sim->cpu, 0);
 
+	e68_set_pc_history (sim->cpu, history);
+
+	if (icache || jit) {
+		if (e68_set_icache (sim->cpu, 1)) {
+			pce_log (MSG_ERR, "*** can't allocate the instruction cache\n");
+		}
+		else {
+			mac_setup_icache_rom (sim);
+		}
+	}
+
+	if (jit) {
+		if (e68_set_jit (sim->cpu, 1)) {
+			pce_log (MSG_ERR, "*** dynamic translation is not available\n");
+		}
+	}
+
 	sim->speed_factor = speed;
 	sim->speed_limit[PCE_MAC_SPEED_USER] = speed;
 }
 
+static
+void mac_setup_idle (macplus_t *sim, ini_sct_t *ini)
+{
+	ini_sct_t     *sct;
+	unsigned long addr, size;
+
+	if (sim->cpu == NULL) {
+		return;
+	}
+
+	sct = NULL;
+
+	while ((sct = ini_next_sct (ini, sct, "idle_range")) != NULL) {
+		ini_get_uint32 (sct, "address", &addr, 0);
+		ini_get_uint32 (sct, "size", &size, 0);
+
+		pce_log_tag (MSG_INF, "IDLE:", "addr=0x%06lx size=%lu\n",
+			addr, size
+		);
+
+		if (e68_add_idle_range (sim->cpu, addr, size)) {
+			pce_log (MSG_ERR, "*** too many idle ranges\n");
+			break;
+		}
+	}
+}
+
 static
 void mac_setup_via (macplus_t *sim, ini_sct_t *ini)
 {
@@ -716,9 +867,9 @@ void mac_setup_via (macplus_t *sim, ini_sct_t *ini)
 		return;
 	}
 
-	mem_blk_set_fct (blk, &sim->via,
-		e6522_get_uint8, e6522_get_uint16, e6522_get_uint32,
-		e6522_set_uint8, e6522_set_uint16, e6522_set_uint32
+	mem_blk_set_fct (blk, sim,
+		mac_via_get_uint8, mac_via_get_uint16, mac_via_get_uint32,
+		mac_via_set_uint8, mac_via_set_uint16, mac_via_set_uint32
 	);
 
 	mem_add_blk (sim->mem, blk, 1);
@@ -1246,6 +1397,9 @@ void mac_init (macplus_t *sim, ini_sct_t *ini)
 	sim->speed_limit[0] = 1;
 	sim->speed_clock_extra = 0;
 
+	sim->idle_enable = 1;
+	sim->idle_clk = 0;
+
 	for (i = 1; i < PCE_MAC_SPEED_CNT; i++) {
 		sim->speed_limit[i] = 0;
 	}
@@ -1256,11 +1410,18 @@ void mac_init (macplus_t *sim, ini_sct_t *ini)
 		sim->clk_div[i] = 0;
 	}
 
+	sim->slice_clk = 0;
+	sim->slice_cpu = 0;
+	sim->slice_cpu_done = 0;
+	sim->slice_n = 0;
+	sim->slice_n_done = 0;
+
 	bps_init (&sim->bps);
 
 	mac_setup_system (sim, ini);
 	mac_setup_mem (sim, ini);
 	mac_setup_cpu (sim, ini);
+	mac_setup_idle (sim, ini);
 	mac_setup_via (sim, ini);
 	mac_setup_scc (sim, ini);
 	mac_setup_serial (sim, ini);
@@ -1478,6 +1639,9 @@ void mac_reset (macplus_t *sim)
 		adb_reset (sim->adb);
 	}
 
+	/* the sony driver patches have been removed from the ROM */
+	e68_icache_flush (sim->cpu);
+
 	e68_reset (sim->cpu);
 
 	mac_clock_discontinuity (sim);
@@ -1501,7 +1665,8 @@ void mac_realtime_sync (macplus_t *sim, unsigned long n)
 		if (us1 < us2) {
 			sim->sync_sleep += us2 - us1;
 
-			if (sim->sync_sleep > 0) {
+			/* don't speed up the CPU to make up for idle time */
+			if ((sim->sync_sleep > 0) && (sim->idle_clk == 0)) {
 				sim->speed_clock_extra += 1;
 			}
 		}
@@ -1523,40 +1688,31 @@ void mac_realtime_sync (macplus_t *sim, unsigned long n)
 			mac_log_deb ("system too slow, skipping 1 second\n");
 			sim->sync_sleep += 1000000;
 		}
+
+		sim->idle_clk = 0;
 	}
 }
 
-void mac_clock (macplus_t *sim, unsigned n)
+/*
+ * Clock the devices that are clocked with the VIA. n is the number of
+ * clocks and cpuclk the number of CPU clocks in the same time.
+ */
+static
+void mac_clock_dev (macplus_t *sim, unsigned long n, unsigned long cpuclk)
 {
-	unsigned long viaclk, clkdiv, cpuclk;
-
-	if (n == 0) {
-		n = sim->cpu->delay;
-		if (n == 0) {
-			n = 1;
-		}
-	}
-
-	if (sim->speed_factor == 0) {
-		cpuclk = n + sim->speed_clock_extra;
-		clkdiv = 1;
-	}
-	else {
-		cpuclk = n;
-		clkdiv = sim->speed_factor;
-	}
-
-	e68_clock (sim->cpu, cpuclk);
+	unsigned long viaclk, clkdiv;
 
 	mac_sound_clock (&sim->sound, cpuclk);
 
 	sim->clk_cnt += n;
 
+	clkdiv = (sim->speed_factor == 0) ? 1 : sim->speed_factor;
+
 	sim->clk_div[0] += n;
 
-	while (sim->clk_div[0] >= clkdiv) {
-		sim->clk_div[1] += 1;
-		sim->clk_div[0] -= clkdiv;
+	if (sim->clk_div[0] >= clkdiv) {
+		sim->clk_div[1] += sim->clk_div[0] / clkdiv;
+		sim->clk_div[0] %= clkdiv;
 	}
 
 	if (sim->clk_div[1] < 10) {
@@ -1575,8 +1731,16 @@ void mac_clock (macplus_t *sim, unsigned n)
 
 	sim->clk_div[1] -= 10 * viaclk;
 	sim->clk_div[2] += 10 * viaclk;
+}
 
-	if (sim->clk_div[2] < 256) {
+/*
+ * Clock the devices that are not clocked with the VIA at the end of
+ * each slice
+ */
+static
+void mac_clock_slow (macplus_t *sim)
+{
+	if (sim->clk_div[2] == 0) {
 		return;
 	}
 
@@ -1608,3 +1772,214 @@ void mac_clock (macplus_t *sim, unsigned n)
 
 	sim->clk_div[3] = 0;
 }
+
+/*
+ * Convert a delay in clocks of the devices that are clocked with the
+ * VIA into clocks. These devices are clocked in steps of 10 clocks.
+ */
+static
+unsigned long mac_get_via_delay (const macplus_t *sim, unsigned long n)
+{
+	if (n == 0) {
+		n = 1;
+	}
+
+	return (10 * ((n + 9) / 10) - sim->clk_div[1]);
+}
+
+/*
+ * Convert a delay in clocks of the devices that are clocked at the end
+ * of a slice into clocks
+ */
+static
+unsigned long mac_get_slow_delay (const macplus_t *sim, unsigned long n)
+{
+	n = (n > sim->clk_div[2]) ? (n - sim->clk_div[2]) : 1;
+
+	return (mac_get_via_delay (sim, n));
+}
+
+/*
+ * Get the number of clocks until the next device event. The IWM has no
+ * events, it is brought up to date when the CPU accesses it.
+ */
+static
+unsigned long mac_get_slice (macplus_t *sim)
+{
+	unsigned long n, tmp, clkdiv;
+
+	clkdiv = (sim->speed_factor == 0) ? 1 : sim->speed_factor;
+
+	/* the terminal check, the mouse and the real time clock */
+	n = mac_get_slow_delay (sim, 8192 - sim->clk_div[3]);
+
+	tmp = mac_get_via_delay (sim, 10 * e6522_get_delay (&sim->via));
+
+	if (tmp < n) {
+		n = tmp;
+	}
+
+	if (sim->adb != NULL) {
+		tmp = mac_get_via_delay (sim, mac_adb_get_delay (sim->adb));
+
+		if (tmp < n) {
+			n = tmp;
+		}
+	}
+
+	if (sim->video != NULL) {
+		tmp = mac_get_slow_delay (sim, mac_video_get_delay (sim->video));
+
+		if (tmp < n) {
+			n = tmp;
+		}
+	}
+
+	/* both serial ports clock the SCC */
+	tmp = mac_get_slow_delay (sim, mac_ser_get_delay (&sim->ser[0]) / 2);
+
+	if (tmp < n) {
+		n = tmp;
+	}
+
+	if (sim->kbd != NULL) {
+		tmp = mac_get_slow_delay (sim, mac_kbd_get_delay (sim->kbd));
+
+		if (tmp < n) {
+			n = tmp;
+		}
+	}
+
+	n = clkdiv * n - sim->clk_div[0];
+
+	/* the sound is clocked with the CPU clocks */
+	tmp = mac_sound_get_delay (&sim->sound);
+
+	if (tmp < MAC_DELAY_MAX) {
+		if (sim->speed_factor == 0) {
+			tmp = (8 * tmp) / (8 + sim->speed_clock_extra);
+		}
+
+		if (tmp == 0) {
+			tmp = 1;
+		}
+
+		if (tmp < n) {
+			n = tmp;
+		}
+	}
+
+	return (n);
+}
+
+void mac_clock_sync (macplus_t *sim)
+{
+	unsigned long cpuclk, n;
+
+	if (sim->slice_cpu == 0) {
+		return;
+	}
+
+	cpuclk = e68_get_clkcnt (sim->cpu) - sim->slice_clk;
+
+	if (cpuclk > sim->slice_cpu) {
+		cpuclk = sim->slice_cpu;
+	}
+
+	if (cpuclk <= sim->slice_cpu_done) {
+		return;
+	}
+
+	n = ((unsigned long long) cpuclk * sim->slice_n) / sim->slice_cpu;
+
+	mac_clock_dev (sim, n - sim->slice_n_done, cpuclk - sim->slice_cpu_done);
+
+	sim->slice_cpu_done = cpuclk;
+	sim->slice_n_done = n;
+}
+
+/*
+ * Run the CPU for up to n clocks and return the number of clocks that
+ * were run. The slice ends early if the CPU writes to a device that
+ * can change the time of the next event. The devices that are clocked
+ * with the VIA catch up when the CPU accesses them and at the end of
+ * the slice.
+ */
+static
+unsigned long mac_clock_cpu (macplus_t *sim, unsigned long n)
+{
+	unsigned long cpuclk;
+
+	if (sim->speed_factor == 0) {
+		/*
+		 * The CPU runs speed_clock_extra / 8 additional clocks per
+		 * clock. mac_realtime_sync() adjusts speed_clock_extra in
+		 * steps of 1, which is about one additional clock per
+		 * instruction for typical instructions of 8 to 10 clocks.
+		 */
+		cpuclk = n + ((n * sim->speed_clock_extra) >> 3);
+	}
+	else {
+		cpuclk = n;
+	}
+
+	sim->slice_clk = e68_get_clkcnt (sim->cpu);
+	sim->slice_cpu = cpuclk;
+	sim->slice_cpu_done = 0;
+	sim->slice_n = n;
+	sim->slice_n_done = 0;
+
+	e68_clock (sim->cpu, cpuclk);
+
+	mac_clock_sync (sim);
+
+	n = sim->slice_n_done;
+
+	sim->slice_cpu = 0;
+
+	mac_clock_slow (sim);
+
+	return (n);
+}
+
+void mac_clock (macplus_t *sim, unsigned n)
+{
+	unsigned long m;
+
+	if (n == 0) {
+		n = sim->cpu->delay;
+		if (n == 0) {
+			n = 1;
+		}
+	}
+
+	while (n > 0) {
+		m = mac_get_slice (sim);
+
+		if (m > n) {
+			m = n;
+		}
+
+		n -= mac_clock_cpu (sim, m);
+	}
+}
+
+void mac_clock_slice (macplus_t *sim)
+{
+	unsigned long n;
+
+	if (sim->idle_enable && e68_get_idle (sim->cpu)) {
+		n = mac_get_slice (sim);
+
+		e68_skip (sim->cpu, n);
+
+		sim->idle_clk += n;
+
+		mac_clock_dev (sim, n, n);
+		mac_clock_slow (sim);
+
+		return;
+	}
+
+	mac_clock_cpu (sim, mac_get_slice (sim));
+}
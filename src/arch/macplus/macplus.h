@@ -59,6 +59,24 @@
 #define PCE_MAC_SPEED_USER 0
 #define PCE_MAC_SPEED_IWM  1
 
+#define PCE_MAC_PAGE_CNT (0x01000000UL >> MEM_PAGE_BITS)
+
+
+/*****************************************************************************
+ * @short A page of the 24 bit CPU address space
+ *****************************************************************************/
+typedef struct {
+	/* Direct pointers to the page data or NULL */
+	unsigned char *rd;
+	unsigned char *wr;
+
+	/* The memory block that covers the whole page or NULL */
+	mem_blk_t     *blk;
+
+	/* The CPU address of the start of blk */
+	unsigned long base;
+} mac_page_t;
+
 
 /*****************************************************************************
  * @short The macplus context struct
@@ -76,6 +94,10 @@ struct macplus_s {
 	mem_blk_t          *ram_ovl;
 	mem_blk_t          *rom_ovl;
 
+	/* The CPU address space, rebuilt if page_gen != mem_map_gen */
+	unsigned long      page_gen;
+	mac_page_t         page[PCE_MAC_PAGE_CNT];
+
 	bp_set_t           bps;
 
 	e6522_t            via;
@@ -125,12 +147,30 @@ struct macplus_s {
 	unsigned           speed_limit[PCE_MAC_SPEED_CNT];
 	unsigned long      speed_clock_extra;
 
+	/* skip ahead in time while the guest is idle */
+	int                idle_enable;
+
+	/* the number of clocks skipped since the last sync */
+	unsigned long      idle_clk;
+
 	unsigned long      sync_clk;
 	unsigned long      sync_us;
 	long               sync_sleep;
 
 	unsigned long long clk_cnt;
 	unsigned long      clk_div[4];
+
+	/*
+	 * The current CPU time slice. The devices that are clocked with
+	 * the VIA have been clocked for slice_cpu_done of the slice_cpu
+	 * CPU clocks that started at CPU clock slice_clk. slice_cpu is 0
+	 * outside of a slice.
+	 */
+	unsigned long      slice_clk;
+	unsigned long      slice_cpu;
+	unsigned long      slice_cpu_done;
+	unsigned long      slice_n;
+	unsigned long      slice_n_done;
 };
 
 
@@ -168,16 +208,35 @@ int mac_set_msg_trm (macplus_t *sim, const char *msg, const char *val);
 
 int mac_set_cpu_model (macplus_t *sim, const char *model);
 
+void mac_setup_icache_rom (macplus_t *sim);
+
 /*****************************************************************************
  * @short Reset the simulator
  *****************************************************************************/
 void mac_reset (macplus_t *sim);
 
+/*****************************************************************************
+ * @short Bring the devices that are clocked with the VIA up to date
+ *
+ * This is called before the CPU accesses one of these devices while
+ * it is running a time slice.
+ *****************************************************************************/
+void mac_clock_sync (macplus_t *sim);
+
 /*****************************************************************************
  * @short Clock the simulator
- * @param n The number of clock cycles.
+ * @param n The number of clock cycles. If n is 0, the simulator is
+ *          clocked for one instruction.
  *****************************************************************************/
 void mac_clock (macplus_t *sim, unsigned n);
 
+/*****************************************************************************
+ * @short Clock the simulator up to the next device event
+ *
+ * The CPU runs until the next event of one of the devices or until it
+ * writes to the VIA or the SCC.
+ *****************************************************************************/
+void mac_clock_slice (macplus_t *sim);
+
 
 #endif
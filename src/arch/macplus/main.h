@@ -41,6 +41,9 @@
 
 #define MAC_CPU_CLOCK 7833600
 
+/* the delay returned by the device get_delay functions if there is no event */
+#define MAC_DELAY_MAX 0x10000000UL
+
 
 struct macplus_s;
 typedef struct macplus_s macplus_t;
@@ -113,6 +113,203 @@ int mac_addr_map (macplus_t *sim, unsigned long *addr)
 	return (0);
 }
 
+/*
+ * Map the CPU page at addr. Pages without a memory block of their own
+ * are mapped to the repeated RAM and ROM images. Writes to the
+ * repeated images go through mac_mem_set_uint*(), which invalidate
+ * the instruction cache.
+ */
+static
+void mac_map_page (macplus_t *sim, mac_page_t *mp, unsigned long addr, int mirror)
+{
+	unsigned long src;
+	mem_page_t    *pg;
+
+	mp->rd = NULL;
+	mp->wr = NULL;
+	mp->blk = NULL;
+	mp->base = 0;
+
+	src = addr;
+	pg = mem_get_page (sim->mem, addr);
+
+	if ((pg == NULL) || (pg->blk == NULL)) {
+		if ((mirror == 0) || (mac_addr_map (sim, &src) == 0)) {
+			return;
+		}
+
+		pg = mem_get_page (sim->mem, src);
+
+		if (pg == NULL) {
+			return;
+		}
+	}
+
+	if ((pg->blk == NULL) || (pg->blk == &mem_page_mixed)) {
+		return;
+	}
+
+	mp->rd = pg->rd;
+	mp->wr = (src == addr) ? pg->wr : NULL;
+	mp->blk = pg->blk;
+	mp->base = addr - (src - mem_blk_get_addr (pg->blk));
+}
+
+void mac_map_update (macplus_t *sim)
+{
+	unsigned long i;
+	int           mirror;
+
+	sim->page_gen = mem_map_gen;
+
+	/* the repeated images can only be mapped if they are whole pages */
+	mirror = 1;
+
+	if ((sim->ram != NULL) && (mem_blk_get_size (sim->ram) & MEM_PAGE_MASK)) {
+		mirror = 0;
+	}
+
+	if ((sim->rom != NULL) && (mem_blk_get_size (sim->rom) & MEM_PAGE_MASK)) {
+		mirror = 0;
+	}
+
+	for (i = 0; i < PCE_MAC_PAGE_CNT; i++) {
+		mac_map_page (sim, &sim->page[i], i << MEM_PAGE_BITS, mirror);
+	}
+}
+
+static inline
+mac_page_t *mac_get_page (macplus_t *sim, unsigned long addr)
+{
+	if (sim->page_gen != mem_map_gen) {
+		mac_map_update (sim);
+	}
+
+	return (&sim->page[(addr & 0x00ffffff) >> MEM_PAGE_BITS]);
+}
+
+unsigned char mac_get_uint8 (void *ext, unsigned long addr)
+{
+	macplus_t  *sim = ext;
+	mac_page_t *pg;
+
+	pg = mac_get_page (sim, addr);
+
+	if (pg->rd != NULL) {
+		return (pg->rd[addr & MEM_PAGE_MASK]);
+	}
+
+	if ((pg->blk != NULL) && (pg->blk->get_uint8 != NULL)) {
+		return (pg->blk->get_uint8 (pg->blk->ext, addr - pg->base));
+	}
+
+	return (mem_get_uint8 (sim->mem, addr));
+}
+
+unsigned short mac_get_uint16 (void *ext, unsigned long addr)
+{
+	macplus_t  *sim = ext;
+	mac_page_t *pg;
+
+	pg = mac_get_page (sim, addr);
+
+	if ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 1)) {
+		if (pg->rd != NULL) {
+			return (buf_get_uint16_be (pg->rd, addr & MEM_PAGE_MASK));
+		}
+
+		if ((pg->blk != NULL) && (pg->blk->get_uint16 != NULL)) {
+			return (pg->blk->get_uint16 (pg->blk->ext, addr - pg->base));
+		}
+	}
+
+	return (mem_get_uint16_be (sim->mem, addr));
+}
+
+unsigned long mac_get_uint32 (void *ext, unsigned long addr)
+{
+	macplus_t  *sim = ext;
+	mac_page_t *pg;
+
+	pg = mac_get_page (sim, addr);
+
+	if ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 3)) {
+		if (pg->rd != NULL) {
+			return (buf_get_uint32_be (pg->rd, addr & MEM_PAGE_MASK));
+		}
+
+		if ((pg->blk != NULL) && (pg->blk->get_uint32 != NULL)) {
+			return (pg->blk->get_uint32 (pg->blk->ext, addr - pg->base));
+		}
+	}
+
+	return (mem_get_uint32_be (sim->mem, addr));
+}
+
+void mac_set_uint8 (void *ext, unsigned long addr, unsigned char val)
+{
+	macplus_t  *sim = ext;
+	mac_page_t *pg;
+
+	pg = mac_get_page (sim, addr);
+
+	if (pg->wr != NULL) {
+		pg->wr[addr & MEM_PAGE_MASK] = val;
+		return;
+	}
+
+	if ((pg->blk != NULL) && (pg->blk->set_uint8 != NULL) && !pg->blk->readonly) {
+		pg->blk->set_uint8 (pg->blk->ext, addr - pg->base, val);
+		return;
+	}
+
+	mem_set_uint8 (sim->mem, addr, val);
+}
+
+void mac_set_uint16 (void *ext, unsigned long addr, unsigned short val)
+{
+	macplus_t  *sim = ext;
+	mac_page_t *pg;
+
+	pg = mac_get_page (sim, addr);
+
+	if ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 1)) {
+		if (pg->wr != NULL) {
+			buf_set_uint16_be (pg->wr, addr & MEM_PAGE_MASK, val);
+			return;
+		}
+
+		if ((pg->blk != NULL) && (pg->blk->set_uint16 != NULL) && !pg->blk->readonly) {
+			pg->blk->set_uint16 (pg->blk->ext, addr - pg->base, val);
+			return;
+		}
+	}
+
+	mem_set_uint16_be (sim->mem, addr, val);
+}
+
+void mac_set_uint32 (void *ext, unsigned long addr, unsigned long val)
+{
+	macplus_t  *sim = ext;
+	mac_page_t *pg;
+
+	pg = mac_get_page (sim, addr);
+
+	if ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 3)) {
+		if (pg->wr != NULL) {
+			buf_set_uint32_be (pg->wr, addr & MEM_PAGE_MASK, val);
+			return;
+		}
+
+		if ((pg->blk != NULL) && (pg->blk->set_uint32 != NULL) && !pg->blk->readonly) {
+			pg->blk->set_uint32 (pg->blk->ext, addr - pg->base, val);
+			return;
+		}
+	}
+
+	mem_set_uint32_be (sim->mem, addr, val);
+}
+
 unsigned char mac_mem_get_uint8 (void *ext, unsigned long addr)
 {
 	macplus_t *sim = ext;
@@ -126,6 +323,7 @@ unsigned char mac_mem_get_uint8 (void *ext, unsigned long addr)
 	}
 
 	if ((addr >= 0xc00000) && (addr < 0xe00000)) {
+		mac_clock_sync (sim);
 		return (mac_iwm_get_uint8 (&sim->iwm, addr - 0xc00000));
 	}
 
@@ -176,6 +374,7 @@ void mac_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 
 	if (mac_addr_map (sim, &addr)) {
 		mem_set_uint8 (sim->mem, addr, val);
+		e68_icache_invalidate (sim->cpu, addr, 1);
 	}
 
 	if ((addr >= 0x580000) && (addr < 0x600000)) {
@@ -183,6 +382,7 @@ void mac_mem_set_uint8 (void *ext, unsigned long addr, unsigned char val)
 	}
 
 	if ((addr >= 0xc00000) && (addr < 0xe00000)) {
+		mac_clock_sync (sim);
 		mac_iwm_set_uint8 (&sim->iwm, addr - 0xc00000, val);
 		return;
 	}
@@ -198,6 +398,7 @@ void mac_mem_set_uint16 (void *ext, unsigned long addr, unsigned short val)
 
 	if (mac_addr_map (sim, &addr)) {
 		mem_set_uint16_be (sim->mem, addr, val);
+		e68_icache_invalidate (sim->cpu, addr, 2);
 	}
 
 #ifdef DEBUG_MEM
@@ -211,6 +412,7 @@ void mac_mem_set_uint32 (void *ext, unsigned long addr, unsigned long val)
 
 	if (mac_addr_map (sim, &addr)) {
 		mem_set_uint32_be (sim->mem, addr, val);
+		e68_icache_invalidate (sim->cpu, addr, 4);
 	}
 
 #ifdef DEBUG_MEM
@@ -29,6 +29,29 @@
 
 void mac_set_overlay (macplus_t *sim, int overlay);
 
+/*!***************************************************************************
+ * @short Rebuild the CPU page table
+ *
+ * This is done automatically on the next CPU access after the memory
+ * map changed, e.g. by mac_set_overlay().
+ *****************************************************************************/
+void mac_map_update (macplus_t *sim);
+
+
+/*
+ * The CPU memory access functions. RAM, ROM and their repeated images
+ * are accessed through host pointers, memory mapped devices are called
+ * directly and everything else goes through sim->mem.
+ */
+unsigned char mac_get_uint8 (void *ext, unsigned long addr);
+unsigned short mac_get_uint16 (void *ext, unsigned long addr);
+unsigned long mac_get_uint32 (void *ext, unsigned long addr);
+
+void mac_set_uint8 (void *ext, unsigned long addr, unsigned char val);
+void mac_set_uint16 (void *ext, unsigned long addr, unsigned short val);
+void mac_set_uint32 (void *ext, unsigned long addr, unsigned long val);
+
+
 
 unsigned char mac_mem_get_uint8 (void *ext, unsigned long addr);
 unsigned short mac_mem_get_uint16 (void *ext, unsigned long addr);
@@ -256,6 +256,19 @@ void mac_ser_set_scc (mac_ser_t *ser, e8530_t *scc, unsigned chn)
 	e8530_set_cts (ser->scc, ser->chn, 1);
 }
 
+unsigned long mac_ser_get_delay (const mac_ser_t *ser)
+{
+	unsigned long n;
+
+	n = 32 * e8530_get_delay (ser->scc);
+
+	if (n <= ser->clk) {
+		return (1);
+	}
+
+	return ((n - ser->clk + 14) / 15);
+}
+
 void mac_ser_clock (mac_ser_t *ser, unsigned n)
 {
 	mac_ser_process_output (ser);
@@ -67,6 +67,11 @@ int mac_ser_set_driver (mac_ser_t *ser, const char *name);
 
 int mac_ser_set_file (mac_ser_t *ser, const char *fname);
 
+/*****************************************************************************
+ * @short Get the number of clocks until the next character time of the SCC
+ *****************************************************************************/
+unsigned long mac_ser_get_delay (const mac_ser_t *ser);
+
 void mac_ser_clock (mac_ser_t *ser, unsigned n);
 
 
@@ -294,6 +294,19 @@ void mac_sound_vbl (mac_sound_t *ms)
 	ms->clk = 0;
 }
 
+unsigned long mac_sound_get_delay (const mac_sound_t *ms)
+{
+	if ((ms->enable == 0) || (ms->sbuf == NULL) || (ms->cnt >= 370)) {
+		return (MAC_DELAY_MAX);
+	}
+
+	if (ms->clk >= MAC_SOUND_CLK) {
+		return (1);
+	}
+
+	return (MAC_SOUND_CLK - ms->clk);
+}
+
 void mac_sound_clock (mac_sound_t *ms, unsigned long n)
 {
 	unsigned cnt;
@@ -67,6 +67,12 @@ int mac_sound_set_driver (mac_sound_t *ms, const char *driver);
 
 void mac_sound_vbl (mac_sound_t *ms);
 
+/*****************************************************************************
+ * @short Get the number of CPU clocks until the next sample is read or
+ *        MAC_DELAY_MAX if no sample is read
+ *****************************************************************************/
+unsigned long mac_sound_get_delay (const mac_sound_t *ms);
+
 void mac_sound_clock (mac_sound_t *ms, unsigned long cnt);
 
 
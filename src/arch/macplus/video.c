@@ -246,6 +246,19 @@ void mac_video_redraw (mac_video_t *mv)
 	mac_video_update (mv);
 }
 
+unsigned long mac_video_get_delay (const mac_video_t *mv)
+{
+	if (mv->clk < MAC_VIDEO_VB1) {
+		return (MAC_VIDEO_VB1 - mv->clk);
+	}
+
+	if (mv->clk < MAC_VIDEO_VB2) {
+		return (MAC_VIDEO_VB2 - mv->clk);
+	}
+
+	return (1);
+}
+
 void mac_video_clock (mac_video_t *mv, unsigned long n)
 {
 	unsigned long old;
@@ -81,6 +81,12 @@ void mac_video_set_brightness (mac_video_t *mv, unsigned val);
 
 void mac_video_redraw (mac_video_t *mv);
 
+/*****************************************************************************
+ * @short Get the number of clocks until the vertical blanking interrupt
+ *        changes
+ *****************************************************************************/
+unsigned long mac_video_get_delay (const mac_video_t *mv);
+
 void mac_video_clock (mac_video_t *mv, unsigned long cnt);
 
 
@@ -755,6 +755,19 @@ void rc759_setup_ports (rc759_t *sim, ini_sct_t *ini)
 	);
 }
 
+static
+void rc759_update_mem_map (rc759_t *sim)
+{
+	unsigned long addr;
+	mem_page_t    *pg;
+
+	for (addr = 0; addr < (E86_MAP_CNT * E86_MAP_SIZE); addr += MEM_PAGE_SIZE) {
+		if ((pg = mem_get_page (sim->mem, addr)) != NULL) {
+			e86_set_mem_map (sim->cpu, addr, MEM_PAGE_SIZE, pg->rd, pg->wr);
+		}
+	}
+}
+
 static
 void rc759_setup_cpu (rc759_t *sim, ini_sct_t *ini)
 {
@@ -784,6 +797,8 @@ void rc759_setup_cpu (rc759_t *sim, ini_sct_t *ini)
 	else {
 		e86_set_ram (sim->cpu, NULL, 0);
 	}
+
+	e86_set_mem_map_fct (sim->cpu, sim, rc759_update_mem_map, &mem_map_gen);
 }
 
 static
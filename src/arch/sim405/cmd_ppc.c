@@ -989,6 +989,9 @@ void do_x (cmd_t *cmd, sim405_t *sim)
 
 int ppc_do_cmd (sim405_t *sim, cmd_t *cmd)
 {
+	/* memory may have been modified by a previous monitor command */
+	p405_icache_flush (sim->ppc);
+
 	if (cmd_match (cmd, "b")) {
 		cmd_do_b (cmd, &sim->bps);
 	}
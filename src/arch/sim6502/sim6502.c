@@ -26,6 +26,63 @@
 void s6502_break (sim6502_t *sim, unsigned char val);
 
 
+/*
+ * Get the data of the 256 byte page at addr if it is completely in
+ * one memory block that can be accessed directly, NULL otherwise.
+ */
+static
+unsigned char *s6502_get_page (sim6502_t *sim, unsigned long addr, int wr)
+{
+	unsigned  i;
+	mem_blk_t *blk;
+
+	blk = mem_get_blk (sim->mem, addr);
+
+	if ((blk == NULL) || (blk->data == NULL)) {
+		return (NULL);
+	}
+
+	if (wr) {
+		if (blk->readonly || (blk->set_uint8 != NULL)) {
+			return (NULL);
+		}
+	}
+	else {
+		if (blk->get_uint8 != NULL) {
+			return (NULL);
+		}
+	}
+
+	for (i = 1; i < 256; i++) {
+		if (mem_get_blk (sim->mem, addr + i) != blk) {
+			return (NULL);
+		}
+	}
+
+	return (blk->data + (addr - blk->addr1));
+}
+
+/*
+ * Map ram and rom into the CPU address space, so that the CPU
+ * can access them without going through the memory functions.
+ */
+static
+void s6502_map_update (sim6502_t *sim)
+{
+	unsigned long addr;
+	unsigned char *rd, *wr;
+
+	sim->mem_gen = mem_map_gen;
+
+	for (addr = 0; addr < 0x10000; addr += 256) {
+		rd = s6502_get_page (sim, addr, 0);
+		wr = s6502_get_page (sim, addr, 1);
+
+		e6502_set_mem_map_rd (sim->cpu, addr, addr + 256, rd);
+		e6502_set_mem_map_wr (sim->cpu, addr, addr + 256, wr);
+	}
+}
+
 static
 void s6502_setup_cpu (sim6502_t *sim, ini_sct_t *ini)
 {
@@ -78,6 +135,8 @@ sim6502_t *s6502_new (ini_sct_t *ini)
 
 	pce_load_mem_ini (sim->mem, ini);
 
+	s6502_map_update (sim);
+
 	return (sim);
 }
 
@@ -124,6 +183,10 @@ void s6502_clock (sim6502_t *sim, unsigned n)
 		con_check (&sim->console);
 	}
 
+	if (sim->mem_gen != mem_map_gen) {
+		s6502_map_update (sim);
+	}
+
 	e6502_clock (sim->cpu, n);
 }
 
@@ -76,6 +76,9 @@ typedef struct sim6502_s {
 	memory_t           *mem;
 	mem_blk_t          *ram;
 
+	/* the CPU memory map is rebuilt if mem_gen != mem_map_gen */
+	unsigned long      mem_gen;
+
 	console_t          console;
 
 	bp_set_t           bps;
@@ -0,0 +1,269 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/arch/sims32/bench/bench.s                                *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+/*
+ * A sims32 benchmark with deep call chains. It computes fib(FIB_N)
+ * recursively FIB_CNT times, which makes the calls go far deeper than
+ * the number of register windows. The window overflow and underflow
+ * traps spill and fill the windows on the stack. The result is
+ * written to UART0, after that the CPU loops forever.
+ *
+ * The image is loaded at address 0, where the CPU starts after a reset.
+ * bench.rom was built with:
+ *
+ *   llvm-mc -triple=sparc -filetype=obj -o bench.o bench.s
+ *   llvm-objcopy -O binary -j .text bench.o bench.rom
+ */
+
+
+	.equ	FIB_N, 24
+	.equ	FIB_CNT, 16
+
+	.equ	UART0, 0xef600300
+	.equ	STACK, 0x00100000
+
+/*
+ * %g5 is the UART base address
+ * %g6 is NWINDOWS - 1
+ * %g7 is the mask of implemented WIM bits
+ */
+
+
+	.text
+
+/* the trap table */
+
+	ba	start
+	nop
+	nop
+	nop
+
+	.rept	4
+	ba	bad
+	nop
+	nop
+	nop
+	.endr
+
+	ba	window_overflow
+	nop
+	nop
+	nop
+
+	ba	window_underflow
+	nop
+	nop
+	nop
+
+	.rept	249
+	ba	bad
+	nop
+	nop
+	nop
+	.endr
+
+
+/*
+ * The trap is taken in the invalid window, the window after it is
+ * saved to its stack and becomes the new invalid window.
+ */
+window_overflow:
+	rd	%wim, %l3
+	mov	%g1, %l7
+	srl	%l3, 1, %g1
+	sll	%l3, %g6, %l4
+	or	%l4, %g1, %g1
+	and	%g1, %g7, %g1
+
+	save
+	wr	%g1, 0, %wim
+	nop
+	nop
+	nop
+
+	std	%l0, [%sp + 0]
+	std	%l2, [%sp + 8]
+	std	%l4, [%sp + 16]
+	std	%l6, [%sp + 24]
+	std	%i0, [%sp + 32]
+	std	%i2, [%sp + 40]
+	std	%i4, [%sp + 48]
+	std	%i6, [%sp + 56]
+
+	restore
+	mov	%l7, %g1
+	jmp	%l1
+	rett	%l2
+
+
+/*
+ * The window after the current window is invalid. It is loaded from
+ * its stack and the window after it becomes the new invalid window.
+ */
+window_underflow:
+	rd	%wim, %l3
+	sll	%l3, 1, %l4
+	srl	%l3, %g6, %l5
+	or	%l5, %l4, %l5
+	and	%l5, %g7, %l5
+	wr	%l5, 0, %wim
+	nop
+	nop
+	nop
+
+	restore
+	restore
+
+	ldd	[%sp + 0], %l0
+	ldd	[%sp + 8], %l2
+	ldd	[%sp + 16], %l4
+	ldd	[%sp + 24], %l6
+	ldd	[%sp + 32], %i0
+	ldd	[%sp + 40], %i2
+	ldd	[%sp + 48], %i4
+	ldd	[%sp + 56], %i6
+
+	save
+	save
+	jmp	%l1
+	rett	%l2
+
+
+bad:
+	ba	bad
+	nop
+
+
+start:
+	/* supervisor mode, traps enabled, window 0 */
+	wr	%g0, 0xe0, %psr
+	nop
+	nop
+	nop
+
+	/* find the number of windows */
+	wr	%g0, -1, %wim
+	nop
+	nop
+	nop
+	rd	%wim, %g7
+
+	mov	%g7, %g1
+	mov	0, %g6
+1:
+	srl	%g1, 1, %g1
+	cmp	%g1, 0
+	bne	1b
+	add	%g6, 1, %g6
+
+	sub	%g6, 1, %g6
+
+	/* window 1 is the invalid window */
+	wr	%g0, 2, %wim
+	nop
+	nop
+	nop
+
+	set	UART0, %g5
+	/* leave room for the register save area of the first window */
+	set	STACK - 64, %sp
+	mov	0, %fp
+
+	set	FIB_CNT, %l0
+1:
+	call	fib
+	mov	FIB_N, %o0
+
+	subcc	%l0, 1, %l0
+	bne	1b
+	nop
+
+	call	puthex
+	nop
+
+	call	putc
+	mov	13, %o0
+
+	call	putc
+	mov	10, %o0
+
+done:
+	ba	done
+	nop
+
+
+/* return fib(%o0) in %o0 */
+fib:
+	save	%sp, -96, %sp
+
+	cmp	%i0, 2
+	bl	1f
+	nop
+
+	call	fib
+	sub	%i0, 1, %o0
+
+	st	%o0, [%fp - 4]
+
+	call	fib
+	sub	%i0, 2, %o0
+
+	ld	[%fp - 4], %l0
+	add	%l0, %o0, %i0
+1:
+	ret
+	restore
+
+
+/* write %o0 as a hex number */
+puthex:
+	save	%sp, -96, %sp
+
+	mov	%i0, %l0
+	mov	8, %l1
+1:
+	srl	%l0, 28, %o0
+	cmp	%o0, 10
+	bl	2f
+	add	%o0, 48, %o0
+	add	%o0, 7, %o0
+2:
+	call	putc
+	sll	%l0, 4, %l0
+
+	subcc	%l1, 1, %l1
+	bne	1b
+	nop
+
+	ret
+	restore
+
+
+/* write the character in %o0 */
+putc:
+	ldub	[%g5 + 5], %o1
+	andcc	%o1, 0x20, %g0
+	be	putc
+	nop
+
+	retl
+	stb	%o0, [%g5]
@@ -57,6 +57,10 @@ void ss32_setup_cpu (sims32_t *sim, ini_sct_t *ini)
 		&mem_set_uint16_be,
 		&mem_set_uint32_be
 	);
+
+	if (sim->ram != NULL) {
+		s32_set_ram (sim->cpu, mem_blk_get_data (sim->ram), mem_blk_get_size (sim->ram));
+	}
 }
 
 static
@@ -187,7 +191,9 @@ void ss32_break (sims32_t *sim, unsigned char val)
 
 void ss32_set_keycode (sims32_t *sim, unsigned char val)
 {
-	ser_receive (sim->serport[1], val);
+	if (sim->serport[1] != NULL) {
+		ser_receive (sim->serport[1], val);
+	}
 }
 
 void ss32_reset (sims32_t *sim)
@@ -197,7 +203,19 @@ void ss32_reset (sims32_t *sim)
 
 void ss32_clock (sims32_t *sim, unsigned n)
 {
+	unsigned      i;
+	unsigned long clk;
+
 	if (sim->clk_div[0] >= 1024) {
+		clk = sim->clk_div[0] & ~1023UL;
+
+		for (i = 0; i < 2; i++) {
+			if (sim->serport[i] != NULL) {
+				e8250_clock (&sim->serport[i]->uart, clk / 4);
+				ser_clock (sim->serport[i], clk);
+			}
+		}
+
 		scon_check (sim);
 
 		sim->clk_div[0] &= 1023;
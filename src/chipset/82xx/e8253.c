@@ -525,6 +525,56 @@ void e8253_reset (e8253_t *pit)
 	e8253_counter_reset (&pit->counter[2]);
 }
 
+/*
+ * Get the number of clocks until the counter output changes
+ */
+static
+unsigned long cnt_get_delay (const e8253_counter_t *cnt)
+{
+	if (cnt->counting == 0) {
+		return (E8253_DELAY_MAX);
+	}
+
+	switch (cnt->mode) {
+	case 0:
+		if ((cnt->gate == 0) || cnt->out_val) {
+			return (E8253_DELAY_MAX);
+		}
+
+		return ((cnt->val == 0) ? 65536 : cnt->val);
+
+	case 2:
+		return ((cnt->val > 1) ? (cnt->val - 1) : 1);
+
+	case 3:
+		return ((cnt->val > 1) ? (cnt->val >> 1) : 1);
+	}
+
+	return (E8253_DELAY_MAX);
+}
+
+unsigned long e8253_get_delay (const e8253_t *pit, unsigned mask)
+{
+	unsigned      i;
+	unsigned long ret, tmp;
+
+	ret = E8253_DELAY_MAX;
+
+	for (i = 0; i < 3; i++) {
+		if ((mask & (1U << i)) == 0) {
+			continue;
+		}
+
+		tmp = cnt_get_delay (&pit->counter[i]);
+
+		if (tmp < ret) {
+			ret = tmp;
+		}
+	}
+
+	return (ret);
+}
+
 void e8253_clock (e8253_t *pit, unsigned n)
 {
 	if (pit->counter[0].counting) {
@@ -27,6 +27,9 @@
 #define PCE_E8253_H 1
 
 
+#define E8253_DELAY_MAX 0x10000000UL
+
+
 /*!***************************************************************************
  * @short The PIT 8253 counter structure
  *****************************************************************************/
@@ -125,6 +128,18 @@ void e8253_set_uint32 (e8253_t *pit, unsigned long addr, unsigned long val);
  *****************************************************************************/
 void e8253_reset (e8253_t *pit);
 
+/*!***************************************************************************
+ * @short  Get the time until the next counter output change
+ * @param  pit  The PIT structure
+ * @param  mask The counters to consider (bit i for counter i)
+ * @return The number of clocks until the output of one of the counters
+ *         in mask changes or E8253_DELAY_MAX if no output will change
+ *
+ * A counter output never changes earlier than this, but it can change
+ * later.
+ *****************************************************************************/
+unsigned long e8253_get_delay (const e8253_t *pit, unsigned mask);
+
 void e8253_clock (e8253_t *pit, unsigned n);
 
 
@@ -896,6 +896,31 @@ void e6522_clock_t2 (e6522_t *via, unsigned long n)
 	}
 }
 
+unsigned long e6522_get_delay (const e6522_t *via)
+{
+	unsigned long ret, tmp;
+
+	ret = E6522_DELAY_MAX;
+
+	if (via->ier & E6522_IFR_T1) {
+		if ((via->acr & 0x40) || via->t1_hot) {
+			ret = (via->t1_val > 0) ? via->t1_val : 1;
+		}
+	}
+
+	if (via->ier & E6522_IFR_T2) {
+		if (((via->acr & 0x20) == 0) && via->t2_hot) {
+			tmp = (via->t2_val > 0) ? via->t2_val : 1;
+
+			if (tmp < ret) {
+				ret = tmp;
+			}
+		}
+	}
+
+	return (ret);
+}
+
 void e6522_clock (e6522_t *via, unsigned long n)
 {
 	e6522_clock_t1 (via, n);
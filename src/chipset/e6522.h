@@ -27,6 +27,9 @@
 #define PCE_CHIPSET_E6522_H 1
 
 
+#define E6522_DELAY_MAX 0x10000000UL
+
+
 typedef struct {
 	unsigned       addr_shift;
 
@@ -121,6 +124,12 @@ void e6522_set_uint32 (e6522_t *via, unsigned long addr, unsigned long val);
 
 void e6522_reset (e6522_t *via);
 
+/*
+ * Get the number of clocks until the next enabled timer interrupt or
+ * E6522_DELAY_MAX if no timer interrupt is pending
+ */
+unsigned long e6522_get_delay (const e6522_t *via);
+
 void e6522_clock (e6522_t *via, unsigned long n);
 
 
@@ -926,6 +926,42 @@ void e68901_clock_usart (e68901_t *mfp, unsigned n)
 	}
 }
 
+unsigned long e68901_get_delay (const e68901_t *mfp)
+{
+	unsigned             i, cnt;
+	unsigned long        ret, tmp;
+	const e68901_timer_t *tmr;
+
+	ret = E68901_DELAY_MAX;
+
+	for (i = 0; i < 4; i++) {
+		tmr = &mfp->timer[i];
+
+		if ((mfp->ier & tmr->int_mask) == 0) {
+			continue;
+		}
+
+		if ((tmr->clk_div == 0) || ((tmr->cr & 0x07) == 0)) {
+			continue;
+		}
+
+		if ((tmr->cr & 8) && (tmr->inp == 0)) {
+			continue;
+		}
+
+		cnt = (tmr->dr[0] == 0) ? 256 : tmr->dr[0];
+
+		tmp = (unsigned long) cnt * tmr->clk_div;
+		tmp = (tmr->clk_val < tmp) ? (tmp - tmr->clk_val) : 1;
+
+		if (tmp < ret) {
+			ret = tmp;
+		}
+	}
+
+	return (ret);
+}
+
 void e68901_clock (e68901_t *mfp, unsigned n)
 {
 	unsigned i;
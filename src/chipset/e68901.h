@@ -27,6 +27,9 @@
 #define PCE_CHIPSET_E68901_H 1
 
 
+#define E68901_DELAY_MAX 0x10000000UL
+
+
 typedef struct {
 	unsigned short int_mask;
 	unsigned char  cr;
@@ -116,6 +119,12 @@ void e68901_set_uint32 (e68901_t *mfp, unsigned long addr, unsigned long val);
 
 int e68901_receive (e68901_t *mfp, unsigned char val);
 
+/*
+ * Get the number of clocks until the next enabled timer interrupt or
+ * E68901_DELAY_MAX if no timer interrupt is pending
+ */
+unsigned long e68901_get_delay (const e68901_t *mfp);
+
 void e68901_reset (e68901_t *mfp);
 
 void e68901_clock_usart (e68901_t *mfp, unsigned n);
@@ -1200,6 +1200,19 @@ void e8530_reset (e8530_t *scc)
 	e8530_set_irq (scc, 0);
 }
 
+unsigned long e8530_get_delay (const e8530_t *scc)
+{
+	unsigned long ret;
+
+	ret = scc->chn[0].char_clk_cnt;
+
+	if (scc->chn[1].char_clk_cnt < ret) {
+		ret = scc->chn[1].char_clk_cnt;
+	}
+
+	return ((ret > 0) ? ret : 1);
+}
+
 static inline
 void e8530_chn_clock (e8530_t *scc, unsigned chn, unsigned n)
 {
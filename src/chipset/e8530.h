@@ -140,6 +140,13 @@ int e8530_inp_full (e8530_t *scc, unsigned chn);
 int e8530_out_empty (e8530_t *scc, unsigned chn);
 
 void e8530_reset (e8530_t *scc);
+
+/*
+ * Get the number of clocks until the next character time of one of
+ * the channels
+ */
+unsigned long e8530_get_delay (const e8530_t *scc);
+
 void e8530_clock (e8530_t *scc, unsigned n);
 
 
@@ -170,23 +170,27 @@ typedef struct arm_copr_s {
 } arm_copr_t;
 
 
+/* the number of entries in each translation buffer */
+#define ARM_TBUF_SIZE 256
+
+/*
+ * A translation buffer entry maps a 4K virtual page to a real page. The
+ * tag contains the virtual page, the privilege level of the access in
+ * bit 1 and a valid bit in bit 0.
+ */
 typedef struct {
-	int      valid;
-
-	uint32_t vaddr;
-	uint32_t vmask;
-
+	uint32_t tag;
 	uint32_t raddr;
-	uint32_t rmask;
 } arm_tbuf_t;
 
 
 typedef struct {
 	arm_copr_t copr;
 
-	arm_tbuf_t tbuf_exec;
-	arm_tbuf_t tbuf_read;
-	arm_tbuf_t tbuf_write;
+	/* direct mapped translation buffers, indexed by virtual page */
+	arm_tbuf_t tbuf_exec[ARM_TBUF_SIZE];
+	arm_tbuf_t tbuf_read[ARM_TBUF_SIZE];
+	arm_tbuf_t tbuf_write[ARM_TBUF_SIZE];
 
 	uint32_t   reg[16];
 
@@ -53,6 +53,12 @@ void cp15_init (arm_copr15_t *p)
 
 	p->cache_type = 0;
 	p->auxiliary_control = 0;
+
+	for (i = 0; i < ARM_TBUF_SIZE; i++) {
+		p->tbuf_exec[i].tag = 0;
+		p->tbuf_read[i].tag = 0;
+		p->tbuf_write[i].tag = 0;
+	}
 }
 
 arm_copr_t *cp15_new (void)
@@ -251,10 +257,12 @@ int cp15_set_reg8 (arm_t *c, arm_copr15_t *p)
 		switch (op2) {
 		case 0x00:
 			/* invalidate entire instruction tlb */
+			arm_tbuf_flush (c);
 			return (0);
 
 		case 0x01:
 			/* invalidate instruction tlb single entry */
+			arm_tbuf_flush_addr (c, arm_get_rd (c, c->ir));
 			return (0);
 		}
 	}
@@ -262,10 +270,12 @@ int cp15_set_reg8 (arm_t *c, arm_copr15_t *p)
 		switch (op2) {
 		case 0x00:
 			/* invalidate entire data tlb */
+			arm_tbuf_flush (c);
 			return (0);
 
 		case 0x01:
 			/* invalidate data tlb single entry */
+			arm_tbuf_flush_addr (c, arm_get_rd (c, c->ir));
 			return (0);
 		}
 	}
@@ -273,10 +283,12 @@ int cp15_set_reg8 (arm_t *c, arm_copr15_t *p)
 		switch (op2) {
 		case 0x00:
 			/* invalidate entire unified tlb */
+			arm_tbuf_flush (c);
 			return (0);
 
 		case 0x01:
 			/* invalidate unified tlb single entry */
+			arm_tbuf_flush_addr (c, arm_get_rd (c, c->ir));
 			return (0);
 		}
 	}
@@ -372,21 +384,21 @@ int cp15_op_mcr (arm_t *c, arm_copr_t *p)
 
 	val = arm_get_rd (c, c->ir);
 
-	/* conservative flushing of translation buffer */
-	arm_tbuf_flush (c);
-
 	switch (arm_ir_rn (c->ir)) {
 	case 0x00: /* id register */
 		return (1);
 
 	case 0x01: /* control register */
+		arm_tbuf_flush (c);
 		return (cp15_set_reg1 (c, p15, op2, val));
 
 	case 0x02: /* translation table base */
+		arm_tbuf_flush (c);
 		p15->reg[2] = val & 0xffffc000;
 		break;
 
 	case 0x03: /* domain access control */
+		arm_tbuf_flush (c);
 		p15->reg[3] = val & 0xffffffff;
 		break;
 
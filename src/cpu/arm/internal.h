@@ -56,6 +56,9 @@ int arm_dstore8_t (arm_t *c, uint32_t addr, uint8_t val);
 int arm_dstore16_t (arm_t *c, uint32_t addr, uint16_t val);
 int arm_dstore32_t (arm_t *c, uint32_t addr, uint32_t val);
 
+void arm_tbuf_flush (arm_t *c);
+void arm_tbuf_flush_addr (arm_t *c, uint32_t addr);
+
 
 /*****************************************************************************
  * arm
@@ -143,17 +146,6 @@ uint32_t arm_asr32 (uint32_t v, unsigned n)
 	return (v);
 }
 
-static inline
-void arm_tbuf_flush (arm_t *c)
-{
-	arm_copr15_t *mmu = arm_get_mmu (c);
-
-	mmu->tbuf_exec.valid = 0;
-	mmu->tbuf_read.valid = 0;
-	mmu->tbuf_write.valid = 0;
-}
-
-
 int arm_write_cpsr (arm_t *c, uint32_t val, int prvchk);
 
 int arm_check_cond (arm_t *c, unsigned cond);
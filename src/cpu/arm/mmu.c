@@ -74,14 +74,71 @@ void arm_mmu_permission_fault (arm_t *c, uint32_t addr, unsigned domn, int sect)
 }
 
 
+void arm_tbuf_flush (arm_t *c)
+{
+	unsigned     i;
+	arm_copr15_t *mmu;
+
+	mmu = arm_get_mmu (c);
+
+	for (i = 0; i < ARM_TBUF_SIZE; i++) {
+		mmu->tbuf_exec[i].tag = 0;
+		mmu->tbuf_read[i].tag = 0;
+		mmu->tbuf_write[i].tag = 0;
+	}
+}
+
+/*
+ * Invalidate the translation buffer entries for the virtual address addr.
+ * A single entry in the page tables can map up to 1M, so all entries
+ * in the same 1M region are invalidated.
+ */
+void arm_tbuf_flush_addr (arm_t *c, uint32_t addr)
+{
+	unsigned     i;
+	arm_copr15_t *mmu;
+
+	mmu = arm_get_mmu (c);
+
+	addr &= 0xfff00000;
+
+	for (i = 0; i < ARM_TBUF_SIZE; i++) {
+		if ((mmu->tbuf_exec[i].tag & 0xfff00000) == addr) {
+			mmu->tbuf_exec[i].tag = 0;
+		}
+
+		if ((mmu->tbuf_read[i].tag & 0xfff00000) == addr) {
+			mmu->tbuf_read[i].tag = 0;
+		}
+
+		if ((mmu->tbuf_write[i].tag & 0xfff00000) == addr) {
+			mmu->tbuf_write[i].tag = 0;
+		}
+	}
+}
+
+static inline
+uint32_t arm_tbuf_tag (uint32_t vaddr, int priv)
+{
+	return ((vaddr & 0xfffff000) | (priv ? 0x02 : 0x00) | 0x01);
+}
+
 static inline
-void arm_tbuf_set (arm_tbuf_t *tb, uint32_t vaddr, uint32_t raddr, uint32_t mask)
+arm_tbuf_t *arm_tbuf_get (arm_tbuf_t *tbuf, uint32_t vaddr)
 {
-	tb->vaddr = vaddr & mask;
-	tb->vmask = mask;
-	tb->raddr = raddr & mask;
-	tb->rmask = ~mask;
-	tb->valid = 1;
+	return (&tbuf[(vaddr >> 12) & (ARM_TBUF_SIZE - 1)]);
+}
+
+static inline
+void arm_tbuf_set (arm_tbuf_t *tb, uint32_t tag, uint32_t raddr, uint32_t mask)
+{
+	if (mask & 0x00000c00) {
+		/* tiny pages are not buffered */
+		return;
+	}
+
+	tb->tag = tag;
+	tb->raddr = raddr & 0xfffff000;
 }
 
 
@@ -255,7 +312,15 @@ int arm_translate (arm_t *c, uint32_t *addr, uint32_t *mask,
 		/* small page */
 		ap = 4 + 2 * arm_get_bits (*addr, 10, 2);
 		*addr = (desc2 & 0xfffff000) | (*addr & 0x00000fff);
-		*mask = 0xfffff000;
+
+		if (((desc2 >> 4) & 0xff) == (((desc2 >> 4) & 0x03) * 0x55)) {
+			*mask = 0xfffff000;
+		}
+		else {
+			/* the 1K subpages have different permissions */
+			*mask = 0xfffffc00;
+		}
+
 		*perm = arm_get_bits (desc2, ap, 2);
 		return (0);
 
@@ -288,7 +353,8 @@ int arm_translate_exec (arm_t *c, uint32_t *addr, int priv)
 	arm_copr15_t *mmu;
 	unsigned     domn, perm;
 	int          sect;
-	uint32_t     vaddr, mask;
+	uint32_t     vaddr, mask, tag;
+	arm_tbuf_t   *tb;
 
 	mmu = arm_get_mmu (c);
 
@@ -297,14 +363,12 @@ int arm_translate_exec (arm_t *c, uint32_t *addr, int priv)
 	}
 
 	vaddr = *addr;
+	tag = arm_tbuf_tag (vaddr, priv);
+	tb = arm_tbuf_get (mmu->tbuf_exec, vaddr);
 
-	if (mmu->tbuf_exec.valid) {
-		arm_tbuf_t *tb = &mmu->tbuf_exec;
-
-		if ((vaddr & tb->vmask) == tb->vaddr) {
-			*addr = tb->raddr | (vaddr & tb->rmask);
-			return (0);
-		}
+	if (tb->tag == tag) {
+		*addr = tb->raddr | (vaddr & 0x00000fff);
+		return (0);
 	}
 
 	if (arm_translate (c, addr, &mask, &domn, &perm, &sect)) {
@@ -323,14 +387,14 @@ int arm_translate_exec (arm_t *c, uint32_t *addr, int priv)
 			arm_exception_prefetch_abort (c);
 			return (1);
 		}
-		arm_tbuf_set (&mmu->tbuf_exec, vaddr, *addr, mask);
+		arm_tbuf_set (tb, tag, *addr, mask);
 		return (0);
 
 	case 0x02: /* undefined */
 		return (0);
 
 	case 0x03: /* manager */
-		arm_tbuf_set (&mmu->tbuf_exec, vaddr, *addr, mask);
+		arm_tbuf_set (tb, tag, *addr, mask);
 		return (0);
 	}
 
@@ -343,7 +407,8 @@ int arm_translate_read (arm_t *c, uint32_t *addr, int priv)
 	arm_copr15_t *mmu;
 	unsigned     domn, perm;
 	int          sect;
-	uint32_t     vaddr, mask;
+	uint32_t     vaddr, mask, tag;
+	arm_tbuf_t   *tb;
 
 	mmu = arm_get_mmu (c);
 
@@ -352,14 +417,12 @@ int arm_translate_read (arm_t *c, uint32_t *addr, int priv)
 	}
 
 	vaddr = *addr;
+	tag = arm_tbuf_tag (vaddr, priv);
+	tb = arm_tbuf_get (mmu->tbuf_read, vaddr);
 
-	if (mmu->tbuf_read.valid) {
-		arm_tbuf_t *tb = &mmu->tbuf_read;
-
-		if ((vaddr & tb->vmask) == tb->vaddr) {
-			*addr = tb->raddr | (vaddr & tb->rmask);
-			return (0);
-		}
+	if (tb->tag == tag) {
+		*addr = tb->raddr | (vaddr & 0x00000fff);
+		return (0);
 	}
 
 	if (arm_translate (c, addr, &mask, &domn, &perm, &sect)) {
@@ -378,14 +441,14 @@ int arm_translate_read (arm_t *c, uint32_t *addr, int priv)
 			arm_mmu_permission_fault (c, vaddr, domn, sect);
 			return (1);
 		}
-		arm_tbuf_set (&mmu->tbuf_read, vaddr, *addr, mask);
+		arm_tbuf_set (tb, tag, *addr, mask);
 		return (0);
 
 	case 0x02: /* undefined */
 		return (0);
 
 	case 0x03: /* manager */
-		arm_tbuf_set (&mmu->tbuf_read, vaddr, *addr, mask);
+		arm_tbuf_set (tb, tag, *addr, mask);
 		return (0);
 	}
 
@@ -398,7 +461,8 @@ int arm_translate_write (arm_t *c, uint32_t *addr, int priv)
 	arm_copr15_t *mmu;
 	unsigned     domn, perm;
 	int          sect;
-	uint32_t     vaddr, mask;
+	uint32_t     vaddr, mask, tag;
+	arm_tbuf_t   *tb;
 
 	mmu = arm_get_mmu (c);
 
@@ -407,14 +471,12 @@ int arm_translate_write (arm_t *c, uint32_t *addr, int priv)
 	}
 
 	vaddr = *addr;
+	tag = arm_tbuf_tag (vaddr, priv);
+	tb = arm_tbuf_get (mmu->tbuf_write, vaddr);
 
-	if (mmu->tbuf_write.valid) {
-		arm_tbuf_t *tb = &mmu->tbuf_write;
-
-		if ((vaddr & tb->vmask) == tb->vaddr) {
-			*addr = tb->raddr | (vaddr & tb->rmask);
-			return (0);
-		}
+	if (tb->tag == tag) {
+		*addr = tb->raddr | (vaddr & 0x00000fff);
+		return (0);
 	}
 
 	if (arm_translate (c, addr, &mask, &domn, &perm, &sect)) {
@@ -434,7 +496,7 @@ int arm_translate_write (arm_t *c, uint32_t *addr, int priv)
 			return (1);
 		}
 
-		arm_tbuf_set (&mmu->tbuf_write, vaddr, *addr, mask);
+		arm_tbuf_set (tb, tag, *addr, mask);
 
 		return (0);
 
@@ -442,7 +504,7 @@ int arm_translate_write (arm_t *c, uint32_t *addr, int priv)
 		return (0);
 
 	case 0x03: /* manager */
-		arm_tbuf_set (&mmu->tbuf_write, vaddr, *addr, mask);
+		arm_tbuf_set (tb, tag, *addr, mask);
 		return (0);
 	}
 
@@ -64,8 +64,6 @@ int arm_write_cpsr (arm_t *c, uint32_t val, int prvchk)
 
 	c->privileged = ((val & 0x1f) != ARM_MODE_USR);
 
-	arm_tbuf_flush (c);
-
 	return (0);
 }
 
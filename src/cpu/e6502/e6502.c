@@ -52,7 +52,7 @@ void e6502_init (e6502_t *c)
 	c->get_uint8 = NULL;
 	c->set_uint8 = NULL;
 
-	for (i = 0; i < 64; i++) {
+	for (i = 0; i < 256; i++) {
 		c->mem_map_rd[i] = NULL;
 		c->mem_map_wr[i] = NULL;
 	}
@@ -100,26 +100,26 @@ void e6502_del (e6502_t *c)
 void e6502_set_mem_map_rd (e6502_t *c, unsigned addr1, unsigned addr2, unsigned char *p)
 {
 	while (addr1 < addr2) {
-		c->mem_map_rd[(addr1 >> 10) & 0x3f] = p;
+		c->mem_map_rd[(addr1 >> 8) & 0xff] = p;
 
 		if (p != NULL) {
-			p += 1024;
+			p += 256;
 		}
 
-		addr1 += 1024;
+		addr1 += 256;
 	}
 }
 
 void e6502_set_mem_map_wr (e6502_t *c, unsigned addr1, unsigned addr2, unsigned char *p)
 {
 	while (addr1 < addr2) {
-		c->mem_map_wr[(addr1 >> 10) & 0x3f] = p;
+		c->mem_map_wr[(addr1 >> 8) & 0xff] = p;
 
 		if (p != NULL) {
-			p += 1024;
+			p += 256;
 		}
 
-		addr1 += 1024;
+		addr1 += 256;
 	}
 }
 
@@ -78,8 +78,8 @@ typedef struct e6502_t {
 	void               *set_ioport_ext;
 	void               (*set_ioport) (void *ext, unsigned char val);
 
-	unsigned char      *mem_map_rd[64];
-	unsigned char      *mem_map_wr[64];
+	unsigned char      *mem_map_rd[256];
+	unsigned char      *mem_map_wr[256];
 
 	void               *hook_ext;
 	int                (*hook_all) (void *ext, unsigned char op);
@@ -149,10 +149,10 @@ unsigned char e6502_get_mem8 (e6502_t *c, unsigned short addr)
 		return (e6502_get_ioport_8 (c, addr));
 	}
 
-	p = c->mem_map_rd[(addr >> 10) & 0x3f];
+	p = c->mem_map_rd[(addr >> 8) & 0xff];
 
 	if (p != NULL) {
-		return (p[addr & 0x3ff]);
+		return (p[addr & 0xff]);
 	}
 
 	return (c->get_uint8 (c->mem_rd_ext, addr));
@@ -168,10 +168,10 @@ void e6502_set_mem8 (e6502_t *c, unsigned short addr, unsigned char val)
 		return;
 	}
 
-	p = c->mem_map_wr[(addr >> 10) & 0x3f];
+	p = c->mem_map_wr[(addr >> 8) & 0xff];
 
 	if (p != NULL) {
-		p[addr & 0x3ff] = val;
+		p[addr & 0xff] = val;
 	}
 	else {
 		c->set_uint8 (c->mem_wr_ext, addr, val);
@@ -209,7 +209,22 @@ void e6502_free (e6502_t *c);
 void e6502_del (e6502_t *c);
 
 
+/*****************************************************************************
+ * @short Map memory for reading
+ * @param addr1 The first address, a multiple of 256
+ * @param addr2 The address after the last address
+ * @param p     The memory at addr1 or NULL to use the get_uint8 function
+ *
+ * The address space is mapped in pages of 256 bytes.
+ *****************************************************************************/
 void e6502_set_mem_map_rd (e6502_t *c, unsigned addr1, unsigned addr2, unsigned char *p);
+
+/*****************************************************************************
+ * @short Map memory for writing
+ * @param addr1 The first address, a multiple of 256
+ * @param addr2 The address after the last address
+ * @param p     The memory at addr1 or NULL to use the set_uint8 function
+ *****************************************************************************/
 void e6502_set_mem_map_wr (e6502_t *c, unsigned addr1, unsigned addr2, unsigned char *p);
 
 /*****************************************************************************
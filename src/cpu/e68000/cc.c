@@ -24,49 +24,15 @@
 #include "internal.h"
 
 
-void e68_cc_set_nz_8 (e68000_t *c, uint8_t msk, uint8_t val)
-{
-	uint16_t set = 0;
-
-	if ((val & 0xff) == 0) {
-		set |= E68_SR_Z;
-	}
-	else if (val & 0x80) {
-		set |= E68_SR_N;
-	}
-
-	c->sr &= (0xff00 | ~msk);
-	c->sr |= (set & msk);
-}
-
-void e68_cc_set_nz_16 (e68000_t *c, uint8_t msk, uint16_t val)
-{
-	uint16_t set = 0;
-
-	if ((val & 0xffff) == 0) {
-		set |= E68_SR_Z;
-	}
-	else if (val & 0x8000) {
-		set |= E68_SR_N;
-	}
-
-	c->sr &= (0xff00 | ~msk);
-	c->sr |= (set & msk);
-}
-
-void e68_cc_set_nz_32 (e68000_t *c, uint8_t msk, uint32_t val)
+/*
+ * Evaluate the pending flags in msk and store them in sr
+ */
+void e68_cc_flush (e68000_t *c, unsigned msk)
 {
-	uint16_t set = 0;
+	msk &= c->lcc.msk;
 
-	if ((val & 0xffffffff) == 0) {
-		set |= E68_SR_Z;
-	}
-	else if (val & 0x80000000) {
-		set |= E68_SR_N;
-	}
-
-	c->sr &= (0xff00 | ~msk);
-	c->sr |= (set & msk);
+	c->sr = (c->sr & ~msk) | e68_cc_eval (c, msk);
+	c->lcc.msk &= ~msk;
 }
 
 /*
@@ -105,28 +71,11 @@ void e68_cc_set_add (e68000_t *c, unsigned d, unsigned s1, unsigned s2)
 		}
 	}
 
-	c->sr &= ~(E68_SR_X | E68_SR_N | E68_SR_V | E68_SR_C);
+	c->lcc.msk &= ~E68_SR_XNVC;
+	c->sr &= ~E68_SR_XNVC;
 	c->sr |= set;
 }
 
-void e68_cc_set_add_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
-{
-	e68_set_sr_z (c, (d & 0xff) == 0);
-	e68_cc_set_add (c, d >> 7, s1 >> 7, s2 >> 7);
-}
-
-void e68_cc_set_add_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
-{
-	e68_set_sr_z (c, (d & 0xffff) == 0);
-	e68_cc_set_add (c, d >> 15, s1 >> 15, s2 >> 15);
-}
-
-void e68_cc_set_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
-{
-	e68_set_sr_z (c, (d & 0xffffffff) == 0);
-	e68_cc_set_add (c, d >> 31, s1 >> 31, s2 >> 31);
-}
-
 void e68_cc_set_addx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
 	e68_cc_set_add (c, d >> 7, s1 >> 7, s2 >> 7);
@@ -155,6 +104,7 @@ void e68_cc_set_addx_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 }
 
 
+
 /*
  * Set NVC after subtraction (s2 - s1)
  *
@@ -191,70 +141,17 @@ void e68_cc_set_sub (e68000_t *c, uint16_t msk, unsigned d, unsigned s1, unsigne
 		}
 	}
 
+	c->lcc.msk &= ~msk;
 	c->sr &= ~msk;
 	c->sr |= (set & msk);
 }
 
-void e68_cc_set_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
-{
-	e68_cc_set_sub (c, E68_SR_NZVC, d >> 7, s1 >> 7, s2 >> 7);
-
-	if ((d & 0xff) == 0) {
-		c->sr |= E68_SR_Z;
-	}
-}
-
-void e68_cc_set_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
-{
-	e68_cc_set_sub (c, E68_SR_NZVC, d >> 15, s1 >> 15, s2 >> 15);
-
-	if ((d & 0xffff) == 0) {
-		c->sr |= E68_SR_Z;
-	}
-}
-
-void e68_cc_set_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
-{
-	e68_cc_set_sub (c, E68_SR_NZVC, d >> 31, s1 >> 31, s2 >> 31);
-
-	if ((d & 0xffffffff) == 0) {
-		c->sr |= E68_SR_Z;
-	}
-}
-
-void e68_cc_set_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
-{
-	e68_cc_set_sub (c, E68_SR_XNZVC, d >> 7, s1 >> 7, s2 >> 7);
-
-	if ((d & 0xff) == 0) {
-		c->sr |= E68_SR_Z;
-	}
-}
-
-void e68_cc_set_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
-{
-	e68_cc_set_sub (c, E68_SR_XNZVC, d >> 15, s1 >> 15, s2 >> 15);
-
-	if ((d & 0xffff) == 0) {
-		c->sr |= E68_SR_Z;
-	}
-}
-
-void e68_cc_set_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
-{
-	e68_cc_set_sub (c, E68_SR_XNZVC, d >> 31, s1 >> 31, s2 >> 31);
-
-	if ((d & 0xffffffff) == 0) {
-		c->sr |= E68_SR_Z;
-	}
-}
-
 void e68_cc_set_subx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
 {
 	e68_cc_set_sub (c, E68_SR_XNVC, d >> 7, s1 >> 7, s2 >> 7);
 
 	if (d & 0xff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 }
 
@@ -263,7 +160,7 @@ void e68_cc_set_subx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
 	e68_cc_set_sub (c, E68_SR_XNVC, d >> 15, s1 >> 15, s2 >> 15);
 
 	if (d & 0xffff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 }
 
@@ -272,6 +169,6 @@ void e68_cc_set_subx_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
 	e68_cc_set_sub (c, E68_SR_XNVC, d >> 31, s1 >> 31, s2 >> 31);
 
 	if (d & 0xffffffff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 }
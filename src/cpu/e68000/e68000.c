@@ -47,6 +47,16 @@ void e68_init (e68000_t *c)
 	c->ram = NULL;
 	c->ram_cnt = 0;
 
+	c->ic_addr = 1;
+	c->ic_cur = NULL;
+	c->ic_cur_op = NULL;
+	c->ic = NULL;
+	c->ic_pgen = NULL;
+	c->ic_prom = NULL;
+
+	c->jit = NULL;
+	c->jit_disable = 0;
+
 	c->reset_ext = NULL;
 	c->reset = NULL;
 	c->reset_val = 0;
@@ -71,6 +81,8 @@ void e68_init (e68000_t *c)
 	c->int_nmi = 0;
 
 	c->delay = 1;
+	c->clk_rem = 0;
+	c->clk_break = 0;
 
 	c->except_cnt = 0;
 	c->except_addr = 0;
@@ -84,6 +96,9 @@ void e68_init (e68000_t *c)
 
 	c->sr = E68_SR_S;
 
+	c->lcc.op = E68_LCC_NZ;
+	c->lcc.msk = 0;
+
 	for (i = 0; i < 8; i++) {
 		e68_set_dreg32 (c, i, 0);
 		e68_set_areg32 (c, i, 0);
@@ -109,6 +124,14 @@ void e68_init (e68000_t *c)
 
 	c->last_trap_a = 0;
 	c->last_trap_f = 0;
+
+	c->pc_hist = 1;
+
+	e68_set_exec (c);
+
+	c->idle_range_cnt = 0;
+
+	e68_idle_reset (c);
 }
 
 e68000_t *e68_new (void)
@@ -127,6 +150,7 @@ e68000_t *e68_new (void)
 
 void e68_free (e68000_t *c)
 {
+	e68_set_icache (c, 0);
 }
 
 void e68_del (e68000_t *c)
@@ -161,6 +185,8 @@ void e68_set_ram (e68000_t *c, unsigned char *ram, unsigned long cnt)
 
 	c->ram = ram;
 	c->ram_cnt = cnt;
+
+	e68_icache_flush (c);
 }
 
 void e68_set_reset_fct (e68000_t *c, void *ext, void *fct)
@@ -181,6 +207,16 @@ void e68_set_hook_fct (e68000_t *c, void *ext, void *fct)
 	c->hook = fct;
 }
 
+void e68_set_pc_history (e68000_t *c, int enable)
+{
+	c->pc_hist = (enable != 0);
+
+	/* translated code records the history too */
+	e68_jit_flush (c);
+
+	e68_set_exec (c);
+}
+
 void e68_set_flags (e68000_t *c, unsigned flags, int set)
 {
 	if (set) {
@@ -525,7 +561,15 @@ void e68_set_sr (e68000_t *c, unsigned short val)
 		e68_set_supervisor (c, (val & E68_SR_S) != 0);
 	}
 
-	c->sr = val & E68_SR_MASK;
+	c->lcc.msk = 0;
+
+	if ((c->sr ^ val) & E68_SR_T) {
+		c->sr = val & E68_SR_MASK;
+		e68_set_exec (c);
+	}
+	else {
+		c->sr = val & E68_SR_MASK;
+	}
 }
 
 static
@@ -761,31 +805,12 @@ void e68_reset (e68000_t *c)
 	e68_set_reset (c, 0);
 }
 
-void e68_execute (e68000_t *c)
+/*
+ * Recognize pending interrupts after an instruction
+ */
+static
+void e68_check_interrupts (e68000_t *c)
 {
-	if (c->halt == 0) {
-		c->last_pc[++c->last_pc_idx & (E68_LAST_PC_CNT - 1)] = e68_get_pc (c);
-		c->bus_error = 0;
-		c->trace_sr = e68_get_sr (c);
-
-		c->ir[0] = c->ir[1];
-
-		c->opcodes[(c->ir[0] >> 6) & 0x3ff] (c);
-
-		c->oprcnt += 1;
-
-		if (c->trace_sr & E68_SR_T) {
-			e68_exception_trace (c);
-		}
-	}
-	else {
-		e68_set_clk (c, 4);
-
-		if (c->halt & ~1U) {
-			return;
-		}
-	}
-
 	if (c->int_nmi) {
 		c->halt &= ~1U;
 		e68_exception_avec (c, 7);
@@ -817,6 +842,94 @@ void e68_execute (e68000_t *c)
 	}
 }
 
+/*
+ * The instruction loop. It is instantiated below with hist and trace
+ * as constants. The trace bookkeeping is only needed while the trace
+ * bit is set, e68_set_sr() selects a new variant when it changes.
+ * The trace exception is taken after an instruction that started
+ * with the trace bit set, so an instruction that sets the bit is
+ * still executed by a variant without trace bookkeeping.
+ *
+ * The CPU model and the address check are not template parameters.
+ * The address check flag is only read for odd addresses, after the
+ * address test, and the model flags only on exception and rare EA
+ * paths. A 68000 with and without address checks and a 68010 run a
+ * move/add/shift/branch loop at the same speed (within 1%).
+ */
+static inline
+void e68_execute_tmpl (e68000_t *c, int hist, int trace)
+{
+	if (c->halt == 0) {
+		if (hist) {
+			c->last_pc[++c->last_pc_idx & (E68_LAST_PC_CNT - 1)] = e68_get_pc (c);
+		}
+
+		c->bus_error = 0;
+
+		if (trace) {
+			c->trace_sr = c->sr;
+		}
+
+		c->ir[0] = c->ir[1];
+
+		e68_get_op (c) (c);
+
+		c->oprcnt += 1;
+
+		if (trace && (c->trace_sr & E68_SR_T)) {
+			e68_exception_trace (c);
+		}
+	}
+	else {
+		e68_set_clk (c, 4);
+
+		if (c->halt & ~1U) {
+			return;
+		}
+	}
+
+	e68_check_interrupts (c);
+}
+
+static
+void e68_execute_hist (e68000_t *c)
+{
+	e68_execute_tmpl (c, 1, 0);
+}
+
+static
+void e68_execute_hist_trace (e68000_t *c)
+{
+	e68_execute_tmpl (c, 1, 1);
+}
+
+static
+void e68_execute_fast (e68000_t *c)
+{
+	e68_execute_tmpl (c, 0, 0);
+}
+
+static
+void e68_execute_trace (e68000_t *c)
+{
+	e68_execute_tmpl (c, 0, 1);
+}
+
+void e68_set_exec (e68000_t *c)
+{
+	if (c->sr & E68_SR_T) {
+		c->exec = c->pc_hist ? e68_execute_hist_trace : e68_execute_trace;
+	}
+	else {
+		c->exec = c->pc_hist ? e68_execute_hist : e68_execute_fast;
+	}
+}
+
+void e68_execute (e68000_t *c)
+{
+	c->exec (c);
+}
+
 void e68_clock (e68000_t *c, unsigned long n)
 {
 	while (n >= c->delay) {
@@ -825,7 +938,19 @@ void e68_clock (e68000_t *c, unsigned long n)
 		c->clkcnt += c->delay;
 		c->delay = 0;
 
-		e68_execute (c);
+		c->clk_rem = n;
+
+		/*
+		 * A translated block executes as many instructions as
+		 * fit into n clock cycles and accumulates their clock
+		 * cycles in c->delay.
+		 */
+		if ((c->jit != NULL) && (e68_jit_exec (c, n) > 0)) {
+			e68_check_interrupts (c);
+		}
+		else {
+			c->exec (c);
+		}
 
 		if (c->delay == 0) {
 			fprintf (stderr, "warning: delay == 0 at %08lx\n",
@@ -834,8 +959,33 @@ void e68_clock (e68000_t *c, unsigned long n)
 			fflush (stderr);
 			break;
 		}
+
+		if (c->clk_break) {
+			c->clk_break = 0;
+			c->clk_rem = 0;
+			return;
+		}
 	}
 
+	c->clk_rem = 0;
+
 	c->clkcnt += n;
 	c->delay -= n;
 }
+
+void e68_clock_break (e68000_t *c)
+{
+	c->clk_break = 1;
+}
+
+void e68_skip (e68000_t *c, unsigned long n)
+{
+	if (n < c->delay) {
+		c->delay -= n;
+	}
+	else {
+		c->delay = 0;
+	}
+
+	c->clkcnt += n;
+}
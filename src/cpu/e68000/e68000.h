@@ -33,6 +33,7 @@
 
 
 struct e68000_s;
+struct e68_jit_t;
 
 
 /*****************************************************************************
@@ -46,6 +47,15 @@ struct e68000_s;
 
 #define E68_LAST_PC_CNT 32
 
+#define E68_IDLE_RANGE_CNT 8
+
+/* the instruction cache */
+#define E68_IC_BITS      12
+#define E68_IC_CNT       (1U << E68_IC_BITS)
+#define E68_IC_LINE      16
+#define E68_IC_PAGE_BITS 12
+#define E68_IC_PAGE_CNT  (0x01000000UL >> E68_IC_PAGE_BITS)
+
 #define E68_SR_C 0x0001
 #define E68_SR_V 0x0002
 #define E68_SR_Z 0x0004
@@ -55,6 +65,11 @@ struct e68000_s;
 #define E68_SR_S 0x2000
 #define E68_SR_T 0x8000
 
+/* lazy condition code operations */
+#define E68_LCC_NZ  0
+#define E68_LCC_ADD 1
+#define E68_LCC_SUB 2
+
 #define e68_get_dreg8(c, n) ((c)->dreg[(n) & 7] & 0xff)
 #define e68_get_dreg16(c, n) ((c)->dreg[(n) & 7] & 0xffff)
 #define e68_get_dreg32(c, n) ((c)->dreg[(n) & 7] & 0xffffffff)
@@ -64,8 +79,8 @@ struct e68000_s;
 #define e68_get_ir_pc(c) ((c)->ir_pc & 0xffffffff)
 #define e68_get_usp(c) (((c)->supervisor ? (c)->usp : (c)->areg[7]) & 0xffffffff)
 #define e68_get_ssp(c) (((c)->supervisor ? (c)->areg[7] : (c)->ssp) & 0xffffffff)
-#define e68_get_sr(c) ((c)->sr & 0xffff)
-#define e68_get_ccr(c) ((c)->sr & 0xff)
+#define e68_get_sr(c) (e68_get_cc ((c), 0xffff) & 0xffff)
+#define e68_get_ccr(c) (e68_get_cc ((c), 0xff) & 0xff)
 #define e68_get_vbr(c) ((c)->vbr & 0xffffffff)
 #define e68_get_sfc(c) ((c)->sfc & 0x00000003)
 #define e68_get_dfc(c) ((c)->dfc & 0x00000003)
@@ -82,16 +97,20 @@ struct e68000_s;
 #define e68_set_cacr(c, v) do { (c)->cacr = (v) & 0xffffffff; } while (0)
 #define e68_set_caar(c, v) do { (c)->cacr = (v) & 0xffffffff; } while (0)
 
-#define e68_get_sr_c(c) (((c)->sr & E68_SR_C) != 0)
-#define e68_get_sr_v(c) (((c)->sr & E68_SR_V) != 0)
-#define e68_get_sr_z(c) (((c)->sr & E68_SR_Z) != 0)
-#define e68_get_sr_n(c) (((c)->sr & E68_SR_N) != 0)
-#define e68_get_sr_x(c) (((c)->sr & E68_SR_X) != 0)
+#define e68_get_sr_c(c) (e68_get_cc ((c), E68_SR_C) != 0)
+#define e68_get_sr_v(c) (e68_get_cc ((c), E68_SR_V) != 0)
+#define e68_get_sr_z(c) (e68_get_cc ((c), E68_SR_Z) != 0)
+#define e68_get_sr_n(c) (e68_get_cc ((c), E68_SR_N) != 0)
+#define e68_get_sr_x(c) (e68_get_cc ((c), E68_SR_X) != 0)
+
+/* these flags are never evaluated lazily */
 #define e68_get_sr_s(c) (((c)->sr & E68_SR_S) != 0)
 #define e68_get_sr_t(c) (((c)->sr & E68_SR_T) != 0)
 
 #define e68_set_cc(c, m, v) do { \
-		if (v) (c)->sr |= (m); else (c)->sr &= ~(m); \
+		int e68_cc_v = ((v) != 0); \
+		(c)->lcc.msk &= ~(m); \
+		if (e68_cc_v) (c)->sr |= (m); else (c)->sr &= ~(m); \
 	} while (0)
 
 #define e68_set_sr_c(c, v) e68_set_cc ((c), E68_SR_C, (v))
@@ -107,6 +126,19 @@ struct e68000_s;
 typedef void (*e68_opcode_f) (struct e68000_s *c);
 
 
+/*
+ * An instruction cache line, holding the instruction words of
+ * E68_IC_LINE bytes at addr and the opcode handlers for them. The line
+ * is valid if gen is equal to the generation number of its page.
+ */
+typedef struct {
+	uint32_t      addr;
+	unsigned long gen;
+	uint16_t      ir[E68_IC_LINE / 2];
+	e68_opcode_f  op[E68_IC_LINE / 2];
+} e68_icache_ent_t;
+
+
 typedef struct e68000_s {
 	unsigned       flags;
 
@@ -123,6 +155,29 @@ typedef struct e68000_s {
 	unsigned char  *ram;
 	unsigned long  ram_cnt;
 
+	/*
+	 * The instruction cache. ic_cur is the line at ic_addr that
+	 * instructions are currently fetched from and ic_cur_op are its
+	 * opcode handlers. ic_addr is 1 if there is no current line.
+	 */
+	uint32_t           ic_addr;
+	const uint16_t     *ic_cur;
+	const e68_opcode_f *ic_cur_op;
+	e68_icache_ent_t   *ic;
+	unsigned long      *ic_pgen;
+	unsigned char      *ic_prom;
+
+	struct e68_jit_t *jit;
+
+	/* if non-zero, translated code is not used (single stepping) */
+	int              jit_disable;
+
+	/* the execution loop variant, selected by e68_set_exec() */
+	void             (*exec) (struct e68000_s *c);
+
+	/* if zero, the last PC history is not recorded */
+	int              pc_hist;
+
 	void           *reset_ext;
 	void           (*reset) (void *ext, unsigned char val);
 	unsigned char  reset_val;
@@ -146,6 +201,20 @@ typedef struct e68000_s {
 	uint32_t       ir_pc;
 	uint16_t       ir[3];
 	uint16_t       sr;
+
+	/*
+	 * The last condition code setting operation. The flags in msk are
+	 * not valid in sr and must be computed from op, s1, s2 and dst.
+	 * The operands are shifted left so that their sign bit is bit 31.
+	 */
+	struct {
+		unsigned       op;
+		unsigned       msk;
+		uint32_t       s1;
+		uint32_t       s2;
+		uint32_t       dst;
+	} lcc;
+
 	uint32_t       usp;
 	uint32_t       ssp;
 	uint32_t       vbr;
@@ -176,6 +245,12 @@ typedef struct e68000_s {
 
 	unsigned long  delay;
 
+	/* the clock cycles left in the current call to e68_clock() */
+	unsigned long  clk_rem;
+
+	/* if non-zero, e68_clock() returns after the current instruction */
+	int            clk_break;
+
 	unsigned       except_cnt;
 	uint32_t       except_addr;
 	unsigned       except_vect;
@@ -184,11 +259,94 @@ typedef struct e68000_s {
 	unsigned long  oprcnt;
 	unsigned long  clkcnt;
 
+	/*
+	 * The idle loop detector. idle_addr and idle_size are the last
+	 * polling loop found, idle_pc and idle_reg are the state in
+	 * which it was last seen.
+	 */
+	uint32_t       idle_prev;
+	uint32_t       idle_bad;
+	uint32_t       idle_addr;
+	uint32_t       idle_size;
+	uint32_t       idle_pc;
+	unsigned       idle_except;
+	unsigned long  idle_opcnt;
+	uint32_t       idle_reg[17];
+
+	unsigned       idle_range_cnt;
+	uint32_t       idle_range[2 * E68_IDLE_RANGE_CNT];
+
 	e68_opcode_f   opcodes[1024];
 	e68_opcode_f   op49c0[8];
+
+	/* the opcode handlers indexed by the full opcode word */
+	e68_opcode_f   ops[65536];
 } e68000_t;
 
 
+/*!***************************************************************************
+ * @short Evaluate lazy condition codes
+ * @param msk The flags to evaluate
+ * @return The flags in msk as computed from the last flag setting operation
+ *****************************************************************************/
+static inline
+unsigned e68_cc_eval (const e68000_t *c, unsigned msk)
+{
+	unsigned set;
+	uint32_t d, s1, s2;
+
+	d = c->lcc.dst;
+	s1 = c->lcc.s1;
+	s2 = c->lcc.s2;
+
+	set = 0;
+
+	if (d == 0) {
+		set |= E68_SR_Z;
+	}
+	else if (d & 0x80000000) {
+		set |= E68_SR_N;
+	}
+
+	if ((msk & (E68_SR_X | E68_SR_V | E68_SR_C)) == 0) {
+		return (set & msk);
+	}
+
+	if (c->lcc.op == E68_LCC_ADD) {
+		if (((s1 & s2) | (~d & s1) | (~d & s2)) & 0x80000000) {
+			set |= E68_SR_X | E68_SR_C;
+		}
+
+		if (((~d & s1 & s2) | (d & ~s1 & ~s2)) & 0x80000000) {
+			set |= E68_SR_V;
+		}
+	}
+	else if (c->lcc.op == E68_LCC_SUB) {
+		if (((s1 & ~s2) | (d & ~s2) | (d & s1)) & 0x80000000) {
+			set |= E68_SR_X | E68_SR_C;
+		}
+
+		if (((~d & ~s1 & s2) | (d & s1 & ~s2)) & 0x80000000) {
+			set |= E68_SR_V;
+		}
+	}
+
+	return (set & msk);
+}
+
+/*!***************************************************************************
+ * @short Get status register bits, including lazily evaluated flags
+ *****************************************************************************/
+static inline
+unsigned e68_get_cc (const e68000_t *c, unsigned msk)
+{
+	if (c->lcc.msk & msk) {
+		return (((c->sr & ~c->lcc.msk) | e68_cc_eval (c, c->lcc.msk & msk)) & msk);
+	}
+
+	return (c->sr & msk);
+}
+
 
 static inline
 void e68_set_dreg8 (e68000_t *c, unsigned reg, uint8_t val)
@@ -289,6 +447,24 @@ uint32_t e68_get_mem32 (e68000_t *c, uint32_t addr)
 	return (c->get_uint32 (c->mem_ext, addr));
 }
 
+/*
+ * Invalidate the instruction cache lines in the page that contains addr
+ */
+static inline
+void e68_icache_write (e68000_t *c, uint32_t addr)
+{
+	unsigned long *pg;
+
+	if (c->ic_pgen != NULL) {
+		pg = c->ic_pgen + ((addr & 0x00ffffff) >> E68_IC_PAGE_BITS);
+
+		if (*pg & 1) {
+			*pg += 1;
+			c->ic_addr = 1;
+		}
+	}
+}
+
 static inline
 void e68_set_mem8 (e68000_t *c, uint32_t addr, uint8_t val)
 {
@@ -302,6 +478,7 @@ void e68_set_mem8 (e68000_t *c, uint32_t addr, uint8_t val)
 
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+		e68_icache_write (c, addr);
 	}
 	else {
 		c->set_uint8 (c->mem_ext, addr, val);
@@ -322,6 +499,8 @@ void e68_set_mem16 (e68000_t *c, uint32_t addr, uint16_t val)
 	if ((addr + 1) < c->ram_cnt) {
 		c->ram[addr] = (val >> 8) & 0xff;
 		c->ram[addr + 1] = val & 0xff;
+		e68_icache_write (c, addr);
+		e68_icache_write (c, addr + 1);
 	}
 	else {
 		c->set_uint16 (c->mem_ext, addr, val);
@@ -344,6 +523,8 @@ void e68_set_mem32 (e68000_t *c, uint32_t addr, uint32_t val)
 		c->ram[addr + 1] = (val >> 16) & 0xff;
 		c->ram[addr + 2] = (val >> 8) & 0xff;
 		c->ram[addr + 3] = val & 0xff;
+		e68_icache_write (c, addr);
+		e68_icache_write (c, addr + 3);
 	}
 	else {
 		c->set_uint32 (c->mem_ext, addr, val);
@@ -382,6 +563,60 @@ void e68_set_mem_fct (e68000_t *c, void *ext,
 
 void e68_set_ram (e68000_t *c, unsigned char *ram, unsigned long cnt);
 
+/*!***************************************************************************
+ * @short  Enable or disable the instruction cache
+ * @return Non-zero on error
+ *
+ * The instruction cache holds instruction words from ram and from pages
+ * marked with e68_set_icache_rom(). Writes to ram through the CPU
+ * invalidate the cached words of the page. Writes to memory that bypass
+ * the CPU must be reported with e68_icache_invalidate().
+ *****************************************************************************/
+int e68_set_icache (e68000_t *c, int enable);
+
+/*!***************************************************************************
+ * @short Mark pages as ROM for the instruction cache
+ * @param addr The start address, a multiple of the page size
+ * @param size The size in bytes, a multiple of the page size
+ * @param rom  If true, instructions in these pages are cached
+ *
+ * The contents of ROM pages must not change while they are marked.
+ *****************************************************************************/
+void e68_set_icache_rom (e68000_t *c, unsigned long addr, unsigned long size,
+	int rom
+);
+
+/*!***************************************************************************
+ * @short Invalidate the instruction cache for a memory range
+ *****************************************************************************/
+void e68_icache_invalidate (e68000_t *c, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short Invalidate the entire instruction cache
+ *****************************************************************************/
+void e68_icache_flush (e68000_t *c);
+
+/*!***************************************************************************
+ * @short  Enable or disable the dynamic translator
+ *
+ * The translator is only available on x86-64 Linux hosts. It implies
+ * the instruction cache. Interrupts are recognized between
+ * instructions as usual, but the clock count is only updated at the
+ * end of a translated block.
+ *
+ * @return Non-zero if the translator is not available
+ *****************************************************************************/
+int e68_set_jit (e68000_t *c, int enable);
+
+/*!***************************************************************************
+ * @short Enable or disable the last PC history
+ *
+ * The history is enabled by default. Disabling it makes instruction
+ * execution a little faster but e68_get_last_pc() then returns stale
+ * addresses.
+ *****************************************************************************/
+void e68_set_pc_history (e68000_t *c, int enable);
+
 void e68_set_reset_fct (e68000_t *c, void *ext, void *fct);
 
 void e68_set_inta_fct (e68000_t *c, void *ext, void *fct);
@@ -509,9 +744,50 @@ void e68_execute (e68000_t *c);
 
 /*!***************************************************************************
  * @short Clock a 68000 cpu core
+ *
+ * If e68_clock_break() is called while executing an instruction,
+ * e68_clock() returns after that instruction and the remaining clock
+ * cycles are not used.
  *****************************************************************************/
 void e68_clock (e68000_t *c, unsigned long n);
 
+/*!***************************************************************************
+ * @short Make the current call to e68_clock() return early
+ *
+ * This is used by devices that are accessed by the CPU, if the access
+ * changes the time of the next device event.
+ *****************************************************************************/
+void e68_clock_break (e68000_t *c);
+
+/*!***************************************************************************
+ * @short Advance the clock by n cycles without executing instructions
+ *
+ * This is used to fast forward over idle loops.
+ *****************************************************************************/
+void e68_skip (e68000_t *c, unsigned long n);
+
+
+/*****************************************************************************
+ * idle
+ *****************************************************************************/
+
+/*!***************************************************************************
+ * @short  Add an address range in which the CPU is considered idle
+ * @return Non-zero if there are too many ranges
+ *****************************************************************************/
+int e68_add_idle_range (e68000_t *c, unsigned long addr, unsigned long size);
+
+/*!***************************************************************************
+ * @short Check if the CPU is idle
+ *
+ * The CPU is idle if it is stopped, if the PC is in one of the idle
+ * ranges or if it is in a short loop that only reads RAM and it was
+ * in exactly the same state before. It is never idle if an interrupt
+ * is pending. This is called between calls to e68_clock(), often
+ * enough to see the PC in a polling loop more than once.
+ *****************************************************************************/
+int e68_get_idle (e68000_t *c);
+
 
 /*****************************************************************************
  * disasm
@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e68000/icache.c                                      *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include "e68000.h"
+#include "internal.h"
+
+#include <stdlib.h>
+
+
+/*
+ * The instruction cache holds the instruction words of E68_IC_LINE byte
+ * lines, indexed by address, together with their opcode handlers.
+ * e68_prefetch() reads the instruction words from the current line and
+ * only calls e68_icache_fetch() when the prefetch address leaves it.
+ * Instructions are cached from ram and from ROM pages, all other
+ * fetches go through the memory functions.
+ *
+ * The handlers are looked up in the opcode word table once, when a
+ * line is loaded, instead of for every executed instruction.
+ * e68_get_op() uses the handler from the current line if the opcode
+ * was fetched from it. The cache is flushed when the opcode word
+ * table changes.
+ *
+ * Each page has a generation number. The lowest bit of the generation
+ * number is set if there are cached lines in the page. A write to such
+ * a page increments the generation number, which invalidates all lines
+ * in that page. ROM pages are never invalidated by writes.
+ *
+ * The cached words are always the same as the words in memory, so the
+ * prefetch queue behaves exactly as without the cache.
+ */
+
+
+static
+void e68_icache_clear (e68000_t *c)
+{
+	unsigned long i;
+
+	/* translated code depends on the page generation numbers */
+	e68_jit_flush (c);
+
+	c->ic_addr = 1;
+
+	if (c->ic != NULL) {
+		for (i = 0; i < E68_IC_CNT; i++) {
+			c->ic[i].addr = 1;
+			c->ic[i].gen = 0;
+		}
+	}
+
+	if (c->ic_pgen != NULL) {
+		for (i = 0; i < E68_IC_PAGE_CNT; i++) {
+			c->ic_pgen[i] = 0;
+		}
+	}
+}
+
+int e68_set_icache (e68000_t *c, int enable)
+{
+	unsigned long i;
+
+	if (enable == 0) {
+		e68_set_jit (c, 0);
+
+		free (c->ic);
+		free (c->ic_pgen);
+		free (c->ic_prom);
+
+		c->ic = NULL;
+		c->ic_pgen = NULL;
+		c->ic_prom = NULL;
+
+		c->ic_addr = 1;
+
+		return (0);
+	}
+
+	if (c->ic != NULL) {
+		return (0);
+	}
+
+	c->ic = malloc (E68_IC_CNT * sizeof (e68_icache_ent_t));
+	c->ic_pgen = malloc (E68_IC_PAGE_CNT * sizeof (unsigned long));
+	c->ic_prom = malloc (E68_IC_PAGE_CNT);
+
+	if ((c->ic == NULL) || (c->ic_pgen == NULL) || (c->ic_prom == NULL)) {
+		e68_set_icache (c, 0);
+		return (1);
+	}
+
+	for (i = 0; i < E68_IC_PAGE_CNT; i++) {
+		c->ic_prom[i] = 0;
+	}
+
+	e68_icache_clear (c);
+
+	return (0);
+}
+
+void e68_set_icache_rom (e68000_t *c, unsigned long addr, unsigned long size,
+	int rom)
+{
+	unsigned long i, n;
+
+	if ((c->ic_prom == NULL) || (size == 0)) {
+		return;
+	}
+
+	i = (addr & 0x00ffffff) >> E68_IC_PAGE_BITS;
+	n = size >> E68_IC_PAGE_BITS;
+
+	while ((n > 0) && (i < E68_IC_PAGE_CNT)) {
+		c->ic_prom[i] = (rom != 0);
+
+		i += 1;
+		n -= 1;
+	}
+
+	e68_icache_flush (c);
+}
+
+void e68_icache_invalidate (e68000_t *c, unsigned long addr, unsigned long cnt)
+{
+	unsigned long i, n;
+
+	if ((c->ic_pgen == NULL) || (cnt == 0)) {
+		return;
+	}
+
+	addr &= 0x00ffffff;
+
+	i = addr >> E68_IC_PAGE_BITS;
+	n = (addr + cnt - 1) >> E68_IC_PAGE_BITS;
+
+	while ((i <= n) && (i < E68_IC_PAGE_CNT)) {
+		if (c->ic_pgen[i] & 1) {
+			c->ic_pgen[i] += 1;
+			c->ic_addr = 1;
+		}
+
+		i += 1;
+	}
+}
+
+void e68_icache_flush (e68000_t *c)
+{
+	unsigned long i;
+
+	if (c->ic_pgen == NULL) {
+		return;
+	}
+
+	for (i = 0; i < E68_IC_PAGE_CNT; i++) {
+		if (c->ic_pgen[i] & 1) {
+			c->ic_pgen[i] += 1;
+		}
+	}
+
+	c->ic_addr = 1;
+}
+
+/*
+ * Make the line that contains ir_pc the current line and get the word
+ * at ir_pc into ir[2]. Returns non-zero if ir_pc is not cacheable.
+ */
+int e68_icache_fetch (e68000_t *c)
+{
+	unsigned         i;
+	uint32_t         addr, line;
+	unsigned long    *pg;
+	e68_icache_ent_t *ent;
+
+	line = c->ir_pc & ~(uint32_t) (E68_IC_LINE - 1);
+	addr = line & 0x00ffffff;
+
+	pg = &c->ic_pgen[addr >> E68_IC_PAGE_BITS];
+	ent = &c->ic[((line / E68_IC_LINE) ^ (line >> 16)) & (E68_IC_CNT - 1)];
+
+	if ((ent->addr != line) || (ent->gen != *pg)) {
+		if ((addr | ((1UL << E68_IC_PAGE_BITS) - 1)) >= c->ram_cnt) {
+			if (c->ic_prom[addr >> E68_IC_PAGE_BITS] == 0) {
+				return (1);
+			}
+		}
+
+		*pg |= 1;
+
+		ent->addr = line;
+		ent->gen = *pg;
+
+		for (i = 0; i < (E68_IC_LINE / 2); i++) {
+			ent->ir[i] = e68_get_mem16 (c, addr + 2 * i);
+			ent->op[i] = c->ops[ent->ir[i]];
+		}
+	}
+
+	c->ic_addr = line;
+	c->ic_cur = ent->ir;
+	c->ic_cur_op = ent->op;
+
+	c->ir[2] = ent->ir[(c->ir_pc & (E68_IC_LINE - 1)) >> 1];
+
+	return (0);
+}
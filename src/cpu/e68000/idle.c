@@ -0,0 +1,423 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e68000/idle.c                                        *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include "e68000.h"
+#include "internal.h"
+
+
+/*
+ * A polling loop is a short loop that ends with a branch back to its
+ * start and that consists only of instructions that don't write to
+ * memory and that read memory only from fixed addresses in ram. If
+ * the CPU is found at the same PC in such a loop with all registers
+ * unchanged and without an exception in between, the loop can't end
+ * until an interrupt or a device changes the polled memory.
+ *
+ * Loops are found when the PC jumps back by a few bytes between two
+ * calls to e68_get_idle(). Loops that turn out not to be polling loops
+ * are remembered in idle_bad, so that a busy loop is checked only once.
+ */
+
+
+/* the maximum size of a polling loop in bytes */
+#define E68_IDLE_LOOP 32
+
+/* the maximum number of instructions between two checks */
+#define E68_IDLE_OPCNT 4096
+
+
+void e68_idle_reset (e68000_t *c)
+{
+	c->idle_prev = 1;
+	c->idle_bad = 1;
+	c->idle_addr = 1;
+	c->idle_size = 0;
+	c->idle_pc = 1;
+	c->idle_except = 0;
+	c->idle_opcnt = 0;
+}
+
+int e68_add_idle_range (e68000_t *c, unsigned long addr, unsigned long size)
+{
+	if (c->idle_range_cnt >= E68_IDLE_RANGE_CNT) {
+		return (1);
+	}
+
+	c->idle_range[2 * c->idle_range_cnt] = addr & 0xffffffff;
+	c->idle_range[2 * c->idle_range_cnt + 1] = size & 0xffffffff;
+
+	c->idle_range_cnt += 1;
+
+	return (0);
+}
+
+/*
+ * Check the effective address in the low 6 bits of op of an instruction
+ * that reads size bytes. The extension words start at pc. Returns the
+ * number of extension words or -1 if the operand is not a register, an
+ * immediate value or a fixed address in ram.
+ */
+static
+int e68_idle_ea (e68000_t *c, unsigned op, uint32_t pc, unsigned size)
+{
+	uint32_t addr;
+	unsigned n;
+
+	switch ((op >> 3) & 7) {
+	case 0: /* Dx */
+	case 1: /* Ax */
+		return (0);
+
+	case 2: /* (Ax) */
+		addr = e68_get_areg32 (c, op & 7);
+		n = 0;
+		break;
+
+	case 5: /* XXXX(Ax) */
+		addr = e68_get_areg32 (c, op & 7);
+		addr += e68_exts16 (e68_get_mem16 (c, pc));
+		n = 1;
+		break;
+
+	case 7:
+		switch (op & 7) {
+		case 0: /* XXXX */
+			addr = e68_exts16 (e68_get_mem16 (c, pc));
+			n = 1;
+			break;
+
+		case 1: /* XXXXXXXX */
+			addr = e68_get_mem32 (c, pc);
+			n = 2;
+			break;
+
+		case 2: /* XXXX(PC) */
+			addr = pc + e68_exts16 (e68_get_mem16 (c, pc));
+			n = 1;
+			break;
+
+		case 4: /* #XXXX */
+			return ((size == 4) ? 2 : 1);
+
+		default:
+			return (-1);
+		}
+		break;
+
+	default:
+		/* (Ax)+ and -(Ax) write a register, indexed modes are not checked */
+		return (-1);
+	}
+
+	addr &= 0x00ffffff;
+
+	if ((addr + size) > c->ram_cnt) {
+		return (-1);
+	}
+
+	return (n);
+}
+
+/*
+ * Get the size of the instruction at pc in bytes if it is allowed in a
+ * polling loop or 0 if it isn't. If the instruction is a branch, its
+ * target is returned in dst and bra is set if the branch is always
+ * taken.
+ */
+static
+unsigned e68_idle_insn (e68000_t *c, uint32_t pc, uint32_t *dst, int *bra)
+{
+	unsigned op, size;
+	int      n, m;
+
+	op = e68_get_mem16 (c, pc);
+
+	*dst = 1;
+	*bra = 0;
+
+	if (op == 0x4e71) {
+		/* NOP */
+		return (2);
+	}
+
+	if ((op & 0xf100) == 0x7000) {
+		/* MOVEQ */
+		return (2);
+	}
+
+	if ((op & 0xf000) == 0x6000) {
+		/* Bcc and BRA, but not BSR */
+		if (((op >> 8) & 15) == 1) {
+			return (0);
+		}
+
+		*bra = (((op >> 8) & 15) == 0);
+
+		if ((op & 0xff) == 0) {
+			*dst = pc + 2 + e68_exts16 (e68_get_mem16 (c, pc + 2));
+			return (4);
+		}
+
+		if ((op & 0xff) == 0xff) {
+			return (0);
+		}
+
+		*dst = pc + 2 + e68_exts8 (op);
+
+		return (2);
+	}
+
+	if ((op & 0xf0f8) == 0x50c8) {
+		/* DBcc */
+		*dst = pc + 2 + e68_exts16 (e68_get_mem16 (c, pc + 2));
+		return (4);
+	}
+
+	m = 0;
+
+	if (((op & 0xff00) == 0x4a00) && ((op & 0xc0) != 0xc0)) {
+		/* TST */
+		size = 1U << ((op >> 6) & 3);
+	}
+	else if (((op & 0xff00) == 0x0c00) && ((op & 0xc0) != 0xc0)) {
+		/* CMPI */
+		size = 1U << ((op >> 6) & 3);
+		m = (size == 4) ? 2 : 1;
+	}
+	else if ((op & 0xffc0) == 0x0800) {
+		/* BTST #XX, <EA> */
+		size = 1;
+		m = 1;
+	}
+	else if (((op & 0xf1c0) == 0x0100) && ((op & 0x38) != 0x08)) {
+		/* BTST Dx, <EA> */
+		size = 1;
+	}
+	else if (((op & 0xc1c0) == 0x0000) && (op & 0x3000)) {
+		/* MOVE <EA>, Dx */
+		size = ((op & 0x3000) == 0x1000) ? 1 : ((op & 0x3000) == 0x3000) ? 2 : 4;
+	}
+	else if ((op & 0xf000) == 0xb000) {
+		/* CMP and CMPA, but not EOR and CMPM */
+		if ((op & 0xc0) == 0xc0) {
+			size = (op & 0x0100) ? 4 : 2;
+		}
+		else if (op & 0x0100) {
+			return (0);
+		}
+		else {
+			size = 1U << ((op >> 6) & 3);
+		}
+	}
+	else if ((((op & 0xf100) == 0xc000) || ((op & 0xf100) == 0x8000)) && ((op & 0xc0) != 0xc0)) {
+		/* AND <EA>, Dx and OR <EA>, Dx */
+		size = 1U << ((op >> 6) & 3);
+	}
+	else {
+		return (0);
+	}
+
+	n = e68_idle_ea (c, op, pc + 2 + 2 * m, size);
+
+	if (n < 0) {
+		return (0);
+	}
+
+	return (2 + 2 * (m + n));
+}
+
+/*
+ * Find the polling loop that contains pc. Starting at pc, look for a
+ * branch back to pc or to an address before pc, then check the
+ * instructions from there up to pc.
+ */
+static
+int e68_idle_find (e68000_t *c, uint32_t pc)
+{
+	unsigned n;
+	int      bra;
+	uint32_t addr, dst, start, end;
+
+	addr = pc;
+
+	while (1) {
+		if ((addr - pc) >= E68_IDLE_LOOP) {
+			return (1);
+		}
+
+		n = e68_idle_insn (c, addr, &dst, &bra);
+
+		if (n == 0) {
+			return (1);
+		}
+
+		addr += n;
+
+		if (dst == 1) {
+			continue;
+		}
+
+		if (dst <= pc) {
+			break;
+		}
+
+		if (bra) {
+			/* a jump out of the loop */
+			return (1);
+		}
+	}
+
+	if ((addr - dst) > E68_IDLE_LOOP) {
+		return (1);
+	}
+
+	start = dst;
+	end = addr;
+
+	addr = start;
+
+	while (addr < pc) {
+		n = e68_idle_insn (c, addr, &dst, &bra);
+
+		if (n == 0) {
+			return (1);
+		}
+
+		if (bra && ((dst < start) || (dst >= end))) {
+			return (1);
+		}
+
+		addr += n;
+	}
+
+	if (addr != pc) {
+		return (1);
+	}
+
+	c->idle_addr = start;
+	c->idle_size = end - start;
+
+	return (0);
+}
+
+static
+void e68_idle_save (e68000_t *c, uint32_t pc)
+{
+	unsigned i;
+
+	c->idle_pc = pc;
+	c->idle_except = c->except_cnt;
+	c->idle_opcnt = c->oprcnt;
+
+	for (i = 0; i < 8; i++) {
+		c->idle_reg[i] = c->dreg[i];
+		c->idle_reg[i + 8] = c->areg[i];
+	}
+
+	c->idle_reg[16] = e68_get_sr (c);
+}
+
+static
+int e68_idle_same (e68000_t *c)
+{
+	unsigned i;
+
+	if (c->except_cnt != c->idle_except) {
+		return (0);
+	}
+
+	if ((c->oprcnt - c->idle_opcnt) > E68_IDLE_OPCNT) {
+		/* the CPU may have left the loop in between */
+		return (0);
+	}
+
+	for (i = 0; i < 8; i++) {
+		if (c->idle_reg[i] != c->dreg[i]) {
+			return (0);
+		}
+
+		if (c->idle_reg[i + 8] != c->areg[i]) {
+			return (0);
+		}
+	}
+
+	if (c->idle_reg[16] != e68_get_sr (c)) {
+		return (0);
+	}
+
+	return (1);
+}
+
+int e68_get_idle (e68000_t *c)
+{
+	unsigned i;
+	uint32_t pc, prev;
+
+	if (c->int_nmi || (c->int_ipl > e68_get_iml (c))) {
+		return (0);
+	}
+
+	if (c->halt) {
+		return (1);
+	}
+
+	pc = e68_get_pc (c);
+
+	for (i = 0; i < c->idle_range_cnt; i++) {
+		if ((pc - c->idle_range[2 * i]) < c->idle_range[2 * i + 1]) {
+			return (1);
+		}
+	}
+
+	prev = c->idle_prev;
+	c->idle_prev = pc;
+
+	if ((pc - c->idle_addr) < c->idle_size) {
+		/* in the last polling loop */
+		if (pc != c->idle_pc) {
+			return (0);
+		}
+
+		if (e68_idle_same (c)) {
+			return (1);
+		}
+
+		e68_idle_save (c, pc);
+
+		return (0);
+	}
+
+	if ((pc > prev) || ((prev - pc) > E68_IDLE_LOOP) || (pc == c->idle_bad)) {
+		return (0);
+	}
+
+	/* the PC jumped back a few bytes or not at all */
+
+	if (e68_idle_find (c, pc)) {
+		c->idle_bad = pc;
+		return (0);
+	}
+
+	e68_idle_save (c, pc);
+
+	return (0);
+}
@@ -43,6 +43,19 @@
 
 void e68_set_sr (e68000_t *c, unsigned short val);
 
+/*
+ * Select the execution loop variant for the trace bit and the last
+ * PC history setting
+ */
+void e68_set_exec (e68000_t *c);
+
+int e68_icache_fetch (e68000_t *c);
+
+void e68_idle_reset (e68000_t *c);
+
+void e68_jit_flush (e68000_t *c);
+unsigned e68_jit_exec (e68000_t *c, unsigned long clk);
+
 
 static inline
 uint32_t e68_exts8 (uint32_t val)
@@ -59,6 +72,7 @@ uint32_t e68_exts16 (uint32_t val)
 static inline
 void e68_set_ccr (e68000_t *c, uint8_t val)
 {
+	c->lcc.msk = 0;
 	c->sr = (c->sr & 0xff00) | (val & 0x00ff);
 }
 
@@ -148,11 +162,17 @@ int e68_prefetch (e68000_t *c)
 	}
 
 	c->ir[1] = c->ir[2];
-	c->ir[2] = e68_get_mem16 (c, c->ir_pc);
 
-	if (c->bus_error) {
-		e68_exception_bus (c);
-		return (1);
+	if ((c->ir_pc & ~(uint32_t) (E68_IC_LINE - 1)) == c->ic_addr) {
+		c->ir[2] = c->ic_cur[(c->ir_pc & (E68_IC_LINE - 1)) >> 1];
+	}
+	else if ((c->ic == NULL) || e68_icache_fetch (c)) {
+		c->ir[2] = e68_get_mem16 (c, c->ir_pc);
+
+		if (c->bus_error) {
+			e68_exception_bus (c);
+			return (1);
+		}
 	}
 
 	c->ir_pc += 2;
@@ -161,6 +181,30 @@ int e68_prefetch (e68000_t *c)
 	return (0);
 }
 
+/*
+ * Get the handler for the opcode in ir[0]. The opcode word was fetched
+ * from ir_pc - 4. If that address is in the current cache line and the
+ * cached word is still the opcode, the handler is taken from the line.
+ */
+static inline
+e68_opcode_f e68_get_op (e68000_t *c)
+{
+	uint32_t addr;
+	unsigned i;
+
+	addr = c->ir_pc - 4;
+
+	if ((addr & ~(uint32_t) (E68_IC_LINE - 1)) == c->ic_addr) {
+		i = (addr & (E68_IC_LINE - 1)) >> 1;
+
+		if (c->ic_cur[i] == c->ir[0]) {
+			return (c->ic_cur_op[i]);
+		}
+	}
+
+	return (c->ops[c->ir[0]]);
+}
+
 
 #define e68_ir_ea1(c) ((c)->ir[0] & 0x3f)
 #define e68_ir_ea2(c) ((((c)->ir[0] >> 3) & 0x38) | (((c)->ir[0] >> 9) & 0x07))
@@ -216,31 +260,136 @@ int e68_prefetch (e68000_t *c)
 void e68_op_dbcc (e68000_t *c, int cond);
 void e68_op_scc (e68000_t *c, int cond);
 
-void e68_cc_set_nz_8 (e68000_t *c, uint8_t msk, uint8_t val);
-void e68_cc_set_nz_16 (e68000_t *c, uint8_t msk, uint16_t val);
-void e68_cc_set_nz_32 (e68000_t *c, uint8_t msk, uint32_t val);
+void e68_cc_flush (e68000_t *c, unsigned msk);
 
-void e68_cc_set_add_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2);
-void e68_cc_set_add_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2);
-void e68_cc_set_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2);
+/*
+ * Record a condition code setting operation. The flags in msk will be
+ * computed when they are used. Pending flags not in msk are evaluated now.
+ */
+static inline
+void e68_set_lcc (e68000_t *c, unsigned op, unsigned msk,
+	uint32_t s1, uint32_t s2, uint32_t dst)
+{
+	if (c->lcc.msk & ~msk) {
+		e68_cc_flush (c, c->lcc.msk & ~msk);
+	}
+
+	c->lcc.op = op;
+	c->lcc.msk = msk;
+	c->lcc.s1 = s1;
+	c->lcc.s2 = s2;
+	c->lcc.dst = dst;
+}
+
+/*
+ * Set N and Z from val and clear V and C, restricted to the flags in msk
+ */
+static inline
+void e68_cc_set_nz_8 (e68000_t *c, uint8_t msk, uint8_t val)
+{
+	e68_set_lcc (c, E68_LCC_NZ, msk, 0, 0, (uint32_t) val << 24);
+}
+
+static inline
+void e68_cc_set_nz_16 (e68000_t *c, uint8_t msk, uint16_t val)
+{
+	e68_set_lcc (c, E68_LCC_NZ, msk, 0, 0, (uint32_t) val << 16);
+}
+
+static inline
+void e68_cc_set_nz_32 (e68000_t *c, uint8_t msk, uint32_t val)
+{
+	e68_set_lcc (c, E68_LCC_NZ, msk, 0, 0, val);
+}
+
+/*
+ * Set XNZVC after addition. X is stored immediately, otherwise it would
+ * have to be evaluated by the next MOVE, which leaves X alone.
+ */
+static inline
+void e68_cc_set_add_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+{
+	e68_set_lcc (c, E68_LCC_ADD, E68_SR_NZVC,
+		(uint32_t) s1 << 24, (uint32_t) s2 << 24, (uint32_t) d << 24
+	);
+	e68_set_sr_x (c, ((s1 & s2) | (~d & s1) | (~d & s2)) & 0x80);
+}
+
+static inline
+void e68_cc_set_add_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+{
+	e68_set_lcc (c, E68_LCC_ADD, E68_SR_NZVC,
+		(uint32_t) s1 << 16, (uint32_t) s2 << 16, (uint32_t) d << 16
+	);
+	e68_set_sr_x (c, ((s1 & s2) | (~d & s1) | (~d & s2)) & 0x8000);
+}
+
+static inline
+void e68_cc_set_add_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	e68_set_lcc (c, E68_LCC_ADD, E68_SR_NZVC, s1, s2, d);
+	e68_set_sr_x (c, ((s1 & s2) | (~d & s1) | (~d & s2)) & 0x80000000);
+}
+
+/*
+ * Set NZVC after subtraction (s2 - s1). CMP leaves X alone, SUB stores
+ * it immediately like ADD.
+ */
+static inline
+void e68_cc_set_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+{
+	e68_set_lcc (c, E68_LCC_SUB, E68_SR_NZVC,
+		(uint32_t) s1 << 24, (uint32_t) s2 << 24, (uint32_t) d << 24
+	);
+}
+
+static inline
+void e68_cc_set_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+{
+	e68_set_lcc (c, E68_LCC_SUB, E68_SR_NZVC,
+		(uint32_t) s1 << 16, (uint32_t) s2 << 16, (uint32_t) d << 16
+	);
+}
+
+static inline
+void e68_cc_set_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	e68_set_lcc (c, E68_LCC_SUB, E68_SR_NZVC, s1, s2, d);
+}
+
+static inline
+void e68_cc_set_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2)
+{
+	e68_set_lcc (c, E68_LCC_SUB, E68_SR_NZVC,
+		(uint32_t) s1 << 24, (uint32_t) s2 << 24, (uint32_t) d << 24
+	);
+	e68_set_sr_x (c, ((s1 & ~s2) | (d & ~s2) | (d & s1)) & 0x80);
+}
+
+static inline
+void e68_cc_set_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2)
+{
+	e68_set_lcc (c, E68_LCC_SUB, E68_SR_NZVC,
+		(uint32_t) s1 << 16, (uint32_t) s2 << 16, (uint32_t) d << 16
+	);
+	e68_set_sr_x (c, ((s1 & ~s2) | (d & ~s2) | (d & s1)) & 0x8000);
+}
+
+static inline
+void e68_cc_set_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2)
+{
+	e68_set_lcc (c, E68_LCC_SUB, E68_SR_NZVC, s1, s2, d);
+	e68_set_sr_x (c, ((s1 & ~s2) | (d & ~s2) | (d & s1)) & 0x80000000);
+}
 
 void e68_cc_set_addx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2);
 void e68_cc_set_addx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2);
 void e68_cc_set_addx_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2);
 
-void e68_cc_set_cmp_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2);
-void e68_cc_set_cmp_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2);
-void e68_cc_set_cmp_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2);
-
-void e68_cc_set_sub_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2);
-void e68_cc_set_sub_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2);
-void e68_cc_set_sub_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2);
-
 void e68_cc_set_subx_8 (e68000_t *c, uint8_t d, uint8_t s1, uint8_t s2);
 void e68_cc_set_subx_16 (e68000_t *c, uint16_t d, uint16_t s1, uint16_t s2);
 void e68_cc_set_subx_32 (e68000_t *c, uint32_t d, uint32_t s1, uint32_t s2);
 
-
 #define E68_EA_TYPE_IMM 0
 #define E68_EA_TYPE_REG 1
 #define E68_EA_TYPE_MEM 2
@@ -263,6 +412,10 @@ int e68_ea_set_val16 (e68000_t *c, uint16_t val);
 int e68_ea_set_val32 (e68000_t *c, uint32_t val);
 
 
+/* the specialized opcode handlers in the generated ops-spec.c */
+extern e68_opcode_f e68_opcodes_spec[65536];
+
+void e68_set_opcodes_spec (e68000_t *c);
 void e68_set_opcodes (e68000_t *c);
 void e68_set_opcodes_020 (e68000_t *c);
 
@@ -0,0 +1,1401 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e68000/jit.c                                         *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include "e68000.h"
+#include "internal.h"
+#include "ops-spec.h"
+
+#include <stdlib.h>
+
+
+/*
+ * The dynamic translator turns frequently executed code into x86-64
+ * host code. A translated block is mostly a sequence of calls to the
+ * opcode handlers from the full opcode word table, with the per
+ * instruction bookkeeping of e68_execute() and e68_clock() done by
+ * host instructions in between. The dispatch through the opcode
+ * table and the clock loop are gone, but each instruction still does
+ * exactly what the interpreter would do.
+ *
+ * Before each instruction the opcode word in the prefetch queue is
+ * compared to the translated one. After each instruction the block is
+ * left if the clock cycles given to the block are used up, if the CPU
+ * was halted, if an interrupt is pending or if the PC is not the
+ * address of the next instruction (a taken branch or an exception).
+ * Since the handlers fetch their extension words themselves, this is
+ * enough to make blocks behave exactly like the interpreter even if
+ * the code is modified behind the CPU's back.
+ *
+ * Register to register moves and arithmetic, MOVEQ, ADDQ, SUBQ, TST,
+ * Bcc and DBcc are translated to host code that does not call their
+ * handlers on a plain 68000. That code fills the prefetch queue from
+ * the translated instruction words, so it is only used while the page
+ * generation number is unchanged. e68_jit_exec() makes sure that the
+ * prefetch queue matches memory when such a block is entered and it
+ * leaves pending interrupts to the interpreter.
+ *
+ * Conditional branches don't end a block and a branch back to the
+ * start of the block continues in the block, so small loops run
+ * without leaving the translated code. A block ends at any other
+ * control transfer or privileged instruction and never crosses a
+ * page. A-line and F-line traps and the emulator hook (0x4afc) are
+ * never translated and are left to the interpreter. Blocks are only
+ * translated from pages that the instruction cache can hold and they
+ * are invalidated using its page generation numbers.
+ */
+
+
+#if defined(PCE_HOST_X86_64) && defined(PCE_HOST_LINUX)
+#define E68_JIT_X86_64 1
+#endif
+
+
+#ifdef E68_JIT_X86_64
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+
+#define E68_JIT_BLK_BITS  12
+#define E68_JIT_BLK_CNT   (1UL << E68_JIT_BLK_BITS)
+
+/* the number of executions before a block is translated */
+#define E68_JIT_HOT       16
+
+/* the maximum number of instructions per block */
+#define E68_JIT_INSN_MAX  32
+
+/* the maximum size of a translated block */
+#define E68_JIT_CODE_MAX  (E68_JIT_INSN_MAX * 320 + 64)
+
+#define E68_JIT_MEM_SIZE  (4UL * 1024 * 1024)
+
+#define E68_JIT_PAGE_SIZE (1UL << E68_IC_PAGE_BITS)
+
+#define E68_JIT_OFS(f)    ((unsigned long) offsetof (e68000_t, f))
+
+#define E68_JIT_EAX 0
+#define E68_JIT_ECX 1
+#define E68_JIT_EDX 2
+
+
+typedef void (*e68_jit_code_f) (e68000_t *c, unsigned long clk);
+
+typedef struct {
+	uint32_t       addr;
+	unsigned long  gen;
+	unsigned       cnt;
+	e68_jit_code_f code;
+
+	/* the block executes instructions without calling their handlers */
+	int            native;
+
+	/* the second word of the first instruction */
+	uint16_t       ir2;
+} e68_jit_blk_t;
+
+typedef struct {
+	uint32_t       pc;
+	unsigned       op;
+	unsigned       len;
+	int            jump;
+	int            last;
+	int            native;
+} e68_jit_insn_t;
+
+struct e68_jit_t {
+	e68_jit_blk_t  blk[E68_JIT_BLK_CNT];
+
+	unsigned char  *mem;
+	unsigned long  mem_used;
+};
+
+
+static
+void e68_jit_emit8 (unsigned char **p, unsigned val)
+{
+	*((*p)++) = val & 0xff;
+}
+
+static
+void e68_jit_emit16 (unsigned char **p, unsigned val)
+{
+	e68_jit_emit8 (p, val);
+	e68_jit_emit8 (p, val >> 8);
+}
+
+static
+void e68_jit_emit32 (unsigned char **p, unsigned long val)
+{
+	e68_jit_emit16 (p, val & 0xffff);
+	e68_jit_emit16 (p, (val >> 16) & 0xffff);
+}
+
+static
+void e68_jit_emit64 (unsigned char **p, unsigned long val)
+{
+	e68_jit_emit32 (p, val & 0xffffffff);
+	e68_jit_emit32 (p, (val >> 32) & 0xffffffff);
+}
+
+/* op [rbx + ofs], with a 32 bit displacement */
+static
+void e68_jit_emit_rbx (unsigned char **p, unsigned modrm, unsigned long ofs)
+{
+	e68_jit_emit8 (p, 0x80 | (modrm & 0x38) | 3);
+	e68_jit_emit32 (p, ofs);
+}
+
+/* jcc ret, with a 32 bit displacement */
+static
+void e68_jit_emit_jcc (unsigned char **p, unsigned jcc, const unsigned char *ret)
+{
+	e68_jit_emit8 (p, 0x0f);
+	e68_jit_emit8 (p, jcc + 0x10);
+	e68_jit_emit32 (p, (unsigned long) (ret - (*p + 4)));
+}
+
+/* jmp ret, with a 32 bit displacement */
+static
+void e68_jit_emit_jmp (unsigned char **p, const unsigned char *ret)
+{
+	e68_jit_emit8 (p, 0xe9);
+	e68_jit_emit32 (p, (unsigned long) (ret - (*p + 4)));
+}
+
+/*
+ * Leave the block if the next opcode word is not op
+ */
+static
+void e68_jit_emit_check_op (unsigned char **p, const unsigned char *ret, unsigned op)
+{
+	/* cmp word [rbx + ir + 2], op */
+	e68_jit_emit8 (p, 0x66);
+	e68_jit_emit8 (p, 0x81);
+	e68_jit_emit_rbx (p, 0x38, E68_JIT_OFS (ir) + 2);
+	e68_jit_emit16 (p, op);
+
+	/* jne ret */
+	e68_jit_emit_jcc (p, 0x75, ret);
+}
+
+/*
+ * Do what e68_execute() does before executing the instruction op at pc
+ */
+static
+void e68_jit_emit_start (unsigned char **p, uint32_t pc, unsigned op, int hist)
+{
+	if (hist) {
+		/* mov eax, [rbx + last_pc_idx] */
+		e68_jit_emit8 (p, 0x8b);
+		e68_jit_emit_rbx (p, 0, E68_JIT_OFS (last_pc_idx));
+
+		/* add eax, 1 */
+		e68_jit_emit8 (p, 0x83);
+		e68_jit_emit8 (p, 0xc0);
+		e68_jit_emit8 (p, 0x01);
+
+		/* mov [rbx + last_pc_idx], eax */
+		e68_jit_emit8 (p, 0x89);
+		e68_jit_emit_rbx (p, 0, E68_JIT_OFS (last_pc_idx));
+
+		/* and eax, E68_LAST_PC_CNT - 1 */
+		e68_jit_emit8 (p, 0x83);
+		e68_jit_emit8 (p, 0xe0);
+		e68_jit_emit8 (p, E68_LAST_PC_CNT - 1);
+
+		/* mov dword [rbx + 4 * rax + last_pc], pc */
+		e68_jit_emit8 (p, 0xc7);
+		e68_jit_emit8 (p, 0x84);
+		e68_jit_emit8 (p, 0x83);
+		e68_jit_emit32 (p, E68_JIT_OFS (last_pc));
+		e68_jit_emit32 (p, pc);
+	}
+
+	/* mov byte [rbx + bus_error], 0 */
+	e68_jit_emit8 (p, 0xc6);
+	e68_jit_emit_rbx (p, 0, E68_JIT_OFS (bus_error));
+	e68_jit_emit8 (p, 0);
+
+	/* mov word [rbx + ir], op */
+	e68_jit_emit8 (p, 0x66);
+	e68_jit_emit8 (p, 0xc7);
+	e68_jit_emit_rbx (p, 0, E68_JIT_OFS (ir));
+	e68_jit_emit16 (p, op);
+}
+
+/*
+ * Execute the instruction op at pc by calling its opcode handler
+ */
+static
+void e68_jit_emit_call (unsigned char **p, uint32_t pc, unsigned op,
+	e68_opcode_f fct, int hist)
+{
+	e68_jit_emit_start (p, pc, op, hist);
+
+	/* mov rdi, rbx */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0x89);
+	e68_jit_emit8 (p, 0xdf);
+
+	/* mov rax, fct */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0xb8);
+	e68_jit_emit64 (p, (unsigned long) fct);
+
+	/* call rax */
+	e68_jit_emit8 (p, 0xff);
+	e68_jit_emit8 (p, 0xd0);
+
+	/* add qword [rbx + oprcnt], 1 */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0x83);
+	e68_jit_emit_rbx (p, 0, E68_JIT_OFS (oprcnt));
+	e68_jit_emit8 (p, 0x01);
+}
+
+/*
+ * Leave the block unless e68_clock() would execute another
+ * instruction without recognizing an interrupt. The interrupt mask
+ * is in r13, it can only be changed by the last instruction in a
+ * block.
+ */
+static
+void e68_jit_emit_check_clk (unsigned char **p, const unsigned char *ret)
+{
+	/* cmp [rbx + delay], r12; ja ret */
+	e68_jit_emit8 (p, 0x4c);
+	e68_jit_emit8 (p, 0x39);
+	e68_jit_emit_rbx (p, 0x20, E68_JIT_OFS (delay));
+	e68_jit_emit_jcc (p, 0x77, ret);
+
+	/* mov al, [rbx + halt]; or al, [rbx + int_nmi]; jnz ret */
+	e68_jit_emit8 (p, 0x8a);
+	e68_jit_emit_rbx (p, 0, E68_JIT_OFS (halt));
+	e68_jit_emit8 (p, 0x0a);
+	e68_jit_emit_rbx (p, 0, E68_JIT_OFS (int_nmi));
+	e68_jit_emit_jcc (p, 0x75, ret);
+
+	/* cmp [rbx + int_ipl], r13d; ja ret */
+	e68_jit_emit8 (p, 0x44);
+	e68_jit_emit8 (p, 0x39);
+	e68_jit_emit_rbx (p, 0x28, E68_JIT_OFS (int_ipl));
+	e68_jit_emit_jcc (p, 0x77, ret);
+}
+
+/* cmp dword [rbx + pc], pc */
+static
+void e68_jit_emit_cmp_pc (unsigned char **p, uint32_t pc)
+{
+	e68_jit_emit8 (p, 0x81);
+	e68_jit_emit_rbx (p, 0x38, E68_JIT_OFS (pc));
+	e68_jit_emit32 (p, pc);
+}
+
+/*
+ * Leave the block if the page generation number is not gen, i.e. if
+ * the page was written to since the block was translated
+ */
+static
+void e68_jit_emit_check_gen (unsigned char **p, const unsigned char *ret,
+	const unsigned long *pg, unsigned long gen)
+{
+	/* mov rax, pg; mov rcx, gen */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0xb8);
+	e68_jit_emit64 (p, (unsigned long) pg);
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0xb9);
+	e68_jit_emit64 (p, gen);
+
+	/* cmp [rax], rcx; jne ret */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0x39);
+	e68_jit_emit8 (p, 0x08);
+	e68_jit_emit_jcc (p, 0x75, ret);
+}
+
+/* jcc with a 32 bit displacement that is set by e68_jit_emit_fix() */
+static
+unsigned char *e68_jit_emit_jcc_fix (unsigned char **p, unsigned jcc)
+{
+	unsigned char *fix;
+
+	if (jcc == 0xeb) {
+		e68_jit_emit8 (p, 0xe9);
+	}
+	else {
+		e68_jit_emit8 (p, 0x0f);
+		e68_jit_emit8 (p, jcc + 0x10);
+	}
+
+	fix = *p;
+
+	e68_jit_emit32 (p, 0);
+
+	return (fix);
+}
+
+static
+void e68_jit_emit_fix (unsigned char *fix, const unsigned char *dst)
+{
+	e68_jit_emit32 (&fix, (unsigned long) (dst - (fix + 4)));
+}
+
+/*
+ * op reg, [rbx + ofs] or op [rbx + ofs], reg. Opcodes with a 0x0f
+ * or a 0x66 prefix are given as 16 bit values.
+ */
+static
+void e68_jit_emit_mem (unsigned char **p, unsigned opc, unsigned reg, unsigned long ofs)
+{
+	if (opc > 0xff) {
+		e68_jit_emit8 (p, opc >> 8);
+	}
+
+	e68_jit_emit8 (p, opc);
+	e68_jit_emit_rbx (p, reg << 3, ofs);
+}
+
+/* mov dword [rbx + ofs], val */
+static
+void e68_jit_emit_set32 (unsigned char **p, unsigned long ofs, uint32_t val)
+{
+	e68_jit_emit_mem (p, 0xc7, 0, ofs);
+	e68_jit_emit32 (p, val);
+}
+
+/* load the zero extended (or sign extended) register at ofs into reg */
+static
+void e68_jit_emit_load (unsigned char **p, unsigned reg, unsigned size,
+	unsigned long ofs, int sext)
+{
+	if (size == 8) {
+		e68_jit_emit_mem (p, 0x0fb6, reg, ofs);
+	}
+	else if (size == 16) {
+		e68_jit_emit_mem (p, sext ? 0x0fbf : 0x0fb7, reg, ofs);
+	}
+	else {
+		e68_jit_emit_mem (p, 0x8b, reg, ofs);
+	}
+}
+
+/* store the low size bits of reg into the register at ofs */
+static
+void e68_jit_emit_store (unsigned char **p, unsigned reg, unsigned size,
+	unsigned long ofs)
+{
+	if (size == 8) {
+		e68_jit_emit_mem (p, 0x88, reg, ofs);
+	}
+	else if (size == 16) {
+		e68_jit_emit_mem (p, 0x6689, reg, ofs);
+	}
+	else {
+		e68_jit_emit_mem (p, 0x89, reg, ofs);
+	}
+}
+
+/* shl reg, 32 - size or shr reg, 32 - size */
+static
+void e68_jit_emit_shift (unsigned char **p, unsigned reg, unsigned size, int right)
+{
+	if (size < 32) {
+		e68_jit_emit8 (p, 0xc1);
+		e68_jit_emit8 (p, (right ? 0xe8 : 0xe0) | reg);
+		e68_jit_emit8 (p, 32 - size);
+	}
+}
+
+/*
+ * Do what e68_cc_set_nz_*() do with the value in eax
+ */
+static
+void e68_jit_emit_set_nz (unsigned char **p, unsigned size)
+{
+	e68_jit_emit_shift (p, E68_JIT_EAX, size, 0);
+	e68_jit_emit_mem (p, 0x89, E68_JIT_EAX, E68_JIT_OFS (lcc.dst));
+	e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.op), E68_LCC_NZ);
+	e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.msk), E68_SR_NZVC);
+	e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.s1), 0);
+	e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.s2), 0);
+}
+
+/*
+ * Compute ecx - eax (sub, cmp) or ecx + eax (add) and do what
+ * e68_cc_set_*() do. The operands are shifted left by 32 - size, the
+ * result is stored in Dn unless this is a compare.
+ */
+static
+void e68_jit_emit_arith (unsigned char **p, unsigned lcc, int cmp,
+	unsigned size, unsigned reg)
+{
+	e68_jit_emit_mem (p, 0x89, E68_JIT_EAX, E68_JIT_OFS (lcc.s1));
+	e68_jit_emit_mem (p, 0x89, E68_JIT_ECX, E68_JIT_OFS (lcc.s2));
+
+	/* add ecx, eax or sub ecx, eax */
+	e68_jit_emit8 (p, (lcc == E68_LCC_ADD) ? 0x01 : 0x29);
+	e68_jit_emit8 (p, 0xc1);
+
+	/* setc dl */
+	e68_jit_emit8 (p, 0x0f);
+	e68_jit_emit8 (p, 0x92);
+	e68_jit_emit8 (p, 0xc2);
+
+	e68_jit_emit_mem (p, 0x89, E68_JIT_ECX, E68_JIT_OFS (lcc.dst));
+	e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.op), lcc);
+	e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.msk), E68_SR_NZVC);
+
+	if (cmp) {
+		return;
+	}
+
+	/* movzx edx, dl; shl edx, 4 */
+	e68_jit_emit8 (p, 0x0f);
+	e68_jit_emit8 (p, 0xb6);
+	e68_jit_emit8 (p, 0xd2);
+	e68_jit_emit8 (p, 0xc1);
+	e68_jit_emit8 (p, 0xe2);
+	e68_jit_emit8 (p, 0x04);
+
+	/* and word [rbx + sr], ~E68_SR_X; or [rbx + sr], dx */
+	e68_jit_emit_mem (p, 0x6681, 4, E68_JIT_OFS (sr));
+	e68_jit_emit16 (p, ~E68_SR_X & 0xffff);
+	e68_jit_emit_mem (p, 0x6609, E68_JIT_EDX, E68_JIT_OFS (sr));
+
+	e68_jit_emit_shift (p, E68_JIT_ECX, size, 1);
+	e68_jit_emit_store (p, E68_JIT_ECX, size, E68_JIT_OFS (dreg) + 4 * reg);
+}
+
+/*
+ * Finish an instruction that was executed by host code: continue at
+ * next with the prefetch queue filled from the page, then leave the
+ * block if the clock cycles given to the block are used up.
+ */
+static
+void e68_jit_emit_next (e68000_t *c, unsigned char **p, const unsigned char *ret,
+	uint32_t next, unsigned clk)
+{
+	uint32_t ir;
+
+	ir = e68_get_mem16 (c, next) | (e68_get_mem16 (c, next + 2) << 16);
+
+	e68_jit_emit_set32 (p, E68_JIT_OFS (pc), next);
+	e68_jit_emit_set32 (p, E68_JIT_OFS (ir_pc), next + 4);
+	e68_jit_emit_set32 (p, E68_JIT_OFS (ir) + 2, ir);
+
+	/* add qword [rbx + delay], clk; add qword [rbx + oprcnt], 1 */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit_mem (p, 0x83, 0, E68_JIT_OFS (delay));
+	e68_jit_emit8 (p, clk);
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit_mem (p, 0x83, 0, E68_JIT_OFS (oprcnt));
+	e68_jit_emit8 (p, 0x01);
+
+	/* cmp [rbx + delay], r12; ja ret */
+	e68_jit_emit8 (p, 0x4c);
+	e68_jit_emit_mem (p, 0x39, 4, E68_JIT_OFS (delay));
+	e68_jit_emit_jcc (p, 0x77, ret);
+}
+
+static
+int e68_jit_cond (e68000_t *c, unsigned cond)
+{
+	return (e68_spec_cond (c, cond));
+}
+
+/* evaluate condition cond into eax and test it */
+static
+void e68_jit_emit_cond (unsigned char **p, unsigned cond)
+{
+	/* mov rdi, rbx; mov esi, cond */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0x89);
+	e68_jit_emit8 (p, 0xdf);
+	e68_jit_emit8 (p, 0xbe);
+	e68_jit_emit32 (p, cond);
+
+	/* mov rax, e68_jit_cond; call rax */
+	e68_jit_emit8 (p, 0x48);
+	e68_jit_emit8 (p, 0xb8);
+	e68_jit_emit64 (p, (unsigned long) e68_jit_cond);
+	e68_jit_emit8 (p, 0xff);
+	e68_jit_emit8 (p, 0xd0);
+
+	/* test eax, eax */
+	e68_jit_emit8 (p, 0x85);
+	e68_jit_emit8 (p, 0xc0);
+}
+
+/*
+ * Check if the n bytes at addr are in the same page as base
+ */
+static
+int e68_jit_same_page (uint32_t base, uint32_t addr, unsigned n)
+{
+	if ((base ^ addr) & 0x00ffffff & ~(E68_JIT_PAGE_SIZE - 1)) {
+		return (0);
+	}
+
+	if ((base ^ (addr + n - 1)) & 0x00ffffff & ~(E68_JIT_PAGE_SIZE - 1)) {
+		return (0);
+	}
+
+	return (1);
+}
+
+/* MOVE.x Ry, Rx and MOVEA.x Ry, Ax */
+static
+unsigned e68_jit_native_move (unsigned char **p, unsigned op)
+{
+	unsigned      size, smode, dmode;
+	unsigned long src;
+
+	switch (op & 0xf000) {
+	case 0x1000:
+		size = 8;
+		break;
+
+	case 0x3000:
+		size = 16;
+		break;
+
+	default:
+		size = 32;
+		break;
+	}
+
+	smode = (op >> 3) & 7;
+	dmode = (op >> 6) & 7;
+
+	if ((smode > 1) || (dmode > 1)) {
+		return (0);
+	}
+
+	if ((size == 8) && ((smode == 1) || (dmode == 1))) {
+		return (0);
+	}
+
+	if (p == NULL) {
+		return (4);
+	}
+
+	src = (smode == 0) ? E68_JIT_OFS (dreg) : E68_JIT_OFS (areg);
+	src += 4 * (op & 7);
+
+	if (dmode == 1) {
+		e68_jit_emit_load (p, E68_JIT_EAX, size, src, 1);
+		e68_jit_emit_store (p, E68_JIT_EAX, 32, E68_JIT_OFS (areg) + 4 * ((op >> 9) & 7));
+	}
+	else {
+		e68_jit_emit_load (p, E68_JIT_EAX, size, src, 0);
+		e68_jit_emit_store (p, E68_JIT_EAX, size, E68_JIT_OFS (dreg) + 4 * ((op >> 9) & 7));
+		e68_jit_emit_set_nz (p, size);
+	}
+
+	return (4);
+}
+
+/* TST.x Dx */
+static
+unsigned e68_jit_native_tst (unsigned char **p, unsigned op)
+{
+	unsigned size;
+
+	if (((op & 0xff38) != 0x4a00) || ((op & 0x00c0) == 0x00c0)) {
+		return (0);
+	}
+
+	size = 8 << ((op >> 6) & 3);
+
+	if (p != NULL) {
+		e68_jit_emit_load (p, E68_JIT_EAX, size, E68_JIT_OFS (dreg) + 4 * (op & 7), 0);
+		e68_jit_emit_set_nz (p, size);
+	}
+
+	return (8);
+}
+
+/* ADDQ.x #X, Rx and SUBQ.x #X, Rx */
+static
+unsigned e68_jit_native_addq (unsigned char **p, unsigned op)
+{
+	unsigned size, mode, reg, val, lcc;
+
+	if ((op & 0x00c0) == 0x00c0) {
+		return (0);
+	}
+
+	size = 8 << ((op >> 6) & 3);
+	mode = (op >> 3) & 7;
+	reg = op & 7;
+	val = (op >> 9) & 7;
+	val = (val == 0) ? 8 : val;
+	lcc = (op & 0x0100) ? E68_LCC_SUB : E68_LCC_ADD;
+
+	if ((mode > 1) || ((mode == 1) && (size == 8))) {
+		return (0);
+	}
+
+	if (p == NULL) {
+		return ((size == 32) ? 12 : 8);
+	}
+
+	if (mode == 1) {
+		/* add dword [rbx + areg], val or sub dword [rbx + areg], val */
+		e68_jit_emit_mem (p, 0x83, (lcc == E68_LCC_ADD) ? 0 : 5,
+			E68_JIT_OFS (areg) + 4 * reg
+		);
+		e68_jit_emit8 (p, val);
+	}
+	else {
+		/* mov eax, val << (32 - size) */
+		e68_jit_emit8 (p, 0xb8);
+		e68_jit_emit32 (p, (uint32_t) val << (32 - size));
+
+		e68_jit_emit_load (p, E68_JIT_ECX, size, E68_JIT_OFS (dreg) + 4 * reg, 0);
+		e68_jit_emit_shift (p, E68_JIT_ECX, size, 0);
+		e68_jit_emit_arith (p, lcc, 0, size, reg);
+	}
+
+	return ((size == 32) ? 12 : 8);
+}
+
+/* MOVEQ #XX, Dx */
+static
+unsigned e68_jit_native_moveq (unsigned char **p, unsigned op)
+{
+	uint32_t val;
+
+	if (op & 0x0100) {
+		return (0);
+	}
+
+	if (p != NULL) {
+		val = e68_exts8 (op);
+
+		e68_jit_emit_set32 (p, E68_JIT_OFS (dreg) + 4 * ((op >> 9) & 7), val);
+		e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.dst), val);
+		e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.op), E68_LCC_NZ);
+		e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.msk), E68_SR_NZVC);
+		e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.s1), 0);
+		e68_jit_emit_set32 (p, E68_JIT_OFS (lcc.s2), 0);
+	}
+
+	return (4);
+}
+
+/* ADD.x Ry, Dx, SUB.x Ry, Dx and CMP.x Ry, Dx */
+static
+unsigned e68_jit_native_arith (unsigned char **p, unsigned op)
+{
+	unsigned      size, mode, lcc, clk;
+	unsigned long src;
+
+	if (((op >> 6) & 7) > 2) {
+		return (0);
+	}
+
+	size = 8 << ((op >> 6) & 3);
+	mode = (op >> 3) & 7;
+
+	if ((mode > 1) || ((mode == 1) && (size == 8))) {
+		return (0);
+	}
+
+	lcc = ((op & 0xf000) == 0xd000) ? E68_LCC_ADD : E68_LCC_SUB;
+
+	if ((op & 0xf000) == 0x9000) {
+		clk = (size == 32) ? 10 : 8;
+	}
+	else {
+		clk = (size == 32) ? 6 : 4;
+	}
+
+	if (p == NULL) {
+		return (clk);
+	}
+
+	src = (mode == 0) ? E68_JIT_OFS (dreg) : E68_JIT_OFS (areg);
+	src += 4 * (op & 7);
+
+	e68_jit_emit_load (p, E68_JIT_EAX, size, src, 0);
+	e68_jit_emit_shift (p, E68_JIT_EAX, size, 0);
+	e68_jit_emit_load (p, E68_JIT_ECX, size, E68_JIT_OFS (dreg) + 4 * ((op >> 9) & 7), 0);
+	e68_jit_emit_shift (p, E68_JIT_ECX, size, 0);
+	e68_jit_emit_arith (p, lcc, (op & 0xf000) == 0xb000, size, (op >> 9) & 7);
+
+	return (clk);
+}
+
+/*
+ * Check if the instruction op is translated to host code that does
+ * not call the opcode handler and emit it if p is not NULL. Returns
+ * the number of clock cycles, 0 if the handler must be called.
+ */
+static
+unsigned e68_jit_native_simple (unsigned char **p, unsigned op)
+{
+	switch (op & 0xf000) {
+	case 0x1000:
+	case 0x2000:
+	case 0x3000:
+		return (e68_jit_native_move (p, op));
+
+	case 0x4000:
+		return (e68_jit_native_tst (p, op));
+
+	case 0x5000:
+		return (e68_jit_native_addq (p, op));
+
+	case 0x7000:
+		return (e68_jit_native_moveq (p, op));
+
+	case 0x9000:
+	case 0xb000:
+	case 0xd000:
+		return (e68_jit_native_arith (p, op));
+	}
+
+	return (0);
+}
+
+/*
+ * Bcc, BRA and DBcc. The branch target must be in the same page as
+ * the block start blk so that the prefetch queue can be filled from
+ * the translated words.
+ */
+static
+int e68_jit_native_branch (e68000_t *c, unsigned char **p,
+	const unsigned char *ret, const unsigned char *start,
+	uint32_t blk, uint32_t pc, unsigned op)
+{
+	int           dbcc, word;
+	unsigned      cond;
+	uint32_t      next, dst;
+	unsigned char *fix1, *fix2, *fix3;
+
+	cond = (op >> 8) & 15;
+
+	if ((op & 0xf0f8) == 0x50c8) {
+		dbcc = 1;
+		word = 1;
+	}
+	else if (((op & 0xf000) == 0x6000) && (cond != 1)) {
+		dbcc = 0;
+		word = (op & 0xff) == 0;
+	}
+	else {
+		return (0);
+	}
+
+	if (word) {
+		dst = pc + 2 + e68_exts16 (e68_get_mem16 (c, pc + 2));
+		next = pc + 4;
+	}
+	else {
+		dst = pc + 2 + e68_exts8 (op);
+		next = pc + 2;
+	}
+
+	if ((dst & 1) || (e68_jit_same_page (blk, dst, 4) == 0)) {
+		return (0);
+	}
+
+	if (p == NULL) {
+		return (1);
+	}
+
+	fix1 = NULL;
+	fix2 = NULL;
+	fix3 = NULL;
+
+	if (dbcc) {
+		if (cond == 0) {
+			e68_jit_emit_next (c, p, ret, next, 12);
+			return (1);
+		}
+
+		if (cond != 1) {
+			e68_jit_emit_cond (p, cond);
+			fix1 = e68_jit_emit_jcc_fix (p, 0x75);
+		}
+
+		/* sub word [rbx + dreg], 1; jc fix2 */
+		e68_jit_emit_mem (p, 0x6683, 5, E68_JIT_OFS (dreg) + 4 * (op & 7));
+		e68_jit_emit8 (p, 0x01);
+		fix2 = e68_jit_emit_jcc_fix (p, 0x72);
+	}
+	else if (cond != 0) {
+		e68_jit_emit_cond (p, cond);
+		fix2 = e68_jit_emit_jcc_fix (p, 0x74);
+	}
+
+	/* the branch is taken */
+	e68_jit_emit_next (c, p, ret, dst, 10);
+
+	if (dst == blk) {
+		e68_jit_emit_jmp (p, start);
+	}
+	else {
+		e68_jit_emit_jmp (p, ret);
+	}
+
+	if (fix2 != NULL) {
+		e68_jit_emit_fix (fix2, *p);
+
+		if (dbcc) {
+			/* the counter expired */
+			e68_jit_emit_next (c, p, ret, next, 14);
+
+			if (fix1 != NULL) {
+				fix3 = e68_jit_emit_jcc_fix (p, 0xeb);
+			}
+		}
+		else {
+			e68_jit_emit_next (c, p, ret, next, word ? 12 : 8);
+		}
+	}
+
+	if (fix1 != NULL) {
+		/* the DBcc condition is true */
+		e68_jit_emit_fix (fix1, *p);
+		e68_jit_emit_next (c, p, ret, next, 12);
+		e68_jit_emit_fix (fix3, *p);
+	}
+
+	return (1);
+}
+
+/*
+ * Check if the instruction op at pc is translated to host code that
+ * does not call the opcode handler and emit it if p is not NULL.
+ */
+static
+int e68_jit_native (e68000_t *c, unsigned char **p, const unsigned char *ret,
+	const unsigned char *start, uint32_t blk, uint32_t pc, unsigned op,
+	unsigned len)
+{
+	unsigned clk;
+
+	if (c->flags & E68_FLAG_68020) {
+		return (0);
+	}
+
+	/* the prefetch queue after the instruction is translated, too */
+	if (e68_jit_same_page (blk, pc + len, 4) == 0) {
+		return (0);
+	}
+
+	if (e68_jit_native_branch (c, NULL, ret, start, blk, pc, op)) {
+		if (p != NULL) {
+			e68_jit_emit_start (p, pc, op, c->pc_hist);
+			e68_jit_native_branch (c, p, ret, start, blk, pc, op);
+		}
+
+		return (1);
+	}
+
+	clk = e68_jit_native_simple (NULL, op);
+
+	if (clk == 0) {
+		return (0);
+	}
+
+	if (p != NULL) {
+		e68_jit_emit_start (p, pc, op, c->pc_hist);
+		e68_jit_native_simple (p, op);
+		e68_jit_emit_next (c, p, ret, pc + len, clk);
+	}
+
+	return (1);
+}
+
+/*
+ * Check if an instruction is left to the interpreter
+ */
+static
+int e68_jit_is_excluded (unsigned op)
+{
+	switch (op & 0xf000) {
+	case 0xa000: /* A-line trap */
+	case 0xf000: /* F-line trap */
+		return (1);
+	}
+
+	if (op == 0x4afc) {
+		/* hook / ILLEGAL */
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Check if an instruction ends a block
+ */
+static
+int e68_jit_is_last (const e68_dasm_t *da)
+{
+	unsigned op;
+
+	if (da->flags & (E68_DFLAG_PRIV | E68_DFLAG_CALL | E68_DFLAG_RTE | E68_DFLAG_RTS)) {
+		return (1);
+	}
+
+	if ((da->flags & E68_DFLAG_JUMP) == 0) {
+		return (0);
+	}
+
+	op = da->ir[0];
+
+	if (((op & 0xf000) == 0x6000) && ((op & 0x0f00) >= 0x0200)) {
+		/* Bcc */
+		return (0);
+	}
+
+	if ((op & 0xf0f8) == 0x50c8) {
+		/* DBcc */
+		return (0);
+	}
+
+	return (1);
+}
+
+/*
+ * Check if instructions in the page at addr can be translated
+ */
+static
+int e68_jit_is_cacheable (e68000_t *c, uint32_t addr)
+{
+	addr &= 0x00ffffff;
+
+	if ((addr | (E68_JIT_PAGE_SIZE - 1)) < c->ram_cnt) {
+		return (1);
+	}
+
+	return (c->ic_prom[addr >> E68_IC_PAGE_BITS] != 0);
+}
+
+/*
+ * Disassemble the instruction at pc, which must be in the page at addr
+ */
+static
+void e68_jit_dasm (e68000_t *c, e68_dasm_t *da, uint32_t addr, uint32_t pc)
+{
+	unsigned      i;
+	unsigned char buf[16];
+
+	for (i = 0; i < 16; i++) {
+		if (((addr ^ (pc + i)) & ~(E68_JIT_PAGE_SIZE - 1)) == 0) {
+			buf[i] = e68_get_mem8 (c, pc + i);
+		}
+		else {
+			buf[i] = 0;
+		}
+	}
+
+	e68_dasm (da, pc, buf);
+}
+
+static
+void e68_jit_clear (struct e68_jit_t *jit)
+{
+	unsigned long i;
+
+	for (i = 0; i < E68_JIT_BLK_CNT; i++) {
+		jit->blk[i].addr = 1;
+		jit->blk[i].gen = 0;
+		jit->blk[i].cnt = 0;
+		jit->blk[i].code = NULL;
+		jit->blk[i].native = 0;
+	}
+
+	jit->mem_used = 0;
+}
+
+static
+int e68_jit_translate (e68000_t *c, e68_jit_blk_t *blk)
+{
+	unsigned       i, n, len;
+	uint32_t       pc, addr;
+	unsigned long  *pg;
+	unsigned char  *p, *ret, *start, *next;
+	int            last, native;
+	e68_dasm_t     da;
+	e68_jit_insn_t insn[E68_JIT_INSN_MAX];
+	struct e68_jit_t *jit;
+
+	jit = c->jit;
+
+	pc = blk->addr;
+
+	if ((E68_JIT_MEM_SIZE - jit->mem_used) < E68_JIT_CODE_MAX) {
+		e68_jit_clear (jit);
+
+		blk->addr = pc;
+	}
+
+	addr = pc & 0x00ffffff;
+
+	pg = &c->ic_pgen[addr >> E68_IC_PAGE_BITS];
+	*pg |= 1;
+
+	ret = jit->mem + jit->mem_used;
+
+	n = 0;
+	last = 0;
+	native = 0;
+
+	while ((n < E68_JIT_INSN_MAX) && (last == 0)) {
+		e68_jit_dasm (c, &da, addr, pc);
+
+		len = 2 * da.irn;
+
+		if ((len == 0) || e68_jit_is_excluded (da.ir[0])) {
+			break;
+		}
+
+		if (e68_jit_same_page (addr, pc, len) == 0) {
+			break;
+		}
+
+		last = e68_jit_is_last (&da);
+
+		insn[n].pc = pc;
+		insn[n].op = da.ir[0];
+		insn[n].len = len;
+		insn[n].jump = (da.flags & E68_DFLAG_JUMP) != 0;
+		insn[n].last = last;
+		insn[n].native = e68_jit_native (c, NULL, ret, ret, blk->addr, pc, da.ir[0], len);
+
+		native |= insn[n].native;
+
+		n += 1;
+		pc += len;
+	}
+
+	if (n == 0) {
+		blk->code = NULL;
+		return (1);
+	}
+
+	p = ret;
+
+	/* pop r13; pop r12; pop rbx; ret */
+	e68_jit_emit8 (&p, 0x41);
+	e68_jit_emit8 (&p, 0x5d);
+	e68_jit_emit8 (&p, 0x41);
+	e68_jit_emit8 (&p, 0x5c);
+	e68_jit_emit8 (&p, 0x5b);
+	e68_jit_emit8 (&p, 0xc3);
+
+	start = p;
+
+	/* push rbx; push r12; push r13 */
+	e68_jit_emit8 (&p, 0x53);
+	e68_jit_emit8 (&p, 0x41);
+	e68_jit_emit8 (&p, 0x54);
+	e68_jit_emit8 (&p, 0x41);
+	e68_jit_emit8 (&p, 0x55);
+
+	/* mov rbx, rdi; mov r12, rsi */
+	e68_jit_emit8 (&p, 0x48);
+	e68_jit_emit8 (&p, 0x89);
+	e68_jit_emit8 (&p, 0xfb);
+	e68_jit_emit8 (&p, 0x49);
+	e68_jit_emit8 (&p, 0x89);
+	e68_jit_emit8 (&p, 0xf4);
+
+	/* movzx r13d, word [rbx + sr]; shr r13d, 8; and r13d, 7 */
+	e68_jit_emit8 (&p, 0x44);
+	e68_jit_emit8 (&p, 0x0f);
+	e68_jit_emit8 (&p, 0xb7);
+	e68_jit_emit_rbx (&p, 0x28, E68_JIT_OFS (sr));
+	e68_jit_emit8 (&p, 0x41);
+	e68_jit_emit8 (&p, 0xc1);
+	e68_jit_emit8 (&p, 0xed);
+	e68_jit_emit8 (&p, 0x08);
+	e68_jit_emit8 (&p, 0x41);
+	e68_jit_emit8 (&p, 0x83);
+	e68_jit_emit8 (&p, 0xe5);
+	e68_jit_emit8 (&p, 0x07);
+
+	blk->code = (e68_jit_code_f) start;
+
+	start = p;
+
+	for (i = 0; i < n; i++) {
+		pc = insn[i].pc + insn[i].len;
+
+		e68_jit_emit_check_op (&p, ret, insn[i].op);
+
+		if (insn[i].native) {
+			e68_jit_native (c, &p, ret, start, blk->addr,
+				insn[i].pc, insn[i].op, insn[i].len
+			);
+
+			continue;
+		}
+
+		e68_jit_emit_call (&p, insn[i].pc, insn[i].op, c->ops[insn[i].op],
+			c->pc_hist
+		);
+
+		if (native) {
+			/* host code uses the translated instruction words */
+			e68_jit_emit_check_gen (&p, ret, pg, *pg);
+		}
+
+		if (insn[i].jump) {
+			/* branches back to the start of the block stay in the block */
+			e68_jit_emit_check_clk (&p, ret);
+
+			next = NULL;
+
+			if (insn[i].last == 0) {
+				/* cmp [rbx + pc], pc; je next */
+				e68_jit_emit_cmp_pc (&p, pc);
+				e68_jit_emit8 (&p, 0x74);
+				next = p++;
+			}
+
+			/* cmp [rbx + pc], blk->addr; je start; jmp ret */
+			e68_jit_emit_cmp_pc (&p, blk->addr);
+			e68_jit_emit_jcc (&p, 0x74, start);
+			e68_jit_emit_jmp (&p, ret);
+
+			if (next != NULL) {
+				*next = p - next - 1;
+			}
+		}
+		else if (insn[i].last == 0) {
+			e68_jit_emit_check_clk (&p, ret);
+
+			/* cmp [rbx + pc], pc; jne ret */
+			e68_jit_emit_cmp_pc (&p, pc);
+			e68_jit_emit_jcc (&p, 0x75, ret);
+		}
+	}
+
+	e68_jit_emit_jmp (&p, ret);
+
+	jit->mem_used += p - ret;
+	jit->mem_used = (jit->mem_used + 15) & ~15UL;
+
+	blk->gen = *pg;
+	blk->native = native;
+	blk->ir2 = native ? e68_get_mem16 (c, blk->addr + 2) : 0;
+
+	return (0);
+}
+
+/*
+ * The code memory is never writable and executable at the same time. It
+ * is made writable while a block is translated and executable again
+ * afterwards. Returns non-zero if the protection can't be changed.
+ */
+static
+int e68_jit_set_write (struct e68_jit_t *jit, int write)
+{
+	int prot;
+
+	prot = write ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC);
+
+	if (mprotect (jit->mem, E68_JIT_MEM_SIZE, prot)) {
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Translate a block with the code memory writable. Returns non-zero if
+ * the block can't be translated or the code memory can't be made
+ * executable again, in which case all blocks are discarded.
+ */
+static
+int e68_jit_translate_blk (e68000_t *c, e68_jit_blk_t *blk)
+{
+	int r;
+
+	if (e68_jit_set_write (c->jit, 1)) {
+		return (1);
+	}
+
+	r = e68_jit_translate (c, blk);
+
+	if (e68_jit_set_write (c->jit, 0)) {
+		e68_jit_clear (c->jit);
+		return (1);
+	}
+
+	return (r);
+}
+
+int e68_set_jit (e68000_t *c, int enable)
+{
+	struct e68_jit_t *jit;
+
+	if (enable == 0) {
+		if (c->jit != NULL) {
+			munmap (c->jit->mem, E68_JIT_MEM_SIZE);
+			free (c->jit);
+			c->jit = NULL;
+		}
+
+		return (0);
+	}
+
+	if (c->jit != NULL) {
+		return (0);
+	}
+
+	if (c->ic == NULL) {
+		if (e68_set_icache (c, 1)) {
+			return (1);
+		}
+	}
+
+	jit = malloc (sizeof (struct e68_jit_t));
+
+	if (jit == NULL) {
+		return (1);
+	}
+
+	jit->mem = mmap (NULL, E68_JIT_MEM_SIZE,
+		PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS,
+		-1, 0
+	);
+
+	if (jit->mem == MAP_FAILED) {
+		free (jit);
+		return (1);
+	}
+
+	e68_jit_clear (jit);
+
+	c->jit = jit;
+
+	return (0);
+}
+
+void e68_jit_flush (e68000_t *c)
+{
+	if (c->jit != NULL) {
+		e68_jit_clear (c->jit);
+	}
+}
+
+/*
+ * Execute a translated block at the current PC if there is one and
+ * the block would not use more than clk clock cycles before its last
+ * instruction. Returns the number of instructions executed, which is
+ * 0 if the instruction at the PC must be executed by the interpreter.
+ */
+unsigned e68_jit_exec (e68000_t *c, unsigned long clk)
+{
+	uint32_t      pc;
+	unsigned long idx, cnt;
+	e68_jit_blk_t *blk;
+
+	if (c->jit_disable || c->halt || (c->sr & E68_SR_T)) {
+		return (0);
+	}
+
+	/* blocks only check for interrupts after called handlers */
+	if (c->int_nmi || (c->int_ipl > e68_get_iml (c))) {
+		return (0);
+	}
+
+	pc = e68_get_pc (c);
+
+	if ((pc & 1) || (e68_jit_is_cacheable (c, pc) == 0)) {
+		return (0);
+	}
+
+	idx = (pc >> 1) ^ (pc >> (E68_JIT_BLK_BITS + 1));
+	blk = &c->jit->blk[idx & (E68_JIT_BLK_CNT - 1)];
+
+	if (blk->addr != pc) {
+		blk->addr = pc;
+		blk->cnt = 0;
+		blk->code = NULL;
+	}
+	else if (blk->code != NULL) {
+		if (blk->gen != c->ic_pgen[(pc & 0x00ffffff) >> E68_IC_PAGE_BITS]) {
+			blk->cnt = 0;
+			blk->code = NULL;
+		}
+	}
+
+	if (blk->code == NULL) {
+		blk->cnt += 1;
+
+		if (blk->cnt < E68_JIT_HOT) {
+			return (0);
+		}
+
+		blk->cnt = 0;
+
+		if (e68_jit_translate_blk (c, blk)) {
+			return (0);
+		}
+	}
+
+	if (blk->native) {
+		/* host code expects the prefetch queue to match memory */
+		if ((c->ir_pc != (uint32_t) (pc + 4)) || (c->ir[2] != blk->ir2)) {
+			return (0);
+		}
+	}
+
+	/* the trace bit is clear for all instructions but the last */
+	c->trace_sr = c->sr;
+
+	cnt = c->oprcnt;
+
+	blk->code (c, clk);
+
+	return (c->oprcnt - cnt);
+}
+
+#else
+
+int e68_set_jit (e68000_t *c, int enable)
+{
+	return (enable != 0);
+}
+
+void e68_jit_flush (e68000_t *c)
+{
+}
+
+unsigned e68_jit_exec (e68000_t *c, unsigned long clk)
+{
+	return (0);
+}
+
+#endif
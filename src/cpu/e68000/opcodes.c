@@ -23,10 +23,12 @@
 #include "e68000.h"
 #include "internal.h"
 
+#include <string.h>
+
 
 #define e68_op_chk_addr(c, addr, wr) do { \
-	if (((c)->flags & E68_FLAG_NOADDR) == 0) { \
-		if ((addr) & 1) { \
+	if ((addr) & 1) { \
+		if (((c)->flags & E68_FLAG_NOADDR) == 0) { \
 			e68_exception_address (c, (addr), 1, (wr)); \
 			return; \
 		} \
@@ -46,6 +48,9 @@
 		return; \
 	}
 
+/* the maximum number of loop iterations that DBF runs in one go */
+#define E68_DBCC_BULK 32
+
 
 static void e68_op_undefined (e68000_t *c)
 {
@@ -53,6 +58,21 @@ static void e68_op_undefined (e68000_t *c)
 	e68_set_clk (c, 2);
 }
 
+/*
+ * Check if size bytes at addr are in ram and can be accessed directly
+ */
+static inline
+int e68_op_is_ram (e68000_t *c, uint32_t addr, uint32_t size)
+{
+#ifdef E68000_LOG_MEM
+	if (c->log_mem != NULL) {
+		return (0);
+	}
+#endif
+
+	return (((addr & 0x00ffffff) + size) <= c->ram_cnt);
+}
+
 /* 0000: ORI.B #XX, <EA> */
 static void op0000 (e68000_t *c)
 {
@@ -1505,10 +1525,108 @@ static void op48c0_00 (e68000_t *c)
 	e68_op_prefetch (c);
 }
 
+/*
+ * Get the number of registers in a MOVEM register list
+ */
+static inline
+unsigned e68_op_movem_cnt (uint16_t r)
+{
+	unsigned n;
+
+	n = 0;
+
+	while (r != 0) {
+		r &= r - 1;
+		n += 1;
+	}
+
+	return (n);
+}
+
+/*
+ * Store n registers to ram at addr for MOVEM.L. The register list r is
+ * reversed if predec is true. Returns non-zero if the registers are not
+ * all stored to ram, in which case nothing is done.
+ */
+static
+int e68_op_movem_st32 (e68000_t *c, uint32_t addr, uint16_t r, unsigned n, int predec)
+{
+	unsigned      i, b;
+	uint32_t      v;
+	unsigned char *p;
+
+	if (e68_op_is_ram (c, addr, 4 * n) == 0) {
+		return (1);
+	}
+
+	p = c->ram + (addr & 0x00ffffff);
+
+	for (i = 0; i < 16; i++) {
+		b = predec ? (15 - i) : i;
+
+		if (r & (1U << b)) {
+			v = (i < 8) ? c->dreg[i] : c->areg[i - 8];
+
+			p[0] = (v >> 24) & 0xff;
+			p[1] = (v >> 16) & 0xff;
+			p[2] = (v >> 8) & 0xff;
+			p[3] = v & 0xff;
+
+			p += 4;
+		}
+	}
+
+	e68_icache_invalidate (c, addr, 4 * n);
+
+	e68_set_clk (c, 8 * n);
+
+	return (0);
+}
+
+/*
+ * Load n registers from ram at addr for MOVEM.L. Returns non-zero if the
+ * registers are not all loaded from ram, in which case nothing is done.
+ */
+static
+int e68_op_movem_ld32 (e68000_t *c, uint32_t addr, uint16_t r, unsigned n)
+{
+	unsigned            i;
+	uint32_t            v;
+	const unsigned char *p;
+
+	if (e68_op_is_ram (c, addr, 4 * n) == 0) {
+		return (1);
+	}
+
+	p = c->ram + (addr & 0x00ffffff);
+
+	for (i = 0; i < 16; i++) {
+		if (r & (1U << i)) {
+			v = p[0];
+			v = (v << 8) | p[1];
+			v = (v << 8) | p[2];
+			v = (v << 8) | p[3];
+
+			if (i < 8) {
+				c->dreg[i] = v;
+			}
+			else {
+				c->areg[i - 8] = v;
+			}
+
+			p += 4;
+		}
+	}
+
+	e68_set_clk (c, 8 * n);
+
+	return (0);
+}
+
 /* 48C0_04: MOVEM.L list, -(Ax) */
 static void op48c0_04 (e68000_t *c)
 {
-	unsigned i;
+	unsigned i, n;
 	uint16_t r;
 	uint32_t a, v;
 
@@ -1519,20 +1637,27 @@ static void op48c0_04 (e68000_t *c)
 		e68_op_chk_addr (c, a, 1);
 	}
 
-	for (i = 0; i < 16; i++) {
-		if (r & 1) {
-			a = (a - 4) & 0xffffffff;
-			if (i < 8) {
-				v = e68_get_areg32 (c, 7 - i);
-			}
-			else {
-				v = e68_get_dreg32 (c, 15 - i);
-			}
-			e68_set_mem32 (c, a, v);
+	n = e68_op_movem_cnt (r);
 
-			e68_set_clk (c, 8);
+	if (e68_op_movem_st32 (c, a - 4 * n, r, n, 1) == 0) {
+		a = (a - 4 * n) & 0xffffffff;
+	}
+	else {
+		for (i = 0; i < 16; i++) {
+			if (r & 1) {
+				a = (a - 4) & 0xffffffff;
+				if (i < 8) {
+					v = e68_get_areg32 (c, 7 - i);
+				}
+				else {
+					v = e68_get_dreg32 (c, 15 - i);
+				}
+				e68_set_mem32 (c, a, v);
+
+				e68_set_clk (c, 8);
+			}
+			r >>= 1;
 		}
-		r >>= 1;
 	}
 
 	e68_set_areg32 (c, e68_ir_reg0 (c), a);
@@ -1544,7 +1669,7 @@ static void op48c0_04 (e68000_t *c)
 /* 48C0_XX: MOVEM.L list, <EA> */
 static void op48c0_xx (e68000_t *c)
 {
-	unsigned i;
+	unsigned i, n;
 	uint16_t r;
 	uint32_t a, v;
 
@@ -1565,20 +1690,24 @@ static void op48c0_xx (e68000_t *c)
 		e68_op_chk_addr (c, a, 1);
 	}
 
-	for (i = 0; i < 16; i++) {
-		if (r & 1) {
-			if (i < 8) {
-				v = e68_get_dreg32 (c, i);
-			}
-			else {
-				v = e68_get_areg32 (c, i - 8);
-			}
-			e68_set_mem32 (c, a, v);
-			a = (a + 4) & 0xffffffff;
+	n = e68_op_movem_cnt (r);
 
-			e68_set_clk (c, 8);
+	if (e68_op_movem_st32 (c, a, r, n, 0)) {
+		for (i = 0; i < 16; i++) {
+			if (r & 1) {
+				if (i < 8) {
+					v = e68_get_dreg32 (c, i);
+				}
+				else {
+					v = e68_get_areg32 (c, i - 8);
+				}
+				e68_set_mem32 (c, a, v);
+				a = (a + 4) & 0xffffffff;
+
+				e68_set_clk (c, 8);
+			}
+			r >>= 1;
 		}
-		r >>= 1;
 	}
 
 	e68_set_clk (c, 8);
@@ -1645,12 +1774,17 @@ static void op4a80 (e68000_t *c)
 /* 4AFC: ILLEGAL */
 static void op4afc (e68000_t *c)
 {
+	int           r;
 	unsigned long pc;
 
 	if (c->hook != NULL) {
 		pc = e68_get_pc (c);
+		r = c->hook (c->hook_ext, c->ir[2]);
+
+		/* the hook may have modified memory */
+		e68_icache_flush (c);
 
-		if (c->hook (c->hook_ext, c->ir[2]) == 0) {
+		if (r == 0) {
 			if (e68_get_pc (c) == pc) {
 				e68_op_prefetch (c);
 				e68_op_prefetch (c);
@@ -1789,7 +1923,7 @@ static void op4c80 (e68000_t *c)
 /* 4CC0_03: MOVEM.L (Ax)+, list */
 static void op4cc0_03 (e68000_t *c)
 {
-	unsigned i;
+	unsigned i, n;
 	uint16_t r;
 	uint32_t a, v;
 
@@ -1801,20 +1935,27 @@ static void op4cc0_03 (e68000_t *c)
 		e68_op_chk_addr (c, a, 0);
 	}
 
-	for (i = 0; i < 16; i++) {
-		if (r & 1) {
-			v = e68_get_mem32 (c, a);
-			if (i < 8) {
-				e68_set_dreg32 (c, i, v);
-			}
-			else {
-				e68_set_areg32 (c, i - 8, v);
-			}
-			a = (a + 4) & 0xffffffff;
+	n = e68_op_movem_cnt (r);
 
-			e68_set_clk (c, 8);
+	if (e68_op_movem_ld32 (c, a, r, n) == 0) {
+		a = (a + 4 * n) & 0xffffffff;
+	}
+	else {
+		for (i = 0; i < 16; i++) {
+			if (r & 1) {
+				v = e68_get_mem32 (c, a);
+				if (i < 8) {
+					e68_set_dreg32 (c, i, v);
+				}
+				else {
+					e68_set_areg32 (c, i - 8, v);
+				}
+				a = (a + 4) & 0xffffffff;
+
+				e68_set_clk (c, 8);
+			}
+			r >>= 1;
 		}
-		r >>= 1;
 	}
 
 	e68_set_areg32 (c, e68_ir_reg0 (c), a);
@@ -1826,7 +1967,7 @@ static void op4cc0_03 (e68000_t *c)
 /* 4CC0_XX: MOVEM.L <EA>, list */
 static void op4cc0_xx (e68000_t *c)
 {
-	unsigned i;
+	unsigned i, n;
 	uint16_t r;
 	uint32_t a, v;
 
@@ -1847,20 +1988,24 @@ static void op4cc0_xx (e68000_t *c)
 		e68_op_chk_addr (c, a, 0);
 	}
 
-	for (i = 0; i < 16; i++) {
-		if (r & 1) {
-			v = e68_get_mem32 (c, a);
-			if (i < 8) {
-				e68_set_dreg32 (c, i, v);
-			}
-			else {
-				e68_set_areg32 (c, i - 8, v);
-			}
-			a = (a + 4) & 0xffffffff;
+	n = e68_op_movem_cnt (r);
 
-			e68_set_clk (c, 8);
+	if (e68_op_movem_ld32 (c, a, r, n)) {
+		for (i = 0; i < 16; i++) {
+			if (r & 1) {
+				v = e68_get_mem32 (c, a);
+				if (i < 8) {
+					e68_set_dreg32 (c, i, v);
+				}
+				else {
+					e68_set_areg32 (c, i - 8, v);
+				}
+				a = (a + 4) & 0xffffffff;
+
+				e68_set_clk (c, 8);
+			}
+			r >>= 1;
 		}
-		r >>= 1;
 	}
 
 	e68_set_clk (c, 12);
@@ -2560,6 +2705,171 @@ static void op5180 (e68000_t *c)
 	e68_op_set_ea32 (c, 0, 0, 0, d);
 }
 
+/*
+ * Run the remaining iterations of a copy or fill loop in ram in one go.
+ * The loop consists of one of
+ *
+ *   MOVE.x (Ay)+, (Ax)+
+ *   MOVE.x Dy, (Ax)+
+ *   CLR.x  (Ax)+
+ *
+ * followed by a DBF that was just taken to branch back to it. At most
+ * E68_DBCC_BULK iterations are done at a time so that interrupts are
+ * still recognized with a bounded delay, and no more than fit into the
+ * clock cycles left in the current call to e68_clock(), so that device
+ * events are not overshot. The last iteration is left to the
+ * interpreter, as are loops that overlap themselves or the code.
+ */
+static
+void e68_op_dbcc_bulk (e68000_t *c, unsigned reg, uint32_t pc)
+{
+	unsigned      op, size, clk, i, j;
+	unsigned long k;
+	unsigned      sreg, dreg;
+	uint16_t      cnt;
+	uint32_t      s, d, val, bytes;
+	unsigned char *ram;
+
+	op = e68_get_mem16 (c, pc);
+
+	if (((op & 0xc1f8) == 0x00d8) && (op & 0x3000)) {
+		/* MOVE.x (Ay)+, (Ax)+ */
+		size = ((op & 0x3000) == 0x1000) ? 1 : ((op & 0x3000) == 0x3000) ? 2 : 4;
+		sreg = op & 7;
+		clk = (size == 4) ? 20 : 12;
+	}
+	else if (((op & 0xc1f8) == 0x00c0) && (op & 0x3000)) {
+		/* MOVE.x Dy, (Ax)+ */
+		size = ((op & 0x3000) == 0x1000) ? 1 : ((op & 0x3000) == 0x3000) ? 2 : 4;
+		sreg = 8 + (op & 7);
+		clk = (size == 4) ? 12 : 8;
+
+		if ((op & 7) == reg) {
+			return;
+		}
+	}
+	else if (((op & 0xff38) == 0x4218) && ((op & 0xc0) != 0xc0)) {
+		/* CLR.x (Ax)+ */
+		size = 1U << ((op >> 6) & 3);
+		sreg = 16;
+		clk = (size == 4) ? 22 : 12;
+	}
+	else {
+		return;
+	}
+
+	dreg = (op & 0x4000) ? (op & 7) : ((op >> 9) & 7);
+
+	if ((dreg == 7) || (sreg == 7) || (sreg == dreg)) {
+		return;
+	}
+
+	cnt = e68_get_dreg16 (c, reg);
+	k = (cnt < E68_DBCC_BULK) ? cnt : E68_DBCC_BULK;
+
+	if (c->clk_rem <= c->delay) {
+		return;
+	}
+
+	if (k > ((c->clk_rem - c->delay) / (clk + 10))) {
+		k = (c->clk_rem - c->delay) / (clk + 10);
+	}
+
+	if (k == 0) {
+		return;
+	}
+
+	bytes = k * size;
+
+	d = e68_get_areg32 (c, dreg);
+
+	if ((size > 1) && (d & 1)) {
+		return;
+	}
+
+	if (e68_op_is_ram (c, d, bytes) == 0) {
+		return;
+	}
+
+	if (((pc + 6 - d) & 0x00ffffff) < (bytes + 6)) {
+		/* the loop overwrites itself */
+		return;
+	}
+
+	ram = c->ram;
+
+	if (sreg < 8) {
+		s = e68_get_areg32 (c, sreg);
+
+		if ((size > 1) && (s & 1)) {
+			return;
+		}
+
+		if (e68_op_is_ram (c, s, bytes) == 0) {
+			return;
+		}
+
+		s &= 0x00ffffff;
+		d &= 0x00ffffff;
+
+		if (((d - s) & 0x00ffffff) < size) {
+			/* an element overlaps the next one */
+			return;
+		}
+
+		if ((s + bytes <= d) || (d + bytes <= s)) {
+			memcpy (ram + d, ram + s, bytes);
+		}
+		else {
+			for (i = 0; i < bytes; i++) {
+				ram[d + i] = ram[s + i];
+			}
+		}
+
+		e68_set_areg32 (c, sreg, e68_get_areg32 (c, sreg) + bytes);
+	}
+	else {
+		d &= 0x00ffffff;
+
+		val = (sreg < 16) ? e68_get_dreg32 (c, sreg - 8) : 0;
+
+		for (i = 0; i < bytes; i += size) {
+			for (j = 0; j < size; j++) {
+				ram[d + i + j] = (val >> (8 * (size - j - 1))) & 0xff;
+			}
+		}
+	}
+
+	val = 0;
+
+	for (i = 0; i < size; i++) {
+		val = (val << 8) | ram[d + bytes - size + i];
+	}
+
+	e68_set_areg32 (c, dreg, e68_get_areg32 (c, dreg) + bytes);
+	e68_set_dreg16 (c, reg, cnt - k);
+
+	e68_icache_invalidate (c, d, bytes);
+
+	if (sreg == 16) {
+		e68_set_cc (c, E68_SR_N | E68_SR_V | E68_SR_C, 0);
+		e68_set_cc (c, E68_SR_Z, 1);
+	}
+	else if (size == 1) {
+		e68_cc_set_nz_8 (c, E68_SR_NZVC, val & 0xff);
+	}
+	else if (size == 2) {
+		e68_cc_set_nz_16 (c, E68_SR_NZVC, val & 0xffff);
+	}
+	else {
+		e68_cc_set_nz_32 (c, E68_SR_NZVC, val);
+	}
+
+	e68_set_clk (c, k * (clk + 10));
+
+	c->oprcnt += 2 * k;
+}
+
 /* DBcc Dx, dist */
 void e68_op_dbcc (e68000_t *c, int cond)
 {
@@ -2594,6 +2904,13 @@ void e68_op_dbcc (e68000_t *c, int cond)
 	e68_op_prefetch (c);
 	e68_op_prefetch (c);
 	e68_set_pc (c, e68_get_ir_pc (c) - 4);
+
+	if ((dist == 0xfffffffc) && ((c->ir[0] & 0x0f00) == 0x0100)) {
+		/* DBF back to the previous instruction */
+		if ((c->sr & E68_SR_T) == 0) {
+			e68_op_dbcc_bulk (c, reg, e68_get_pc (c));
+		}
+	}
 }
 
 /* Scc <EA> */
@@ -3106,7 +3423,7 @@ static void op8100_00 (e68000_t *c)
 	e68_set_cc (c, E68_SR_XC, d & 0xff00);
 
 	if (d & 0xff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 
 	e68_op_prefetch (c);
@@ -3745,15 +4062,15 @@ static void opc100_00 (e68000_t *c)
 
 	if (d >= 0xa0) {
 		d += 0x60;
-		c->sr |= (E68_SR_X | E68_SR_C);
+		e68_set_sr_xc (c, 1);
 	}
 	else {
-		c->sr &= (~E68_SR_X & ~E68_SR_C);
+		e68_set_sr_xc (c, 0);
 	}
 
 
 	if (d & 0xff) {
-		c->sr &= ~E68_SR_Z;
+		e68_set_sr_z (c, 0);
 	}
 
 	e68_set_clk (c, 6);
@@ -5324,6 +5641,31 @@ static e68_opcode_f e68_op_49c0[8] = {
 	  NULL, op41c0, op41c0, op41c0, op41c0, op41c0, op41c0, op41c0
 };
 
+/*
+ * Build the full opcode word table from the generic opcode table. The
+ * specialized handler is used only if the generic handler it replaces
+ * has not been overridden, e.g. by the 68020 opcodes.
+ */
+void e68_set_opcodes_spec (e68000_t *c)
+{
+	unsigned     i;
+	e68_opcode_f op;
+
+	for (i = 0; i < 65536; i++) {
+		op = c->opcodes[i >> 6];
+
+		if ((e68_opcodes_spec[i] != NULL) && (op == e68_opcodes[i >> 6])) {
+			op = e68_opcodes_spec[i];
+		}
+
+		c->ops[i] = op;
+	}
+
+	/* cached lines and translated code refer to the old handlers */
+	e68_icache_flush (c);
+	e68_jit_flush (c);
+}
+
 void e68_set_opcodes (e68000_t *c)
 {
 	unsigned i;
@@ -5340,4 +5682,6 @@ void e68_set_opcodes (e68000_t *c)
 	for (i = 0; i < 8; i++) {
 		c->op49c0[i] = (e68_op_49c0[i] == NULL) ? e68_op_undefined : e68_op_49c0[i];
 	}
+
+	e68_set_opcodes_spec (c);
 }
@@ -1136,4 +1136,6 @@ void e68_set_opcodes_020 (e68000_t *c)
 			c->op49c0[i] = e68_op_49c0[i];
 		}
 	}
+
+	e68_set_opcodes_spec (c);
 }
@@ -0,0 +1,474 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e68000/ops-spec.h                                    *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+/*
+ * Opcode handler templates for the generated ops-spec.c. The generated
+ * handlers call these with constant sizes, effective address modes and
+ * registers, so each instance compiles to the code for exactly one
+ * opcode. The templates must behave exactly like the generic handlers
+ * in opcodes.c, including clock counts and exceptions.
+ */
+
+
+#ifndef PCE_E68000_OPS_SPEC_H
+#define PCE_E68000_OPS_SPEC_H 1
+
+
+/* the templates must be inlined for the constants to propagate */
+#ifdef __GNUC__
+#define E68_SPEC_INLINE static inline __attribute__ ((always_inline))
+#else
+#define E68_SPEC_INLINE static inline
+#endif
+
+
+/* the address register increment for (Ax)+ and -(Ax) */
+#define e68_spec_inc(size, reg) \
+	(((size) == 8) ? (((reg) == 7) ? 2 : 1) : ((size) >> 3))
+
+
+/*
+ * Compute a memory address for modes 2 to 5 ((Ax), (Ax)+, -(Ax), XXXX(Ax))
+ */
+E68_SPEC_INLINE
+int e68_spec_get_addr (e68000_t *c, unsigned size, unsigned mode, unsigned reg,
+	uint32_t *addr)
+{
+	switch (mode) {
+	case 2:
+		*addr = e68_get_areg32 (c, reg);
+		break;
+
+	case 3:
+		*addr = e68_get_areg32 (c, reg);
+		e68_set_areg32 (c, reg, *addr + e68_spec_inc (size, reg));
+		break;
+
+	case 4:
+		*addr = e68_get_areg32 (c, reg) - e68_spec_inc (size, reg);
+		e68_set_areg32 (c, reg, *addr);
+		e68_set_clk (c, 2);
+		break;
+
+	case 5:
+		if (e68_prefetch (c)) {
+			return (1);
+		}
+
+		*addr = e68_get_areg32 (c, reg) + e68_exts16 (c->ir[1]);
+		e68_set_clk (c, 4);
+		break;
+	}
+
+	return (0);
+}
+
+E68_SPEC_INLINE
+int e68_spec_get_mem (e68000_t *c, unsigned size, uint32_t addr, uint32_t *val)
+{
+	if ((size != 8) && (addr & 1)) {
+		if ((c->flags & E68_FLAG_NOADDR) == 0) {
+			e68_exception_address (c, addr, 1, 0);
+			return (1);
+		}
+	}
+
+	if (size == 8) {
+		*val = e68_get_mem8 (c, addr);
+		e68_set_clk (c, 4);
+	}
+	else if (size == 16) {
+		*val = e68_get_mem16 (c, addr);
+		e68_set_clk (c, 4);
+	}
+	else {
+		*val = e68_get_mem32 (c, addr);
+		e68_set_clk (c, 8);
+	}
+
+	if (c->bus_error) {
+		e68_exception_bus (c);
+		return (1);
+	}
+
+	return (0);
+}
+
+E68_SPEC_INLINE
+int e68_spec_set_mem (e68000_t *c, unsigned size, uint32_t addr, uint32_t val)
+{
+	if ((size != 8) && (addr & 1)) {
+		if ((c->flags & E68_FLAG_NOADDR) == 0) {
+			e68_exception_address (c, addr, 1, 1);
+			return (1);
+		}
+	}
+
+	if (size == 8) {
+		e68_set_mem8 (c, addr, val);
+		e68_set_clk (c, 4);
+	}
+	else if (size == 16) {
+		e68_set_mem16 (c, addr, val);
+		e68_set_clk (c, 4);
+	}
+	else {
+		e68_set_mem32 (c, addr, val);
+		e68_set_clk (c, 8);
+	}
+
+	if (c->bus_error) {
+		e68_exception_bus (c);
+		return (1);
+	}
+
+	return (0);
+}
+
+E68_SPEC_INLINE
+uint32_t e68_spec_get_dreg (e68000_t *c, unsigned size, unsigned reg)
+{
+	if (size == 8) {
+		return (e68_get_dreg8 (c, reg));
+	}
+	else if (size == 16) {
+		return (e68_get_dreg16 (c, reg));
+	}
+
+	return (e68_get_dreg32 (c, reg));
+}
+
+E68_SPEC_INLINE
+void e68_spec_set_dreg (e68000_t *c, unsigned size, unsigned reg, uint32_t val)
+{
+	if (size == 8) {
+		e68_set_dreg8 (c, reg, val);
+	}
+	else if (size == 16) {
+		e68_set_dreg16 (c, reg, val);
+	}
+	else {
+		e68_set_dreg32 (c, reg, val);
+	}
+}
+
+/*
+ * Get a source operand. Modes 0 to 5 are supported, mode 1 (Ax) only
+ * for word and long operands.
+ */
+E68_SPEC_INLINE
+int e68_spec_get_ea (e68000_t *c, unsigned size, unsigned mode, unsigned reg,
+	uint32_t *val)
+{
+	uint32_t addr;
+
+	if (mode == 0) {
+		*val = e68_spec_get_dreg (c, size, reg);
+		return (0);
+	}
+	else if (mode == 1) {
+		*val = (size == 16) ? e68_get_areg16 (c, reg) : e68_get_areg32 (c, reg);
+		return (0);
+	}
+
+	if (e68_spec_get_addr (c, size, mode, reg, &addr)) {
+		return (1);
+	}
+
+	return (e68_spec_get_mem (c, size, addr, val));
+}
+
+/*
+ * Set a destination operand. Modes 0 and 2 to 5 are supported.
+ */
+E68_SPEC_INLINE
+int e68_spec_set_ea (e68000_t *c, unsigned size, unsigned mode, unsigned reg,
+	uint32_t val)
+{
+	uint32_t addr;
+
+	if (mode == 0) {
+		e68_spec_set_dreg (c, size, reg, val);
+		return (0);
+	}
+
+	if (e68_spec_get_addr (c, size, mode, reg, &addr)) {
+		return (1);
+	}
+
+	return (e68_spec_set_mem (c, size, addr, val));
+}
+
+E68_SPEC_INLINE
+void e68_spec_set_nz (e68000_t *c, unsigned size, uint32_t val)
+{
+	if (size == 8) {
+		e68_cc_set_nz_8 (c, E68_SR_NZVC, val);
+	}
+	else if (size == 16) {
+		e68_cc_set_nz_16 (c, E68_SR_NZVC, val);
+	}
+	else {
+		e68_cc_set_nz_32 (c, E68_SR_NZVC, val);
+	}
+}
+
+E68_SPEC_INLINE
+int e68_spec_cond (e68000_t *c, unsigned cond)
+{
+	switch (cond) {
+	case 0x0:
+		return (1);
+
+	case 0x1:
+		return (0);
+
+	case 0x2:
+		return (!e68_get_sr_c (c) && !e68_get_sr_z (c));
+
+	case 0x3:
+		return (e68_get_sr_c (c) || e68_get_sr_z (c));
+
+	case 0x4:
+		return (!e68_get_sr_c (c));
+
+	case 0x5:
+		return (e68_get_sr_c (c));
+
+	case 0x6:
+		return (!e68_get_sr_z (c));
+
+	case 0x7:
+		return (e68_get_sr_z (c));
+
+	case 0x8:
+		return (!e68_get_sr_v (c));
+
+	case 0x9:
+		return (e68_get_sr_v (c));
+
+	case 0xa:
+		return (!e68_get_sr_n (c));
+
+	case 0xb:
+		return (e68_get_sr_n (c));
+
+	case 0xc:
+		return (e68_get_sr_n (c) == e68_get_sr_v (c));
+
+	case 0xd:
+		return (e68_get_sr_n (c) != e68_get_sr_v (c));
+
+	case 0xe:
+		return ((e68_get_sr_n (c) == e68_get_sr_v (c)) && !e68_get_sr_z (c));
+
+	case 0xf:
+		return ((e68_get_sr_n (c) != e68_get_sr_v (c)) || e68_get_sr_z (c));
+	}
+
+	return (0);
+}
+
+
+/* MOVE.x <EA>, <EA> and MOVEA.x <EA>, Ax */
+E68_SPEC_INLINE
+void e68_spec_move (e68000_t *c, unsigned size,
+	unsigned smode, unsigned sreg, unsigned dmode, unsigned dreg)
+{
+	uint32_t val;
+
+	if (e68_spec_get_ea (c, size, smode, sreg, &val)) {
+		return;
+	}
+
+	if (dmode == 1) {
+		if (size == 16) {
+			val = e68_exts16 (val);
+		}
+
+		e68_set_areg32 (c, dreg, val);
+		e68_set_clk (c, 4);
+		e68_op_prefetch (c);
+
+		return;
+	}
+
+	if (e68_spec_set_ea (c, size, dmode, dreg, val)) {
+		return;
+	}
+
+	e68_set_clk (c, 4);
+	e68_spec_set_nz (c, size, val);
+	e68_op_prefetch (c);
+}
+
+/* ADD.x <EA>, Dx */
+E68_SPEC_INLINE
+void e68_spec_add (e68000_t *c, unsigned size, unsigned mode, unsigned reg,
+	unsigned dreg)
+{
+	uint32_t s1, s2, d;
+
+	if (e68_spec_get_ea (c, size, mode, reg, &s1)) {
+		return;
+	}
+
+	s2 = e68_spec_get_dreg (c, size, dreg);
+	d = s1 + s2;
+
+	if (size == 8) {
+		e68_set_clk (c, 4);
+		e68_cc_set_add_8 (c, d, s1, s2);
+	}
+	else if (size == 16) {
+		e68_set_clk (c, 4);
+		e68_cc_set_add_16 (c, d, s1, s2);
+	}
+	else {
+		e68_set_clk (c, 6);
+		e68_cc_set_add_32 (c, d, s1, s2);
+	}
+
+	e68_op_prefetch (c);
+	e68_spec_set_dreg (c, size, dreg, d);
+}
+
+/* SUB.x <EA>, Dx */
+E68_SPEC_INLINE
+void e68_spec_sub (e68000_t *c, unsigned size, unsigned mode, unsigned reg,
+	unsigned dreg)
+{
+	uint32_t s1, s2, d;
+
+	if (e68_spec_get_ea (c, size, mode, reg, &s1)) {
+		return;
+	}
+
+	s2 = e68_spec_get_dreg (c, size, dreg);
+	d = s2 - s1;
+
+	if (size == 8) {
+		e68_set_clk (c, 8);
+		e68_cc_set_sub_8 (c, d, s1, s2);
+	}
+	else if (size == 16) {
+		e68_set_clk (c, 8);
+		e68_cc_set_sub_16 (c, d, s1, s2);
+	}
+	else {
+		e68_set_clk (c, 10);
+		e68_cc_set_sub_32 (c, d, s1, s2);
+	}
+
+	e68_op_prefetch (c);
+	e68_spec_set_dreg (c, size, dreg, d);
+}
+
+/* CMP.x <EA>, Dx */
+E68_SPEC_INLINE
+void e68_spec_cmp (e68000_t *c, unsigned size, unsigned mode, unsigned reg,
+	unsigned dreg)
+{
+	uint32_t s1, s2;
+
+	if (e68_spec_get_ea (c, size, mode, reg, &s1)) {
+		return;
+	}
+
+	s2 = e68_spec_get_dreg (c, size, dreg);
+
+	if (size == 8) {
+		e68_set_clk (c, 4);
+		e68_cc_set_cmp_8 (c, s2 - s1, s1, s2);
+	}
+	else if (size == 16) {
+		e68_set_clk (c, 4);
+		e68_cc_set_cmp_16 (c, s2 - s1, s1, s2);
+	}
+	else {
+		e68_set_clk (c, 6);
+		e68_cc_set_cmp_32 (c, s2 - s1, s1, s2);
+	}
+
+	e68_op_prefetch (c);
+}
+
+/* LEA <EA>, Ax */
+E68_SPEC_INLINE
+void e68_spec_lea (e68000_t *c, unsigned mode, unsigned reg, unsigned areg)
+{
+	uint32_t addr;
+
+	if (e68_spec_get_addr (c, 32, mode, reg, &addr)) {
+		return;
+	}
+
+	e68_set_clk (c, 4);
+	e68_set_areg32 (c, areg, addr);
+	e68_op_prefetch (c);
+}
+
+/* MOVEQ #XX, Dx */
+E68_SPEC_INLINE
+void e68_spec_moveq (e68000_t *c, unsigned reg)
+{
+	uint32_t val;
+
+	val = e68_exts8 (c->ir[0]);
+
+	e68_set_clk (c, 4);
+	e68_cc_set_nz_32 (c, E68_SR_NZVC, val);
+	e68_set_dreg32 (c, reg, val);
+	e68_op_prefetch (c);
+}
+
+/* Bcc dist, with an 8 bit or a 16 bit displacement */
+E68_SPEC_INLINE
+void e68_spec_bcc (e68000_t *c, unsigned cond, int word)
+{
+	uint32_t addr, dist;
+
+	addr = e68_get_pc (c) + 2;
+
+	if (word) {
+		e68_op_prefetch (c);
+		dist = e68_exts16 (c->ir[1]);
+	}
+	else {
+		dist = e68_exts8 (c->ir[0]);
+	}
+
+	if (e68_spec_cond (c, cond)) {
+		e68_set_clk (c, 10);
+		e68_set_ir_pc (c, addr + dist);
+		e68_op_prefetch (c);
+	}
+	else {
+		e68_set_clk (c, word ? 12 : 8);
+	}
+
+	e68_op_prefetch (c);
+	e68_set_pc (c, e68_get_ir_pc (c) - 4);
+}
+
+
+#endif
@@ -0,0 +1,161 @@
+#!/bin/sh
+
+# ops-spec.sh
+#
+# Generate ops-spec.c, the table of opcode handlers that are specialized
+# for one complete opcode word. Each handler instantiates one of the
+# templates in ops-spec.h with constant operand sizes and effective
+# address modes. Registers are constant in the register direct modes.
+# In the memory modes they are taken from the opcode word, which keeps
+# the number of handlers (and the compile time) reasonable. Opcodes that
+# are not specialized are NULL in the table and use the generic handler
+# from opcodes.c.
+#
+# Usage: ops-spec.sh > ops-spec.c
+
+${AWK:-awk} '
+function field(op, shift, cnt)
+{
+	return (int(op / (2 ^ shift)) % cnt)
+}
+
+# Return the register argument for mode and reg. Set key to the first
+# opcode that shares the handler.
+function regarg(mode, reg, shift, arg)
+{
+	if (mode < 2) {
+		return (reg)
+	}
+
+	key -= reg * (2 ^ shift)
+
+	return (arg)
+}
+
+# Set name and spec for opcode op. Return 0 if op is not specialized.
+function decode(op,   top, mode, reg, mode6, reg9, size, cond, fct)
+{
+	key = op
+	spec = ""
+
+	top = field(op, 12, 16)
+	mode = field(op, 3, 8)
+	reg = field(op, 0, 8)
+	mode6 = field(op, 6, 8)
+	reg9 = field(op, 9, 8)
+
+	if ((top == 1) || (top == 2) || (top == 3)) {
+		# MOVE.x <EA>, <EA> / MOVEA.x <EA>, Ax
+		size = (top == 1) ? 8 : ((top == 2) ? 32 : 16)
+
+		if ((mode > 5) || (mode6 > 5)) {
+			return (0)
+		}
+
+		if ((size == 8) && ((mode == 1) || (mode6 == 1))) {
+			return (0)
+		}
+
+		spec = sprintf("e68_spec_move (c, %d, %d, %s, %d, %s)", size,
+			mode, regarg(mode, reg, 0, "e68_ir_reg0 (c)"),
+			mode6, regarg(mode6, reg9, 9, "e68_ir_reg9 (c)"))
+	}
+	else if (top == 4) {
+		# LEA <EA>, Ax
+		if ((mode6 != 7) || ((mode != 2) && (mode != 5))) {
+			return (0)
+		}
+
+		spec = sprintf("e68_spec_lea (c, %d, %s, %d)",
+			mode, regarg(mode, reg, 0, "e68_ir_reg0 (c)"), reg9)
+	}
+	else if (top == 6) {
+		# Bcc dist, BSR is not specialized
+		cond = field(op, 8, 16)
+
+		if (cond == 1) {
+			return (0)
+		}
+
+		if ((op % 256) == 0) {
+			spec = sprintf("e68_spec_bcc (c, %d, 1)", cond)
+		}
+		else {
+			key = op - (op % 256) + 1
+			spec = sprintf("e68_spec_bcc (c, %d, 0)", cond)
+		}
+	}
+	else if (top == 7) {
+		# MOVEQ #XX, Dx
+		if (field(op, 8, 2) != 0) {
+			return (0)
+		}
+
+		key = op - (op % 256)
+		spec = sprintf("e68_spec_moveq (c, %d)", reg9)
+	}
+	else if ((top == 9) || (top == 11) || (top == 13)) {
+		# SUB.x, CMP.x, ADD.x <EA>, Dx
+		if (mode6 > 2) {
+			return (0)
+		}
+
+		size = 8 * (2 ^ mode6)
+
+		if ((mode > 5) || ((size == 8) && (mode == 1))) {
+			return (0)
+		}
+
+		fct = (top == 9) ? "sub" : ((top == 11) ? "cmp" : "add")
+
+		spec = sprintf("e68_spec_%s (c, %d, %d, %s, %d)", fct, size,
+			mode, regarg(mode, reg, 0, "e68_ir_reg0 (c)"), reg9)
+	}
+	else {
+		return (0)
+	}
+
+	name = sprintf("sp%04x", key)
+
+	return (1)
+}
+
+BEGIN {
+	print "/*****************************************************************************"
+	print " * pce                                                                       *"
+	print " *****************************************************************************/"
+	print ""
+	print "/*****************************************************************************"
+	print " * File name:   src/cpu/e68000/ops-spec.c                                    *"
+	print " * Generated by ops-spec.sh, do not edit                                     *"
+	print " *****************************************************************************/"
+	print ""
+	print ""
+	print "#include <cpu/e68000/e68000.h>"
+	print "#include <cpu/e68000/internal.h>"
+	print "#include <cpu/e68000/ops-spec.h>"
+	print ""
+
+	for (op = 0; op < 65536; op++) {
+		if (decode(op) && (key == op)) {
+			printf "\nstatic void %s (e68000_t *c)\n{\n\t%s;\n}\n", name, spec
+		}
+	}
+
+	print ""
+	print ""
+	print "e68_opcode_f e68_opcodes_spec[65536] = {"
+
+	for (op = 0; op < 65536; op += 8) {
+		line = "\t"
+
+		for (i = 0; i < 8; i++) {
+			line = line (decode(op + i) ? name : "NULL") ", "
+		}
+
+		printf "%s/* %04X */\n", line, op
+	}
+
+	print "};"
+}
+'
@@ -63,6 +63,16 @@ void e86_init (e8086_t *c)
 
 	c->addr_mask = 0xfffff;
 
+	for (i = 0; i < E86_MAP_CNT; i++) {
+		c->map_rd[i] = NULL;
+		c->map_wr[i] = NULL;
+	}
+
+	c->map_ext = NULL;
+	c->map_update = NULL;
+	c->map_src_gen = NULL;
+	c->map_gen = 0;
+
 	c->inta_ext = NULL;
 	c->inta = NULL;
 
@@ -74,11 +84,24 @@ void e86_init (e8086_t *c)
 
 	c->pq_size = 4;
 	c->pq_fill = 6;
+	c->pq_cnt = 0;
+	c->pq = c->pq_buf;
+
+	c->ic = NULL;
+	c->ic_pgen = NULL;
+	c->ic_pcnt = 0;
+
+	c->jit = NULL;
+	c->jit_disable = 0;
 
 	c->irq = 0;
 
 	c->halt = 0;
 
+	c->flg = 0;
+	c->lflg.op = E86_LFLG_LOG;
+	c->lflg.msk = 0;
+
 	for (i = 0; i < 256; i++) {
 		c->op[i] = e86_opcodes[i];
 	}
@@ -86,10 +109,15 @@ void e86_init (e8086_t *c)
 	c->clocks = 0;
 	c->instructions = 0;
 	c->delay = 0;
+	c->clk_rem = 0;
+	c->clk_break = 0;
+
+	e86_set_exec (c);
 }
 
 void e86_free (e8086_t *c)
 {
+	e86_set_icache (c, 0);
 }
 
 e8086_t *e86_new (void)
@@ -124,6 +152,9 @@ void e86_set_8086 (e8086_t *c)
 		c->op[i] = e86_opcodes[i];
 	}
 
+	/* the cached opcode handlers may change */
+	e86_icache_flush (c);
+
 	e86_set_pq_size (c, 6);
 }
 
@@ -159,6 +190,8 @@ void e86_set_pq_size (e8086_t *c, unsigned size)
 	c->pq_size = size;
 	c->pq_fill = (size < 6) ? 6 : size;
 	c->pq_cnt = 0;
+
+	e86_set_exec (c);
 }
 
 void e86_set_options (e8086_t *c, unsigned opt, int set)
@@ -169,6 +202,10 @@ void e86_set_options (e8086_t *c, unsigned opt, int set)
 	else {
 		c->cpu &= ~opt;
 	}
+
+	if (opt & E86_CPU_8BIT) {
+		e86_set_exec (c);
+	}
 }
 
 void e86_set_addr_mask (e8086_t *c, unsigned long msk)
@@ -191,6 +228,8 @@ void e86_set_ram (e8086_t *c, unsigned char *ram, unsigned long cnt)
 {
 	c->ram = ram;
 	c->ram_cnt = cnt;
+
+	e86_icache_ram_changed (c);
 }
 
 void e86_set_mem (e8086_t *c, void *mem,
@@ -204,6 +243,54 @@ void e86_set_mem (e8086_t *c, void *mem,
 	c->mem_set_uint16 = set16;
 }
 
+void e86_set_mem_map (e8086_t *c, unsigned long addr, unsigned long size,
+	void *rd, void *wr)
+{
+	unsigned long i;
+
+	i = addr >> E86_MAP_BITS;
+
+	while ((size >= E86_MAP_SIZE) && (i < E86_MAP_CNT)) {
+		c->map_rd[i] = rd;
+		c->map_wr[i] = wr;
+
+		if (rd != NULL) {
+			rd = (unsigned char *) rd + E86_MAP_SIZE;
+		}
+
+		if (wr != NULL) {
+			wr = (unsigned char *) wr + E86_MAP_SIZE;
+		}
+
+		i += 1;
+		size -= E86_MAP_SIZE;
+	}
+}
+
+static
+void e86_update_mem_map (e8086_t *c)
+{
+	e86_set_mem_map (c, 0, E86_MAP_CNT * E86_MAP_SIZE, NULL, NULL);
+
+	if (c->map_src_gen != NULL) {
+		c->map_gen = *c->map_src_gen;
+	}
+
+	if (c->map_update != NULL) {
+		c->map_update (c->map_ext);
+	}
+}
+
+void e86_set_mem_map_fct (e8086_t *c, void *ext, void *fct,
+	const unsigned long *gen)
+{
+	c->map_ext = ext;
+	c->map_update = fct;
+	c->map_src_gen = gen;
+
+	e86_update_mem_map (c);
+}
+
 void e86_set_prt (e8086_t *c, void *prt,
 	e86_get_uint8_f get8, e86_set_uint8_f set8,
 	e86_get_uint16_f get16, e86_set_uint16_f set16)
@@ -443,11 +530,18 @@ void e86_reset (e8086_t *c)
 	c->prefix = 0;
 }
 
-void e86_execute (e8086_t *c)
+/*
+ * The instruction loop. It is instantiated below for the common CPU
+ * configurations with ic, size and fill as constants, so the compiler
+ * can drop the icache test and specialize the prefetch queue code.
+ */
+static inline
+void e86_execute_tmpl (e8086_t *c, int ic, unsigned size, unsigned fill)
 {
 	unsigned       cnt;
 	unsigned short flg;
 	char           irq;
+	e86_opcode_f   op;
 
 	if (c->halt) {
 		e86_set_clk (c, 2);
@@ -459,6 +553,10 @@ void e86_execute (e8086_t *c)
 		return;
 	}
 
+	if ((c->map_src_gen != NULL) && (*c->map_src_gen != c->map_gen)) {
+		e86_update_mem_map (c);
+	}
+
 	if ((c->prefix & E86_PREFIX_KEEP) == 0) {
 		c->prefix = 0;
 		c->cur_ip = c->ip;
@@ -467,10 +565,30 @@ void e86_execute (e8086_t *c)
 	flg = c->flg;
 	irq = c->irq;
 
+	if (c->jit != NULL) {
+		cnt = e86_jit_exec (c);
+
+		if (cnt > 0) {
+			c->instructions += cnt;
+
+			if (c->enable_int && c->irq && e86_get_if (c)) {
+				e86_irq_ack (c);
+			}
+
+			return;
+		}
+	}
+
 	c->enable_int = 1;
 
 	do {
-		e86_pq_fill (c);
+		if (ic) {
+			op = e86_icache_fetch (c);
+		}
+		else {
+			e86_pq_fill_n (c, size, fill);
+			op = c->op[c->pq[0]];
+		}
 
 		c->prefix &= ~E86_PREFIX_NEW;
 
@@ -478,11 +596,14 @@ void e86_execute (e8086_t *c)
 			c->op_stat (c->op_ext, c->pq[0], c->pq[1]);
 		}
 
-		cnt = c->op[c->pq[0]] (c);
+		cnt = op (c);
 
 		if (cnt > 0) {
 			c->ip = (c->ip + cnt) & 0xffff;
-			e86_pq_adjust (c, cnt);
+
+			if (ic == 0) {
+				e86_pq_adjust (c, cnt);
+			}
 		}
 		else {
 			c->delay += 10;
@@ -501,15 +622,123 @@ void e86_execute (e8086_t *c)
 	}
 }
 
+static
+void e86_execute_ic (e8086_t *c)
+{
+	e86_execute_tmpl (c, 1, 0, 0);
+}
+
+static
+void e86_execute_pq4 (e8086_t *c)
+{
+	e86_execute_tmpl (c, 0, 4, 6);
+}
+
+static
+void e86_execute_pq6 (e8086_t *c)
+{
+	e86_execute_tmpl (c, 0, 6, 6);
+}
+
+static
+void e86_execute_pq (e8086_t *c)
+{
+	e86_execute_tmpl (c, 0, c->pq_size, c->pq_fill);
+}
+
+/*
+ * Use the opcode handlers for the bus width in E86_CPU_8BIT. Handlers
+ * that were replaced by a CPU model are kept.
+ */
+static
+void e86_set_opcodes_bus (e8086_t *c)
+{
+	unsigned     i;
+	int          chg;
+	e86_opcode_f *src, *dst;
+
+	if (c->cpu & E86_CPU_8BIT) {
+		src = e86_opcodes;
+		dst = e86_opcodes_8bit;
+	}
+	else {
+		src = e86_opcodes_8bit;
+		dst = e86_opcodes;
+	}
+
+	chg = 0;
+
+	for (i = 0; i < 256; i++) {
+		if (c->op[i] == src[i]) {
+			c->op[i] = dst[i];
+			chg = 1;
+		}
+	}
+
+	if (chg) {
+		/* the cached opcode handlers may change */
+		e86_icache_flush (c);
+	}
+}
+
+void e86_set_exec (e8086_t *c)
+{
+	e86_set_opcodes_bus (c);
+
+	if (c->ic != NULL) {
+		c->exec = e86_execute_ic;
+	}
+	else if ((c->pq_size == 4) && (c->pq_fill == 6)) {
+		c->exec = e86_execute_pq4;
+	}
+	else if ((c->pq_size == 6) && (c->pq_fill == 6)) {
+		c->exec = e86_execute_pq6;
+	}
+	else {
+		c->exec = e86_execute_pq;
+	}
+}
+
+void e86_execute (e8086_t *c)
+{
+	c->exec (c);
+}
+
 void e86_clock (e8086_t *c, unsigned n)
 {
 	while (n >= c->delay) {
 		n -= c->delay;
 		c->clocks += c->delay;
 		c->delay = 0;
-		e86_execute (c);
+		c->clk_rem = n;
+		c->exec (c);
+
+		if (c->clk_break) {
+			c->clk_break = 0;
+			c->clk_rem = 0;
+			return;
+		}
 	}
 
+	c->clk_rem = 0;
+
 	c->delay -= n;
 	c->clocks += n;
 }
+
+void e86_clock_break (e8086_t *c)
+{
+	c->clk_break = 1;
+}
+
+void e86_skip (e8086_t *c, unsigned long n)
+{
+	if (n < c->delay) {
+		c->delay -= n;
+	}
+	else {
+		c->delay = 0;
+	}
+
+	c->clocks += n;
+}
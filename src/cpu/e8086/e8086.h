@@ -82,8 +82,30 @@
 
 #define E86_PQ_MAX 16
 
+/* instruction cache */
+#define E86_IC_BITS      12
+#define E86_IC_CNT       (1U << E86_IC_BITS)
+#define E86_IC_PAGE_SIZE 4096
+
+/* The memory map covers the 1 MB address space plus the HMA */
+#define E86_MAP_BITS 12
+#define E86_MAP_SIZE (1UL << E86_MAP_BITS)
+#define E86_MAP_MASK (E86_MAP_SIZE - 1)
+#define E86_MAP_CNT  (0x110000UL >> E86_MAP_BITS)
+
+/* lazy flags operations */
+#define E86_LFLG_LOG 0x00
+#define E86_LFLG_ADD 0x01
+#define E86_LFLG_SUB 0x02
+#define E86_LFLG_16  0x10
+
+/* flags that can be evaluated lazily */
+#define E86_FLG_ARITH \
+	(E86_FLG_C | E86_FLG_P | E86_FLG_A | E86_FLG_Z | E86_FLG_S | E86_FLG_O)
+
 
 struct e8086_t;
+struct e86_jit_t;
 
 
 typedef unsigned char (*e86_get_uint8_f) (void *ext, unsigned long addr);
@@ -94,6 +116,14 @@ typedef void (*e86_set_uint16_f) (void *ext, unsigned long addr, unsigned short
 typedef unsigned (*e86_opcode_f) (struct e8086_t *c);
 
 
+typedef struct {
+	unsigned long    addr;
+	unsigned long    gen;
+	e86_opcode_f     op;
+	unsigned char    data[8];
+} e86_icache_ent_t;
+
+
 typedef struct e8086_t {
 	unsigned         cpu;
 
@@ -102,6 +132,18 @@ typedef struct e8086_t {
 	unsigned short   ip;
 	unsigned short   flg;
 
+	/*
+	 * The last flag setting operation. The flags in msk are not
+	 * valid in flg and must be computed from op, s1, s2 and dst.
+	 */
+	struct {
+		unsigned       op;
+		unsigned       msk;
+		unsigned long  s1;
+		unsigned long  s2;
+		unsigned long  dst;
+	} lflg;
+
 	void             *mem;
 	e86_get_uint8_f  mem_get_uint8;
 	e86_set_uint8_f  mem_set_uint8;
@@ -119,6 +161,18 @@ typedef struct e8086_t {
 
 	unsigned long    addr_mask;
 
+	/*
+	 * Host pointers for memory pages outside of ram, or NULL. If
+	 * *map_src_gen differs from map_gen, the pointers are cleared
+	 * and map_update() is called to set them up again.
+	 */
+	unsigned char       *map_rd[E86_MAP_CNT];
+	unsigned char       *map_wr[E86_MAP_CNT];
+	void                *map_ext;
+	void                (*map_update) (void *ext);
+	const unsigned long *map_src_gen;
+	unsigned long       map_gen;
+
 	void             *inta_ext;
 	unsigned char    (*inta) (void *ext);
 
@@ -130,10 +184,23 @@ typedef struct e8086_t {
 
 	unsigned short   cur_ip;
 
+	/* the execution loop variant, selected by e86_set_exec() */
+	void             (*exec) (struct e8086_t *c);
+
 	unsigned         pq_size;
 	unsigned         pq_fill;
 	unsigned         pq_cnt;
-	unsigned char    pq[E86_PQ_MAX];
+	unsigned char    *pq;
+	unsigned char    pq_buf[E86_PQ_MAX];
+
+	e86_icache_ent_t *ic;
+	unsigned long    *ic_pgen;
+	unsigned long    ic_pcnt;
+
+	struct e86_jit_t *jit;
+
+	/* if non-zero, threaded code is not used (single stepping) */
+	int              jit_disable;
 
 	unsigned         prefix;
 
@@ -156,6 +223,12 @@ typedef struct e8086_t {
 
 	unsigned long    delay;
 
+	/* the clock cycles left in the current call to e86_clock() */
+	unsigned long    clk_rem;
+
+	/* if non-zero, e86_clock() returns after the current instruction */
+	int              clk_break;
+
 	unsigned long long clocks;
 	unsigned long long instructions;
 } e8086_t;
@@ -243,23 +316,64 @@ typedef struct e8086_t {
 #define e86_set_ip(cpu, val) do { (cpu)->ip = (val) & 0xffff; } while (0)
 
 
-#define e86_get_flags(cpu) ((cpu)->flg)
-#define e86_get_f(cpu, f) (((cpu)->flg & (f)) != 0)
-#define e86_get_cf(cpu) (((cpu)->flg & E86_FLG_C) != 0)
-#define e86_get_pf(cpu) (((cpu)->flg & E86_FLG_P) != 0)
-#define e86_get_af(cpu) (((cpu)->flg & E86_FLG_A) != 0)
-#define e86_get_zf(cpu) (((cpu)->flg & E86_FLG_Z) != 0)
-#define e86_get_of(cpu) (((cpu)->flg & E86_FLG_O) != 0)
-#define e86_get_sf(cpu) (((cpu)->flg & E86_FLG_S) != 0)
+/*!***************************************************************************
+ * @short Evaluate lazy flags
+ * @param msk The flags to evaluate
+ * @return The flags in msk as computed from the last flag setting operation
+ *****************************************************************************/
+unsigned e86_flg_eval (const e8086_t *c, unsigned msk);
+
+/*!***************************************************************************
+ * @short Store all lazily evaluated flags in c->flg
+ *****************************************************************************/
+void e86_flg_sync (e8086_t *c);
+
+static inline
+unsigned short e86_get_flags (e8086_t *c)
+{
+	if (c->lflg.msk != 0) {
+		e86_flg_sync (c);
+	}
+
+	return (c->flg);
+}
+
+static inline
+int e86_get_f (const e8086_t *c, unsigned f)
+{
+	if (c->lflg.msk & f) {
+		return ((((c->flg & ~c->lflg.msk) | e86_flg_eval (c, f & c->lflg.msk)) & f) != 0);
+	}
+
+	return ((c->flg & f) != 0);
+}
+
+#define e86_get_cf(cpu) e86_get_f (cpu, E86_FLG_C)
+#define e86_get_pf(cpu) e86_get_f (cpu, E86_FLG_P)
+#define e86_get_af(cpu) e86_get_f (cpu, E86_FLG_A)
+#define e86_get_zf(cpu) e86_get_f (cpu, E86_FLG_Z)
+#define e86_get_of(cpu) e86_get_f (cpu, E86_FLG_O)
+#define e86_get_sf(cpu) e86_get_f (cpu, E86_FLG_S)
+
+/* these flags are never evaluated lazily */
 #define e86_get_df(cpu) (((cpu)->flg & E86_FLG_D) != 0)
 #define e86_get_if(cpu) (((cpu)->flg & E86_FLG_I) != 0)
 #define e86_get_tf(cpu) (((cpu)->flg & E86_FLG_T) != 0)
 
 
-#define e86_set_flags(c, v) do { (c)->flg = (v) & 0xffffU; } while (0)
+#define e86_set_flags(c, v) \
+	do { \
+		unsigned short e86_flg_v = (v) & 0xffffU; \
+		(c)->lflg.msk = 0; \
+		(c)->flg = e86_flg_v; \
+	} while (0)
 
 #define e86_set_f(c, f, v) \
-	do { if (v) (c)->flg |= (f); else (c)->flg &= ~(f); } while (0)
+	do { \
+		int e86_flg_v = ((v) != 0); \
+		(c)->lflg.msk &= ~(f); \
+		if (e86_flg_v) (c)->flg |= (f); else (c)->flg &= ~(f); \
+	} while (0)
 
 #define e86_set_cf(c, v) e86_set_f (c, E86_FLG_C, v)
 #define e86_set_pf(c, v) e86_set_f (c, E86_FLG_P, v)
@@ -279,17 +393,49 @@ typedef struct e8086_t {
 static inline
 unsigned char e86_get_mem8 (e8086_t *c, unsigned short seg, unsigned short ofs)
 {
+	unsigned char *p;
 	unsigned long addr = e86_get_linear (seg, ofs) & c->addr_mask;
-	return ((addr < c->ram_cnt) ? c->ram[addr] : c->mem_get_uint8 (c->mem, addr));
+
+	if (addr < c->ram_cnt) {
+		return (c->ram[addr]);
+	}
+
+	if ((p = c->map_rd[addr >> E86_MAP_BITS]) != NULL) {
+		return (p[addr & E86_MAP_MASK]);
+	}
+
+	return (c->mem_get_uint8 (c->mem, addr));
+}
+
+/*
+ * Invalidate cached instructions in the RAM page that contains addr
+ */
+static inline
+void e86_icache_write (e8086_t *c, unsigned long addr)
+{
+	unsigned long *pg;
+
+	if (c->ic_pgen != NULL) {
+		pg = c->ic_pgen + addr / E86_IC_PAGE_SIZE;
+
+		if (*pg & 1) {
+			*pg += 1;
+		}
+	}
 }
 
 static inline
 void e86_set_mem8 (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned char val)
 {
+	unsigned char *p;
 	unsigned long addr = e86_get_linear (seg, ofs) & c->addr_mask;
 
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+		e86_icache_write (c, addr);
+	}
+	else if ((p = c->map_wr[addr >> E86_MAP_BITS]) != NULL) {
+		p[addr & E86_MAP_MASK] = val;
 	}
 	else {
 		c->mem_set_uint8 (c->mem, addr, val);
@@ -299,11 +445,16 @@ void e86_set_mem8 (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned
 static inline
 unsigned short e86_get_mem16 (e8086_t *c, unsigned short seg, unsigned short ofs)
 {
+	unsigned char *p;
 	unsigned long addr = e86_get_linear (seg, ofs) & c->addr_mask;
 
 	if ((addr + 1) < c->ram_cnt) {
 		return (c->ram[addr] + (c->ram[addr + 1] << 8));
 	}
+	else if (((addr & E86_MAP_MASK) < E86_MAP_MASK) && ((p = c->map_rd[addr >> E86_MAP_BITS]) != NULL)) {
+		p += addr & E86_MAP_MASK;
+		return (p[0] + (p[1] << 8));
+	}
 	else {
 		return (c->mem_get_uint16 (c->mem, addr));
 	}
@@ -312,11 +463,19 @@ unsigned short e86_get_mem16 (e8086_t *c, unsigned short seg, unsigned short ofs
 static inline
 void e86_set_mem16 (e8086_t *c, unsigned short seg, unsigned short ofs, unsigned short val)
 {
+	unsigned char *p;
 	unsigned long addr = e86_get_linear (seg, ofs) & c->addr_mask;
 
 	if ((addr + 1) < c->ram_cnt) {
 		c->ram[addr] = val & 0xff;
 		c->ram[addr + 1] = (val >> 8) & 0xff;
+		e86_icache_write (c, addr);
+		e86_icache_write (c, addr + 1);
+	}
+	else if (((addr & E86_MAP_MASK) < E86_MAP_MASK) && ((p = c->map_wr[addr >> E86_MAP_BITS]) != NULL)) {
+		p += addr & E86_MAP_MASK;
+		p[0] = val & 0xff;
+		p[1] = (val >> 8) & 0xff;
 	}
 	else {
 		c->mem_set_uint16 (c->mem, addr, val);
@@ -358,6 +517,38 @@ void e86_set_v20 (e8086_t *c);
  *****************************************************************************/
 void e86_set_pq_size (e8086_t *c, unsigned size);
 
+/*!***************************************************************************
+ * @short  Enable or disable the instruction cache
+ * @param  enable If true, instructions are executed from the instruction
+ *                cache instead of the prefetch queue
+ * @return Non-zero on error
+ *****************************************************************************/
+int e86_set_icache (e8086_t *c, int enable);
+
+/*!***************************************************************************
+ * @short Invalidate cached instructions
+ *
+ * This must be called if RAM is modified by anything other than the CPU.
+ *****************************************************************************/
+void e86_icache_invalidate (e8086_t *c, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short Invalidate all cached instructions
+ *****************************************************************************/
+void e86_icache_flush (e8086_t *c);
+
+/*!***************************************************************************
+ * @short  Enable or disable call threaded code
+ *
+ * Frequently executed code is turned into blocks of calls to the opcode
+ * handlers. This is only available on x86-64 Linux hosts. It implies
+ * the instruction cache. Clock cycles are only approximated and
+ * interrupts are only recognized between blocks.
+ *
+ * @return Non-zero if threaded code is not available
+ *****************************************************************************/
+int e86_set_jit (e8086_t *c, int enable);
+
 /*!***************************************************************************
  * @short Set CPU options
  * @param opt A bit mask indicating the desired options
@@ -382,6 +573,31 @@ void e86_set_prt (e8086_t *c, void *prt,
 	e86_get_uint16_f get16, e86_set_uint16_f set16
 );
 
+/*!***************************************************************************
+ * @short Set host pointers for memory outside of ram
+ * @param addr The linear start address, a multiple of E86_MAP_SIZE
+ * @param size The size in bytes, a multiple of E86_MAP_SIZE
+ * @param rd   The data used for reads or NULL
+ * @param wr   The data used for writes or NULL
+ *
+ * Reads and writes for which the pointer is NULL use the functions set
+ * with e86_set_mem().
+ *****************************************************************************/
+void e86_set_mem_map (e8086_t *c, unsigned long addr, unsigned long size,
+	void *rd, void *wr
+);
+
+/*!***************************************************************************
+ * @short Set the memory map update function
+ * @param ext The parameter for fct
+ * @param fct Called to set up the memory map with e86_set_mem_map()
+ * @param gen The memory map is updated before executing the next
+ *            instruction whenever *gen changes
+ *****************************************************************************/
+void e86_set_mem_map_fct (e8086_t *c, void *ext, void *fct,
+	const unsigned long *gen
+);
+
 int e86_get_reg (e8086_t *c, const char *reg, unsigned long *val);
 int e86_set_reg (e8086_t *c, const char *reg, unsigned long val);
 
@@ -399,8 +615,30 @@ void e86_reset (e8086_t *c);
 
 void e86_execute (e8086_t *c);
 
+/*!***************************************************************************
+ * @short Execute instructions for n clock cycles
+ *
+ * If e86_clock_break() is called while executing an instruction,
+ * e86_clock() returns after that instruction and the remaining clock
+ * cycles are not used.
+ *****************************************************************************/
 void e86_clock (e8086_t *c, unsigned n);
 
+/*!***************************************************************************
+ * @short Make the current call to e86_clock() return early
+ *
+ * This is used by devices that are accessed by the CPU, if the access
+ * changes the time of the next device event.
+ *****************************************************************************/
+void e86_clock_break (e8086_t *c);
+
+/*!***************************************************************************
+ * @short Advance the clock by n cycles without executing instructions
+ *
+ * This is used to fast forward over idle loops.
+ *****************************************************************************/
+void e86_skip (e8086_t *c, unsigned long n);
+
 
 void e86_push (e8086_t *c, unsigned short val);
 unsigned short e86_pop (e8086_t *c);
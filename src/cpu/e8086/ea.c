@@ -347,15 +347,7 @@ unsigned char e86_get_ea8 (e8086_t *c)
 
 unsigned short e86_get_ea16 (e8086_t *c)
 {
-	if (c->ea.is_mem) {
-		if ((c->cpu & E86_CPU_8BIT) || (c->ea.ofs & 1)) {
-			c->delay += 4;
-		}
-
-		return (e86_get_mem16 (c, c->ea.seg, c->ea.ofs));
-	}
-
-	return (e86_get_reg16 (c, c->ea.ofs));
+	return (e86_get_ea16_tmpl (c, (c->cpu & E86_CPU_8BIT) != 0));
 }
 
 void e86_set_ea8 (e8086_t *c, unsigned char val)
@@ -370,14 +362,5 @@ void e86_set_ea8 (e8086_t *c, unsigned char val)
 
 void e86_set_ea16 (e8086_t *c, unsigned short val)
 {
-	if (c->ea.is_mem) {
-		if ((c->cpu & E86_CPU_8BIT) || (c->ea.ofs & 1)) {
-			c->delay += 4;
-		}
-
-		e86_set_mem16 (c, c->ea.seg, c->ea.ofs, val);
-	}
-	else {
-		e86_set_reg16 (c, c->ea.ofs, val);
-	}
+	e86_set_ea16_tmpl (c, (c->cpu & E86_CPU_8BIT) != 0, val);
 }
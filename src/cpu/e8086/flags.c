@@ -49,276 +49,81 @@ char parity[256] = {
  * Flags functions
  *************************************************************************/
 
-void e86_set_flg_szp_8 (e8086_t *c, unsigned char val)
+unsigned e86_flg_eval (const e8086_t *c, unsigned msk)
 {
-	unsigned short set;
+	unsigned      op, set;
+	unsigned long s1, s2, dst;
+	unsigned long vmsk, smsk;
 
-	set = 0;
-
-	val &= 0xff;
+	op = c->lflg.op;
+	s1 = c->lflg.s1;
+	s2 = c->lflg.s2;
+	dst = c->lflg.dst;
 
-	if (val == 0) {
-		set |= E86_FLG_Z;
-	}
-	else if (val & 0x80) {
-		set |= E86_FLG_S;
+	if (op & E86_LFLG_16) {
+		vmsk = 0xffff;
+		smsk = 0x8000;
 	}
-
-	if (parity[val] == 0) {
-		set |= E86_FLG_P;
+	else {
+		vmsk = 0xff;
+		smsk = 0x80;
 	}
 
-	c->flg &= ~(E86_FLG_S | E86_FLG_Z | E86_FLG_P);
-	c->flg |= set;
-}
-
-void e86_set_flg_szp_16 (e8086_t *c, unsigned short val)
-{
-	unsigned short set;
-
 	set = 0;
 
-	if ((val & 0xffff) == 0) {
+	if ((dst & vmsk) == 0) {
 		set |= E86_FLG_Z;
 	}
-	else if (val & 0x8000) {
+	else if (dst & smsk) {
 		set |= E86_FLG_S;
 	}
 
-	if (parity[val & 0xff] == 0) {
+	if ((msk & E86_FLG_P) && (parity[dst & 0xff] == 0)) {
 		set |= E86_FLG_P;
 	}
 
-	c->flg &= ~(E86_FLG_S | E86_FLG_Z | E86_FLG_P);
-	c->flg |= set;
-}
-
-void e86_set_flg_log_8 (e8086_t *c, unsigned char val)
-{
-	e86_set_flg_szp_8 (c, val);
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O);
-}
-
-void e86_set_flg_log_16 (e8086_t *c, unsigned short val)
-{
-	e86_set_flg_szp_16 (c, val);
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O);
-}
-
-void e86_set_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2)
-{
-	unsigned short set;
-	unsigned short dst;
-
-	e86_set_flg_szp_8 (c, s1 + s2);
-
-	set = 0;
-
-	dst = (unsigned short) s1 + (unsigned short) s2;
-
-	if (dst & 0xff00) {
-		set |= E86_FLG_C;
-	}
-
-	if ((dst ^ s1) & (dst ^ s2) & 0x80) {
-		set |= E86_FLG_O;
-	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
-}
-
-void e86_set_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2)
-{
-	unsigned short set;
-	unsigned long  dst;
-
-	e86_set_flg_szp_16 (c, s1 + s2);
-
-	set = 0;
-
-	dst = (unsigned long) s1 + (unsigned long) s2;
-
-	if (dst & 0xffff0000) {
-		set |= E86_FLG_C;
-	}
-
-	if ((dst ^ s1) & (dst ^ s2) & 0x8000) {
-		set |= E86_FLG_O;
-	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
-}
-
-void e86_set_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
-{
-	unsigned short set;
-	unsigned short dst;
-
-	e86_set_flg_szp_8 (c, s1 + s2 + s3);
-
-	set = 0;
-
-	dst = (unsigned short) s1 + (unsigned short) s2 + (unsigned short) s3;
-
-	if (dst & 0xff00) {
-		set |= E86_FLG_C;
-	}
-
-	if ((dst ^ s1) & (dst ^ s2) & 0x80) {
-		set |= E86_FLG_O;
-	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
-}
-
-void e86_set_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
-{
-	unsigned short set;
-	unsigned long  dst;
-
-	e86_set_flg_szp_16 (c, s1 + s2 + s3);
-
-	set = 0;
-
-	dst = (unsigned long) s1 + (unsigned long) s2 + (unsigned long) s3;
-
-	if (dst & 0xffff0000) {
+	if (dst & ~vmsk) {
 		set |= E86_FLG_C;
 	}
 
-	if ((dst ^ s1) & (dst ^ s2) & 0x8000) {
-		set |= E86_FLG_O;
-	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
-}
-
-void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
-{
-	unsigned short set;
-	unsigned short dst;
-
-	e86_set_flg_szp_8 (c, s1 - s2 - s3);
-
-	set = 0;
-
-	dst = s1 - s2 - s3;
-
-	if (dst & 0xff00) {
-		set |= E86_FLG_C;
-	}
-
-	if ((s1 ^ dst) & (s1 ^ s2) & 0x80) {
-		set |= E86_FLG_O;
-	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
-}
-
-void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
-{
-	unsigned short set;
-	unsigned long  dst;
-
-	e86_set_flg_szp_16 (c, s1 - s2 - s3);
-
-	set = 0;
+	switch (op & ~E86_LFLG_16) {
+	case E86_LFLG_ADD:
+		if ((dst ^ s1) & (dst ^ s2) & smsk) {
+			set |= E86_FLG_O;
+		}
 
-	dst = (unsigned long) s1 - (unsigned long) s2 - (unsigned long) s3;
+		if ((s1 ^ s2 ^ dst) & 0x10) {
+			set |= E86_FLG_A;
+		}
+		break;
 
-	if (dst & 0xffff0000) {
-		set |= E86_FLG_C;
-	}
-
-	if ((s1 ^ dst) & (s1 ^ s2) & 0x8000) {
-		set |= E86_FLG_O;
-	}
+	case E86_LFLG_SUB:
+		if ((s1 ^ dst) & (s1 ^ s2) & smsk) {
+			set |= E86_FLG_O;
+		}
 
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
+		if ((s1 ^ s2 ^ dst) & 0x10) {
+			set |= E86_FLG_A;
+		}
+		break;
 	}
 
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
+	return (set & msk);
 }
 
-void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+/*
+ * Evaluate the lazy flags in msk and store them in c->flg
+ */
+void e86_flg_flush (e8086_t *c, unsigned msk)
 {
-	unsigned short set;
-	unsigned short dst;
-
-	e86_set_flg_szp_8 (c, s1 - s2);
-
-	set = 0;
-
-	dst = s1 - s2;
-
-	if (dst & 0xff00) {
-		set |= E86_FLG_C;
-	}
-
-	if ((s1 ^ dst) & (s1 ^ s2) & 0x80) {
-		set |= E86_FLG_O;
-	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
+	c->flg &= ~msk;
+	c->flg |= e86_flg_eval (c, msk);
+	c->lflg.msk &= ~msk;
 }
 
-void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+void e86_flg_sync (e8086_t *c)
 {
-	unsigned short set;
-	unsigned long  dst;
-
-	e86_set_flg_szp_16 (c, s1 - s2);
-
-	set = 0;
-
-	dst = (unsigned long) s1 - (unsigned long) s2;
-
-	if (dst & 0xffff0000) {
-		set |= E86_FLG_C;
-	}
-
-	if ((s1 ^ dst) & (s1 ^ s2) & 0x8000) {
-		set |= E86_FLG_O;
+	if (c->lflg.msk != 0) {
+		e86_flg_flush (c, c->lflg.msk);
 	}
-
-	if ((s1 ^ s2 ^ dst) & 0x10) {
-		set |= E86_FLG_A;
-	}
-
-	c->flg &= ~(E86_FLG_C | E86_FLG_O | E86_FLG_A);
-	c->flg |= set;
 }
@@ -0,0 +1,229 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e8086/icache.c                                       *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include "e8086.h"
+#include "internal.h"
+
+#include <stdlib.h>
+
+
+/*
+ * The instruction cache replaces the prefetch queue if enabled. It
+ * holds the instruction bytes and the opcode handler for instructions
+ * in RAM, indexed by linear address. The instruction bytes are used
+ * directly from the cache entry instead of being copied to the
+ * prefetch queue.
+ *
+ * Each RAM page has a generation number. The lowest bit of the
+ * generation number is set if there are cached instructions in the
+ * page. A write to such a page increments the generation number,
+ * which invalidates all entries in that page.
+ *
+ * Executing from the cache is the same as running with a prefetch
+ * queue size of 0.
+ */
+
+
+#define E86_IC_FETCH 6
+
+
+static
+void e86_icache_clear (e8086_t *c)
+{
+	unsigned long i;
+
+	/* translated code depends on the page generation numbers */
+	e86_jit_flush (c);
+
+	if (c->ic != NULL) {
+		for (i = 0; i < E86_IC_CNT; i++) {
+			c->ic[i].addr = ~0UL;
+			c->ic[i].gen = 0;
+		}
+	}
+
+	if (c->ic_pgen != NULL) {
+		for (i = 0; i < c->ic_pcnt; i++) {
+			c->ic_pgen[i] = 0;
+		}
+	}
+}
+
+static
+int e86_icache_alloc_pages (e8086_t *c)
+{
+	free (c->ic_pgen);
+
+	c->ic_pcnt = (c->ram_cnt + E86_IC_PAGE_SIZE - 1) / E86_IC_PAGE_SIZE;
+
+	if (c->ic_pcnt == 0) {
+		c->ic_pgen = NULL;
+		return (0);
+	}
+
+	c->ic_pgen = malloc (c->ic_pcnt * sizeof (unsigned long));
+
+	if (c->ic_pgen == NULL) {
+		c->ic_pcnt = 0;
+		return (1);
+	}
+
+	return (0);
+}
+
+int e86_set_icache (e8086_t *c, int enable)
+{
+	if (enable == 0) {
+		e86_set_jit (c, 0);
+
+		free (c->ic);
+		free (c->ic_pgen);
+
+		c->ic = NULL;
+		c->ic_pgen = NULL;
+		c->ic_pcnt = 0;
+
+		c->pq = c->pq_buf;
+		c->pq_cnt = 0;
+
+		e86_set_exec (c);
+
+		return (0);
+	}
+
+	if (c->ic == NULL) {
+		c->ic = malloc (E86_IC_CNT * sizeof (e86_icache_ent_t));
+
+		if (c->ic == NULL) {
+			return (1);
+		}
+	}
+
+	if (e86_icache_alloc_pages (c)) {
+		e86_set_icache (c, 0);
+		return (1);
+	}
+
+	e86_icache_clear (c);
+
+	c->pq_cnt = 0;
+
+	e86_set_exec (c);
+
+	return (0);
+}
+
+void e86_icache_ram_changed (e8086_t *c)
+{
+	if (c->ic == NULL) {
+		return;
+	}
+
+	if (e86_icache_alloc_pages (c)) {
+		e86_set_icache (c, 0);
+		return;
+	}
+
+	e86_icache_clear (c);
+}
+
+void e86_icache_flush (e8086_t *c)
+{
+	unsigned long i;
+
+	for (i = 0; i < c->ic_pcnt; i++) {
+		if (c->ic_pgen[i] & 1) {
+			c->ic_pgen[i] += 1;
+		}
+	}
+}
+
+void e86_icache_invalidate (e8086_t *c, unsigned long addr, unsigned long cnt)
+{
+	unsigned long i, n;
+
+	if ((c->ic_pgen == NULL) || (cnt == 0)) {
+		return;
+	}
+
+	i = addr / E86_IC_PAGE_SIZE;
+	n = (addr + cnt - 1) / E86_IC_PAGE_SIZE;
+
+	while ((i <= n) && (i < c->ic_pcnt)) {
+		if (c->ic_pgen[i] & 1) {
+			c->ic_pgen[i] += 1;
+		}
+
+		i += 1;
+	}
+}
+
+/*
+ * Get the opcode handler for the instruction at CS:IP and set up c->pq
+ */
+e86_opcode_f e86_icache_fetch (e8086_t *c)
+{
+	unsigned         i;
+	unsigned short   ofs;
+	unsigned long    addr, *pg;
+	e86_icache_ent_t *ent;
+
+	ofs = e86_get_ip (c);
+	addr = e86_get_linear (e86_get_cs (c), ofs) & c->addr_mask;
+
+	if ((ofs > (0xffff - E86_IC_FETCH)) || ((addr + E86_IC_FETCH) > c->ram_cnt)) {
+		c->pq_cnt = 0;
+		e86_pq_fill (c);
+		c->pq_cnt = 0;
+
+		return (c->op[c->pq[0]]);
+	}
+
+	if (((addr + E86_IC_FETCH - 1) ^ addr) & ~(E86_IC_PAGE_SIZE - 1)) {
+		/* crossing a page boundary */
+		c->pq_cnt = 0;
+		e86_pq_fill (c);
+		c->pq_cnt = 0;
+
+		return (c->op[c->pq[0]]);
+	}
+
+	ent = &c->ic[(addr ^ (addr >> E86_IC_BITS)) & (E86_IC_CNT - 1)];
+	pg = &c->ic_pgen[addr / E86_IC_PAGE_SIZE];
+
+	if ((ent->addr != addr) || (ent->gen != *pg)) {
+		*pg |= 1;
+
+		ent->addr = addr;
+		ent->gen = *pg;
+
+		for (i = 0; i < E86_IC_FETCH; i++) {
+			ent->data[i] = c->ram[addr + i];
+		}
+
+		ent->op = c->op[ent->data[0]];
+	}
+
+	c->pq = ent->data;
+
+	return (ent->op);
+}
@@ -64,6 +64,7 @@ typedef void (*e86_ea_f) (e8086_t *c);
 
 
 extern e86_opcode_f e86_opcodes[256];
+extern e86_opcode_f e86_opcodes_8bit[256];
 extern e86_ea_f e86_ea[32];
 
 
@@ -73,22 +74,289 @@ unsigned short e86_get_ea16 (e8086_t *c);
 void e86_set_ea8 (e8086_t *c, unsigned char val);
 void e86_set_ea16 (e8086_t *c, unsigned short val);
 
+/*
+ * Get and set a 16 bit operand. If bus8 is non-zero, every 16 bit
+ * memory access takes 4 more clocks, otherwise only unaligned accesses
+ * do. opcodes.c is compiled once for each bus width and calls these
+ * with bus8 constant, e86_get_ea16() and e86_set_ea16() test
+ * E86_CPU_8BIT.
+ */
+static inline
+unsigned short e86_get_ea16_tmpl (e8086_t *c, int bus8)
+{
+	if (c->ea.is_mem) {
+		if (bus8 || (c->ea.ofs & 1)) {
+			c->delay += 4;
+		}
 
-void e86_pq_adjust (e8086_t *c, unsigned cnt);
+		return (e86_get_mem16 (c, c->ea.seg, c->ea.ofs));
+	}
 
+	return (e86_get_reg16 (c, c->ea.ofs));
+}
 
-void e86_set_flg_szp_8 (e8086_t *c, unsigned char val);
-void e86_set_flg_szp_16 (e8086_t *c, unsigned short val);
-void e86_set_flg_log_8 (e8086_t *c, unsigned char val);
-void e86_set_flg_log_16 (e8086_t *c, unsigned short val);
-void e86_set_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3);
-void e86_set_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3);
-void e86_set_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2);
-void e86_set_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2);
-void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3);
-void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3);
-void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2);
-void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2);
+static inline
+void e86_set_ea16_tmpl (e8086_t *c, int bus8, unsigned short val)
+{
+	if (c->ea.is_mem) {
+		if (bus8 || (c->ea.ofs & 1)) {
+			c->delay += 4;
+		}
 
+		e86_set_mem16 (c, c->ea.seg, c->ea.ofs, val);
+	}
+	else {
+		e86_set_reg16 (c, c->ea.ofs, val);
+	}
+}
+
+
+/*
+ * Fill the prefetch queue. The queue geometry is passed as arguments so
+ * that the execution loop can be compiled with constant values.
+ */
+static inline
+void e86_pq_fill_n (e8086_t *c, unsigned size, unsigned fill)
+{
+	unsigned       i;
+	unsigned short val;
+	unsigned short seg, ofs;
+	unsigned long  addr;
+	unsigned char  *p;
+
+	seg = e86_get_cs (c);
+	ofs = e86_get_ip (c);
+
+	c->pq = c->pq_buf;
+
+	if (ofs <= (0xffff - fill)) {
+		/* all within one segment */
+
+		addr = e86_get_linear (seg, ofs) & c->addr_mask;
+
+		if ((addr + fill) <= c->ram_cnt) {
+			for (i = c->pq_cnt; i < fill; i++) {
+				c->pq[i] = c->ram[addr + i];
+			}
+		}
+		else if ((((addr & E86_MAP_MASK) + fill) <= E86_MAP_SIZE) && (c->map_rd[addr >> E86_MAP_BITS] != NULL)) {
+			p = c->map_rd[addr >> E86_MAP_BITS] + (addr & E86_MAP_MASK);
+
+			for (i = c->pq_cnt; i < fill; i++) {
+				c->pq[i] = p[i];
+			}
+		}
+		else {
+			i = c->pq_cnt;
+			while (i < fill) {
+				val = c->mem_get_uint16 (c->mem, (addr + i) & c->addr_mask);
+				c->pq[i] = val & 0xff;
+				c->pq[i + 1] = (val >> 8) & 0xff;
+				i += 2;
+			}
+		}
+	}
+	else {
+		i = c->pq_cnt;
+		while (i < fill) {
+			val = e86_get_mem16 (c, seg, ofs + i);
+			c->pq[i] = val & 0xff;
+			c->pq[i + 1] = (val >> 8) & 0xff;
+
+			i += 2;
+		}
+	}
+
+	c->pq_cnt = size;
+}
+
+/*
+ * Remove cnt bytes from the prefetch queue and copy the rest to the front
+ */
+static inline
+void e86_pq_adjust (e8086_t *c, unsigned cnt)
+{
+	unsigned      n;
+	unsigned char *d, *s;
+
+	if (cnt >= c->pq_cnt) {
+		c->pq_cnt = 0;
+		return;
+	}
+
+	n = c->pq_cnt - cnt;
+	s = c->pq + cnt;
+	d = c->pq;
+
+	while (n > 0) {
+		*(d++) = *(s++);
+		n -= 1;
+	}
+
+	c->pq_cnt -= cnt;
+}
+
+/*
+ * Select the execution loop variant and the opcode handlers for the
+ * current configuration
+ */
+void e86_set_exec (e8086_t *c);
+
+void e86_icache_ram_changed (e8086_t *c);
+e86_opcode_f e86_icache_fetch (e8086_t *c);
+
+void e86_jit_flush (e8086_t *c);
+unsigned e86_jit_exec (e8086_t *c);
+
+
+void e86_flg_flush (e8086_t *c, unsigned msk);
+
+/*
+ * Record a flag setting operation. The flags in msk will be computed
+ * when they are used. Pending flags not in msk are evaluated now.
+ */
+static inline
+void e86_set_lflg (e8086_t *c, unsigned op, unsigned msk,
+	unsigned long s1, unsigned long s2, unsigned long dst)
+{
+	if (c->lflg.msk & ~msk) {
+		e86_flg_flush (c, c->lflg.msk & ~msk);
+	}
+
+	c->lflg.op = op;
+	c->lflg.msk = msk;
+	c->lflg.s1 = s1;
+	c->lflg.s2 = s2;
+	c->lflg.dst = dst;
+}
+
+static inline
+void e86_set_flg_szp_8 (e8086_t *c, unsigned char val)
+{
+	e86_set_lflg (c, E86_LFLG_LOG, E86_FLG_S | E86_FLG_Z | E86_FLG_P,
+		0, 0, val & 0xff
+	);
+}
+
+static inline
+void e86_set_flg_szp_16 (e8086_t *c, unsigned short val)
+{
+	e86_set_lflg (c, E86_LFLG_LOG | E86_LFLG_16,
+		E86_FLG_S | E86_FLG_Z | E86_FLG_P, 0, 0, val & 0xffff
+	);
+}
+
+static inline
+void e86_set_flg_log_8 (e8086_t *c, unsigned char val)
+{
+	e86_set_lflg (c, E86_LFLG_LOG, E86_FLG_ARITH & ~E86_FLG_A,
+		0, 0, val & 0xff
+	);
+}
+
+static inline
+void e86_set_flg_log_16 (e8086_t *c, unsigned short val)
+{
+	e86_set_lflg (c, E86_LFLG_LOG | E86_LFLG_16,
+		E86_FLG_ARITH & ~E86_FLG_A, 0, 0, val & 0xffff
+	);
+}
+
+static inline
+void e86_set_flg_adc_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
+{
+	e86_set_lflg (c, E86_LFLG_ADD, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 + s2 + s3
+	);
+}
+
+static inline
+void e86_set_flg_adc_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
+{
+	e86_set_lflg (c, E86_LFLG_ADD | E86_LFLG_16, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 + s2 + s3
+	);
+}
+
+static inline
+void e86_set_flg_add_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+{
+	e86_set_lflg (c, E86_LFLG_ADD, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 + s2
+	);
+}
+
+static inline
+void e86_set_flg_add_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+{
+	e86_set_lflg (c, E86_LFLG_ADD | E86_LFLG_16, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 + s2
+	);
+}
+
+static inline
+void e86_set_flg_sbb_8 (e8086_t *c, unsigned char s1, unsigned char s2, unsigned char s3)
+{
+	e86_set_lflg (c, E86_LFLG_SUB, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 - s2 - s3
+	);
+}
+
+static inline
+void e86_set_flg_sbb_16 (e8086_t *c, unsigned short s1, unsigned short s2, unsigned short s3)
+{
+	e86_set_lflg (c, E86_LFLG_SUB | E86_LFLG_16, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 - s2 - s3
+	);
+}
+
+static inline
+void e86_set_flg_sub_8 (e8086_t *c, unsigned char s1, unsigned char s2)
+{
+	e86_set_lflg (c, E86_LFLG_SUB, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 - s2
+	);
+}
+
+static inline
+void e86_set_flg_sub_16 (e8086_t *c, unsigned short s1, unsigned short s2)
+{
+	e86_set_lflg (c, E86_LFLG_SUB | E86_LFLG_16, E86_FLG_ARITH, s1, s2,
+		(unsigned long) s1 - s2
+	);
+}
+
+/* INC and DEC don't modify the carry flag */
+static inline
+void e86_set_flg_inc_8 (e8086_t *c, unsigned char s)
+{
+	e86_set_lflg (c, E86_LFLG_ADD, E86_FLG_ARITH & ~E86_FLG_C, s, 1,
+		(unsigned long) s + 1
+	);
+}
+
+static inline
+void e86_set_flg_inc_16 (e8086_t *c, unsigned short s)
+{
+	e86_set_lflg (c, E86_LFLG_ADD | E86_LFLG_16, E86_FLG_ARITH & ~E86_FLG_C,
+		s, 1, (unsigned long) s + 1
+	);
+}
+
+static inline
+void e86_set_flg_dec_8 (e8086_t *c, unsigned char s)
+{
+	e86_set_lflg (c, E86_LFLG_SUB, E86_FLG_ARITH & ~E86_FLG_C, s, 1,
+		(unsigned long) s - 1
+	);
+}
+
+static inline
+void e86_set_flg_dec_16 (e8086_t *c, unsigned short s)
+{
+	e86_set_lflg (c, E86_LFLG_SUB | E86_LFLG_16, E86_FLG_ARITH & ~E86_FLG_C,
+		s, 1, (unsigned long) s - 1
+	);
+}
 
 #endif
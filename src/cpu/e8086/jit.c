@@ -0,0 +1,855 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/e8086/jit.c                                          *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <config.h>
+
+#include "e8086.h"
+#include "internal.h"
+
+#include <stdlib.h>
+
+
+/*
+ * Frequently executed straight line code in RAM is turned into call
+ * threaded x86-64 host code. This is not a translator: a block is a
+ * sequence of calls to the interpreter's opcode handlers with the
+ * instruction pointer, the prefix state and the instruction bytes set
+ * up in between, so it does exactly what the interpreter would do for
+ * each instruction. It only saves the instruction decoding and the
+ * dispatch. Register and immediate MOV instructions are the only ones
+ * that are emitted as host instructions directly.
+ *
+ * A block ends at a control transfer instruction. If an opcode
+ * handler returns something other than the instruction length (a
+ * taken branch, an exception or an unknown instruction) the block
+ * is left immediately. Instructions that access I/O ports, halt the
+ * CPU, use a REP or LOCK prefix or call the emulator hook are never
+ * translated and are left to the interpreter.
+ *
+ * Blocks are invalidated using the instruction cache page generation
+ * numbers. A block is also left as soon as an instruction modifies
+ * the page it was translated from.
+ *
+ * The clock cycles of each instruction are added to the CPU delay
+ * before the next one starts. Like e86_clock(), a block stops once
+ * the delay exceeds the clocks that were left when it was entered,
+ * so it never runs past the next device event. Interrupts are only
+ * checked between blocks.
+ */
+
+
+#if defined(PCE_HOST_X86_64) && defined(PCE_HOST_LINUX)
+#define E86_JIT_X86_64 1
+#endif
+
+
+#ifdef E86_JIT_X86_64
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+
+#define E86_JIT_BLK_BITS  12
+#define E86_JIT_BLK_CNT   (1UL << E86_JIT_BLK_BITS)
+
+/* the number of executions before a block is translated */
+#define E86_JIT_HOT       16
+
+/* the maximum number of instructions per block */
+#define E86_JIT_INSN_MAX  32
+
+/* the maximum size of a translated block */
+#define E86_JIT_CODE_MAX  (E86_JIT_INSN_MAX * 320 + 64)
+
+#define E86_JIT_MEM_SIZE  (4UL * 1024 * 1024)
+
+#define E86_JIT_FETCH     6
+
+#define E86_JIT_OFS(f)    ((unsigned long) offsetof (e8086_t, f))
+
+
+typedef unsigned (*e86_jit_code_f) (e8086_t *c);
+
+typedef struct {
+	unsigned long  addr;
+	unsigned short ip;
+	unsigned long  gen;
+	unsigned       cnt;
+	e86_jit_code_f code;
+} e86_jit_blk_t;
+
+struct e86_jit_t {
+	e86_jit_blk_t  blk[E86_JIT_BLK_CNT];
+
+	unsigned char  *mem;
+	unsigned long  mem_used;
+};
+
+
+static
+void e86_jit_emit8 (unsigned char **p, unsigned val)
+{
+	*((*p)++) = val & 0xff;
+}
+
+static
+void e86_jit_emit16 (unsigned char **p, unsigned val)
+{
+	e86_jit_emit8 (p, val);
+	e86_jit_emit8 (p, val >> 8);
+}
+
+static
+void e86_jit_emit32 (unsigned char **p, unsigned long val)
+{
+	e86_jit_emit16 (p, val & 0xffff);
+	e86_jit_emit16 (p, (val >> 16) & 0xffff);
+}
+
+static
+void e86_jit_emit64 (unsigned char **p, unsigned long val)
+{
+	e86_jit_emit32 (p, val & 0xffffffff);
+	e86_jit_emit32 (p, (val >> 32) & 0xffffffff);
+}
+
+/* op [rbx + ofs], with a 32 bit displacement */
+static
+void e86_jit_emit_rbx (unsigned char **p, unsigned modrm, unsigned long ofs)
+{
+	e86_jit_emit8 (p, 0x80 | (modrm & 0x38) | 3);
+	e86_jit_emit32 (p, ofs);
+}
+
+/* mov rax, imm64 */
+static
+void e86_jit_emit_mov_rax (unsigned char **p, const void *ptr)
+{
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0xb8);
+	e86_jit_emit64 (p, (unsigned long) ptr);
+}
+
+/* mov word [rbx + ofs], imm16 */
+static
+void e86_jit_emit_set16 (unsigned char **p, unsigned long ofs, unsigned val)
+{
+	e86_jit_emit8 (p, 0x66);
+	e86_jit_emit8 (p, 0xc7);
+	e86_jit_emit_rbx (p, 0, ofs);
+	e86_jit_emit16 (p, val);
+}
+
+/* add qword [rbx + delay], imm32 */
+static
+void e86_jit_emit_clk (unsigned char **p, unsigned long *clk)
+{
+	if (*clk == 0) {
+		return;
+	}
+
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x81);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (delay));
+	e86_jit_emit32 (p, *clk);
+
+	*clk = 0;
+}
+
+/* mov eax, cnt; add rsp, 16; pop rbx; ret */
+static
+void e86_jit_emit_ret (unsigned char **p, unsigned cnt)
+{
+	e86_jit_emit8 (p, 0xb8);
+	e86_jit_emit32 (p, cnt);
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x83);
+	e86_jit_emit8 (p, 0xc4);
+	e86_jit_emit8 (p, 0x10);
+	e86_jit_emit8 (p, 0x5b);
+	e86_jit_emit8 (p, 0xc3);
+}
+
+/*
+ * Move the delay accumulated so far to [rsp] and start the next
+ * instruction with a delay of 0, like e86_execute() does. Some
+ * opcode handlers reset the delay instead of adding to it.
+ */
+static
+void e86_jit_emit_save_delay (unsigned char **p)
+{
+	/* mov rax, [rbx + delay] */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x8b);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (delay));
+
+	/* mov [rsp], rax */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x89);
+	e86_jit_emit8 (p, 0x04);
+	e86_jit_emit8 (p, 0x24);
+
+	/* mov qword [rbx + delay], 0 */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0xc7);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (delay));
+	e86_jit_emit32 (p, 0);
+}
+
+/* add the delay saved by e86_jit_emit_save_delay() */
+static
+void e86_jit_emit_restore_delay (unsigned char **p)
+{
+	/* mov rcx, [rsp] */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x8b);
+	e86_jit_emit8 (p, 0x0c);
+	e86_jit_emit8 (p, 0x24);
+
+	/* add [rbx + delay], rcx */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x01);
+	e86_jit_emit_rbx (p, 0x08, E86_JIT_OFS (delay));
+}
+
+/* set c->pq and call an opcode handler */
+static
+void e86_jit_emit_call (unsigned char **p, const unsigned char *pq, e86_opcode_f op)
+{
+	e86_jit_emit_mov_rax (p, pq);
+
+	/* mov [rbx + pq], rax */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x89);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (pq));
+
+	/* mov rdi, rbx */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x89);
+	e86_jit_emit8 (p, 0xdf);
+
+	e86_jit_emit_mov_rax (p, (const void *) op);
+
+	/* call rax */
+	e86_jit_emit8 (p, 0xff);
+	e86_jit_emit8 (p, 0xd0);
+}
+
+/*
+ * Leave the block unless the opcode handler returned len. Otherwise
+ * finish the instruction the way e86_execute() does.
+ */
+static
+void e86_jit_emit_check_len (unsigned char **p, unsigned len, unsigned cnt, int always)
+{
+	unsigned char *next, *zero, *ret;
+
+	if (always == 0) {
+		/* cmp eax, len; je next */
+		e86_jit_emit8 (p, 0x3d);
+		e86_jit_emit32 (p, len);
+		e86_jit_emit8 (p, 0x74);
+		next = (*p)++;
+	}
+	else {
+		next = NULL;
+	}
+
+	/* test eax, eax; jz zero */
+	e86_jit_emit8 (p, 0x85);
+	e86_jit_emit8 (p, 0xc0);
+	e86_jit_emit8 (p, 0x74);
+	zero = (*p)++;
+
+	/* add [rbx + ip], ax; jmp ret */
+	e86_jit_emit8 (p, 0x66);
+	e86_jit_emit8 (p, 0x01);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (ip));
+	e86_jit_emit8 (p, 0xeb);
+	ret = (*p)++;
+
+	/* add qword [rbx + delay], 10 */
+	*zero = *p - zero - 1;
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x83);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (delay));
+	e86_jit_emit8 (p, 10);
+
+	*ret = *p - ret - 1;
+	e86_jit_emit_ret (p, cnt);
+
+	if (next != NULL) {
+		*next = *p - next - 1;
+	}
+}
+
+/*
+ * Leave the block if the page it was translated from was modified.
+ */
+static
+void e86_jit_emit_check_gen (unsigned char **p, const unsigned long *pg, unsigned long gen, unsigned short ip, unsigned cnt)
+{
+	unsigned char *next;
+
+	e86_jit_emit_mov_rax (p, pg);
+
+	/* mov rax, [rax] */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x8b);
+	e86_jit_emit8 (p, 0x00);
+
+	/* mov rcx, gen */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0xb9);
+	e86_jit_emit64 (p, gen);
+
+	/* cmp rax, rcx; je next */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x39);
+	e86_jit_emit8 (p, 0xc8);
+	e86_jit_emit8 (p, 0x74);
+	next = (*p)++;
+
+	e86_jit_emit_set16 (p, E86_JIT_OFS (ip), ip);
+	e86_jit_emit_ret (p, cnt);
+
+	*next = *p - next - 1;
+}
+
+/*
+ * Leave the block if e86_clock() would not execute the next
+ * instruction: the delay accumulated so far exceeds the clocks that
+ * were left when the block was entered, or the clock was stopped.
+ */
+static
+void e86_jit_emit_check_clk (unsigned char **p, unsigned short ip, unsigned cnt)
+{
+	unsigned char *ret, *next;
+
+	/* cmp dword [rbx + clk_break], 0; jne ret */
+	e86_jit_emit8 (p, 0x83);
+	e86_jit_emit_rbx (p, 0x38, E86_JIT_OFS (clk_break));
+	e86_jit_emit8 (p, 0);
+	e86_jit_emit8 (p, 0x75);
+	ret = (*p)++;
+
+	/* mov rax, [rbx + delay] */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x8b);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (delay));
+
+	/* cmp rax, [rbx + clk_rem]; jbe next */
+	e86_jit_emit8 (p, 0x48);
+	e86_jit_emit8 (p, 0x3b);
+	e86_jit_emit_rbx (p, 0, E86_JIT_OFS (clk_rem));
+	e86_jit_emit8 (p, 0x76);
+	next = (*p)++;
+
+	*ret = *p - ret - 1;
+	e86_jit_emit_set16 (p, E86_JIT_OFS (ip), ip);
+	e86_jit_emit_ret (p, cnt);
+
+	*next = *p - next - 1;
+}
+
+/*
+ * Translate register and immediate MOV instructions directly
+ */
+static
+int e86_jit_emit_native (unsigned char **p, const unsigned char *src, unsigned long *clk)
+{
+	unsigned op, r, d, s;
+
+	op = src[0];
+
+	if (((op == 0x89) || (op == 0x8b)) && ((src[1] & 0xc0) == 0xc0)) {
+		r = (src[1] >> 3) & 7;
+
+		d = (op == 0x89) ? (src[1] & 7) : r;
+		s = (op == 0x89) ? r : (src[1] & 7);
+
+		/* movzx eax, word [rbx + dreg + 2 * s] */
+		e86_jit_emit8 (p, 0x0f);
+		e86_jit_emit8 (p, 0xb7);
+		e86_jit_emit_rbx (p, 0, E86_JIT_OFS (dreg) + 2 * s);
+
+		/* mov [rbx + dreg + 2 * d], ax */
+		e86_jit_emit8 (p, 0x66);
+		e86_jit_emit8 (p, 0x89);
+		e86_jit_emit_rbx (p, 0, E86_JIT_OFS (dreg) + 2 * d);
+
+		*clk += 2;
+
+		return (2);
+	}
+
+	if ((op >= 0xb0) && (op <= 0xb7)) {
+		r = op & 7;
+
+		/* mov byte [rbx + dreg], imm8 */
+		e86_jit_emit8 (p, 0xc6);
+		e86_jit_emit_rbx (p, 0,
+			E86_JIT_OFS (dreg) + 2 * (r & 3) + ((r >> 2) & 1)
+		);
+		e86_jit_emit8 (p, src[1]);
+
+		*clk += 4;
+
+		return (2);
+	}
+
+	if ((op >= 0xb8) && (op <= 0xbf)) {
+		r = op & 7;
+
+		e86_jit_emit_set16 (p, E86_JIT_OFS (dreg) + 2 * r,
+			e86_mk_uint16 (src[1], src[2])
+		);
+
+		*clk += 4;
+
+		return (3);
+	}
+
+	return (0);
+}
+
+static
+int e86_jit_is_prefix (unsigned op)
+{
+	switch (op) {
+	case 0x26:
+	case 0x2e:
+	case 0x36:
+	case 0x3e:
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Check if an instruction is left to the interpreter
+ */
+static
+int e86_jit_is_excluded (unsigned op)
+{
+	if ((op >= 0x6c) && (op <= 0x6f)) {
+		/* INS / OUTS */
+		return (1);
+	}
+
+	if (((op >= 0xe4) && (op <= 0xe7)) || ((op >= 0xec) && (op <= 0xef))) {
+		/* IN / OUT */
+		return (1);
+	}
+
+	switch (op) {
+	case 0x0f: /* POP CS / extended opcodes */
+	case 0x66: /* hook */
+	case 0xf0: /* LOCK */
+	case 0xf2: /* REPNE */
+	case 0xf3: /* REP */
+	case 0xf4: /* HLT */
+		return (1);
+	}
+
+	return (e86_jit_is_prefix (op));
+}
+
+/*
+ * Check if an instruction ends a block
+ */
+static
+int e86_jit_is_last (unsigned op, unsigned modrm)
+{
+	if ((op >= 0x70) && (op <= 0x7f)) {
+		return (1);
+	}
+
+	if ((op >= 0xe0) && (op <= 0xeb)) {
+		return (1);
+	}
+
+	switch (op) {
+	case 0x8e: /* MOV sreg, r/m16 */
+	case 0x9a: /* CALL far */
+	case 0x9d: /* POPF */
+	case 0xc2:
+	case 0xc3:
+	case 0xca:
+	case 0xcb:
+	case 0xcc:
+	case 0xcd:
+	case 0xce:
+	case 0xcf:
+		return (1);
+
+	case 0xff:
+		modrm = (modrm >> 3) & 7;
+		return ((modrm >= 2) && (modrm <= 5));
+	}
+
+	return (0);
+}
+
+static
+unsigned e86_jit_get_len (e8086_t *c, unsigned long addr, unsigned short ip)
+{
+	unsigned     i;
+	unsigned char buf[16];
+	e86_disasm_t op;
+
+	for (i = 0; i < 16; i++) {
+		buf[i] = ((addr + i) < c->ram_cnt) ? c->ram[addr + i] : 0;
+	}
+
+	e86_disasm (&op, buf, ip);
+
+	return (op.dat_n);
+}
+
+static
+void e86_jit_clear (struct e86_jit_t *jit)
+{
+	unsigned long i;
+
+	for (i = 0; i < E86_JIT_BLK_CNT; i++) {
+		jit->blk[i].addr = ~0UL;
+		jit->blk[i].ip = 0;
+		jit->blk[i].gen = 0;
+		jit->blk[i].cnt = 0;
+		jit->blk[i].code = NULL;
+	}
+
+	jit->mem_used = 0;
+}
+
+static
+int e86_jit_translate (e8086_t *c, e86_jit_blk_t *blk)
+{
+	unsigned      n, op, pre, len;
+	unsigned short ip;
+	unsigned long addr, clk;
+	unsigned long *pg;
+	unsigned char *p, *start;
+	int           last;
+	struct e86_jit_t *jit;
+
+	jit = c->jit;
+
+	addr = blk->addr;
+	ip = blk->ip;
+
+	if ((E86_JIT_MEM_SIZE - jit->mem_used) < E86_JIT_CODE_MAX) {
+		e86_jit_clear (jit);
+
+		blk->addr = addr;
+		blk->ip = ip;
+	}
+
+	pg = &c->ic_pgen[addr / E86_IC_PAGE_SIZE];
+	*pg |= 1;
+
+	start = jit->mem + jit->mem_used;
+	p = start;
+
+	/* push rbx; mov rbx, rdi; sub rsp, 16 */
+	e86_jit_emit8 (&p, 0x53);
+	e86_jit_emit8 (&p, 0x48);
+	e86_jit_emit8 (&p, 0x89);
+	e86_jit_emit8 (&p, 0xfb);
+	e86_jit_emit8 (&p, 0x48);
+	e86_jit_emit8 (&p, 0x83);
+	e86_jit_emit8 (&p, 0xec);
+	e86_jit_emit8 (&p, 0x10);
+
+	n = 0;
+	clk = 0;
+	last = 0;
+
+	while ((n < E86_JIT_INSN_MAX) && (last == 0)) {
+		if (ip > (0xffff - E86_JIT_FETCH - 1)) {
+			break;
+		}
+
+		if ((addr + E86_JIT_FETCH + 1) > c->ram_cnt) {
+			break;
+		}
+
+		if (((addr + E86_JIT_FETCH) ^ addr) & ~(E86_IC_PAGE_SIZE - 1)) {
+			break;
+		}
+
+		op = c->ram[addr];
+		pre = e86_jit_is_prefix (op) ? 1 : 0;
+		op = c->ram[addr + pre];
+
+		if (e86_jit_is_excluded (op)) {
+			break;
+		}
+
+		if (pre == 0) {
+			len = e86_jit_emit_native (&p, c->ram + addr, &clk);
+
+			if (len > 0) {
+				n += 1;
+				ip += len;
+				addr += len;
+
+				e86_jit_emit_clk (&p, &clk);
+				e86_jit_emit_check_clk (&p, ip, n);
+
+				continue;
+			}
+		}
+
+		len = e86_jit_get_len (c, addr + pre, ip + pre);
+		last = e86_jit_is_last (op, c->ram[addr + pre + 1]);
+
+		e86_jit_emit_clk (&p, &clk);
+		e86_jit_emit_save_delay (&p);
+
+		e86_jit_emit_set16 (&p, E86_JIT_OFS (ip), ip);
+		e86_jit_emit_set16 (&p, E86_JIT_OFS (cur_ip), ip);
+
+		/* mov dword [rbx + prefix], 0 */
+		e86_jit_emit8 (&p, 0xc7);
+		e86_jit_emit_rbx (&p, 0, E86_JIT_OFS (prefix));
+		e86_jit_emit32 (&p, 0);
+
+		if (pre) {
+			e86_jit_emit_call (&p, c->ram + addr, c->op[c->ram[addr]]);
+
+			/* and dword [rbx + prefix], ~E86_PREFIX_NEW */
+			e86_jit_emit8 (&p, 0x81);
+			e86_jit_emit_rbx (&p, 0x20, E86_JIT_OFS (prefix));
+			e86_jit_emit32 (&p, ~(unsigned long) E86_PREFIX_NEW);
+
+			e86_jit_emit_set16 (&p, E86_JIT_OFS (ip), ip + 1);
+		}
+
+		e86_jit_emit_call (&p, c->ram + addr + pre, c->op[op]);
+		e86_jit_emit_restore_delay (&p);
+
+		n += 1;
+
+		e86_jit_emit_check_len (&p, len, n, last);
+
+		ip += pre + len;
+		addr += pre + len;
+
+		if (last == 0) {
+			e86_jit_emit_check_gen (&p, pg, *pg, ip, n);
+			e86_jit_emit_check_clk (&p, ip, n);
+		}
+	}
+
+	if (n == 0) {
+		return (1);
+	}
+
+	if (last == 0) {
+		e86_jit_emit_clk (&p, &clk);
+		e86_jit_emit_set16 (&p, E86_JIT_OFS (ip), ip);
+		e86_jit_emit_ret (&p, n);
+	}
+
+	jit->mem_used += p - start;
+	jit->mem_used = (jit->mem_used + 15) & ~15UL;
+
+	blk->gen = *pg;
+	blk->code = (e86_jit_code_f) start;
+
+	return (0);
+}
+
+/*
+ * The code memory is never writable and executable at the same time. It
+ * is made writable while a block is translated and executable again
+ * afterwards. Returns non-zero if the protection can't be changed.
+ */
+static
+int e86_jit_set_write (struct e86_jit_t *jit, int write)
+{
+	int prot;
+
+	prot = write ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC);
+
+	if (mprotect (jit->mem, E86_JIT_MEM_SIZE, prot)) {
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Translate a block with the code memory writable. Returns non-zero if
+ * the block can't be translated or the code memory can't be made
+ * executable again, in which case all blocks are discarded.
+ */
+static
+int e86_jit_translate_blk (e8086_t *c, e86_jit_blk_t *blk)
+{
+	int r;
+
+	if (e86_jit_set_write (c->jit, 1)) {
+		return (1);
+	}
+
+	r = e86_jit_translate (c, blk);
+
+	if (e86_jit_set_write (c->jit, 0)) {
+		e86_jit_clear (c->jit);
+		return (1);
+	}
+
+	return (r);
+}
+
+int e86_set_jit (e8086_t *c, int enable)
+{
+	struct e86_jit_t *jit;
+
+	if (enable == 0) {
+		if (c->jit != NULL) {
+			munmap (c->jit->mem, E86_JIT_MEM_SIZE);
+			free (c->jit);
+			c->jit = NULL;
+		}
+
+		return (0);
+	}
+
+	if (c->jit != NULL) {
+		return (0);
+	}
+
+	if (c->ic == NULL) {
+		if (e86_set_icache (c, 1)) {
+			return (1);
+		}
+	}
+
+	jit = malloc (sizeof (struct e86_jit_t));
+
+	if (jit == NULL) {
+		return (1);
+	}
+
+	jit->mem = mmap (NULL, E86_JIT_MEM_SIZE,
+		PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS,
+		-1, 0
+	);
+
+	if (jit->mem == MAP_FAILED) {
+		free (jit);
+		return (1);
+	}
+
+	e86_jit_clear (jit);
+
+	c->jit = jit;
+
+	return (0);
+}
+
+void e86_jit_flush (e8086_t *c)
+{
+	if (c->jit != NULL) {
+		e86_jit_clear (c->jit);
+	}
+}
+
+unsigned e86_jit_exec (e8086_t *c)
+{
+	unsigned short ip;
+	unsigned long  addr, idx;
+	e86_jit_blk_t  *blk;
+
+	if (c->jit_disable || (c->op_stat != NULL)) {
+		return (0);
+	}
+
+	if ((c->prefix & E86_PREFIX_KEEP) || (c->flg & E86_FLG_T)) {
+		return (0);
+	}
+
+	ip = e86_get_ip (c);
+	addr = e86_get_linear (e86_get_cs (c), ip) & c->addr_mask;
+
+	if ((addr >= c->ram_cnt) || (c->ic_pgen == NULL)) {
+		return (0);
+	}
+
+	idx = (addr ^ (addr >> E86_JIT_BLK_BITS) ^ ((unsigned long) ip << 3));
+	blk = &c->jit->blk[idx & (E86_JIT_BLK_CNT - 1)];
+
+	if ((blk->addr != addr) || (blk->ip != ip)) {
+		blk->addr = addr;
+		blk->ip = ip;
+		blk->cnt = 0;
+		blk->code = NULL;
+	}
+	else if (blk->code != NULL) {
+		if (blk->gen != c->ic_pgen[addr / E86_IC_PAGE_SIZE]) {
+			blk->cnt = 0;
+			blk->code = NULL;
+		}
+	}
+
+	if (blk->code == NULL) {
+		blk->cnt += 1;
+
+		if (blk->cnt < E86_JIT_HOT) {
+			return (0);
+		}
+
+		blk->cnt = 0;
+
+		if (e86_jit_translate_blk (c, blk)) {
+			return (0);
+		}
+	}
+
+	c->prefix = 0;
+	c->enable_int = 1;
+
+	return (blk->code (c));
+}
+
+#else
+
+int e86_set_jit (e8086_t *c, int enable)
+{
+	return (enable != 0);
+}
+
+void e86_jit_flush (e8086_t *c)
+{
+}
+
+unsigned e86_jit_exec (e8086_t *c)
+{
+	return (0);
+}
+
+#endif
@@ -23,7 +23,27 @@
 #include "e8086.h"
 #include "internal.h"
 
+#include <string.h>
 
+
+/*
+ * This file is compiled twice. With E86_BUS8 defined as 1 it provides
+ * e86_opcodes_8bit, the opcode handlers for CPUs with an 8 bit data
+ * bus. The bus width is a constant in the 16 bit operand accesses.
+ */
+#ifndef E86_BUS8
+#define E86_BUS8 0
+#endif
+
+#if E86_BUS8
+#define e86_opcodes e86_opcodes_8bit
+#endif
+
+#define e86_get_ea16(c) e86_get_ea16_tmpl ((c), E86_BUS8)
+#define e86_set_ea16(c, val) e86_set_ea16_tmpl ((c), E86_BUS8, (val))
+
+
+#if E86_BUS8 == 0
 void e86_push (e8086_t *c, unsigned short val)
 {
 	e86_set_sp (c, e86_get_sp (c) - 2);
@@ -41,6 +61,7 @@ unsigned short e86_pop (e8086_t *c)
 
 	return (e86_get_mem16 (c, e86_get_ss (c), sp));
 }
+#endif
 
 
 /**************************************************************************
@@ -1125,10 +1146,10 @@ unsigned op_37 (e8086_t *c)
 	if (((al & 0x0f) > 9) || e86_get_af (c)) {
 		al += 6;
 		ah += 1;
-		c->flg |= (E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 1);
 	}
 	else {
-		c->flg &= ~(E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 0);
 	}
 
 	e86_set_ax (c, ((ah & 0xff) << 8) | (al & 0x0f));
@@ -1258,10 +1279,10 @@ unsigned op_3f (e8086_t *c)
 	if (((al & 0x0f) > 9) || e86_get_af (c)) {
 		al -= 6;
 		ah -= 1;
-		c->flg |= (E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 1);
 	}
 	else {
-		c->flg &= ~(E86_FLG_A | E86_FLG_C);
+		e86_set_f (c, E86_FLG_A | E86_FLG_C, 0);
 	}
 
 	e86_set_ax (c, ((ah & 0xff) << 8) | (al & 0x0f));
@@ -1276,16 +1297,13 @@ static
 unsigned op_40 (e8086_t *c)
 {
 	unsigned       r;
-	unsigned short cf;
 	unsigned long  s;
 
 	r = c->pq[0] & 7;
 	s = c->dreg[r];
 	c->dreg[r] = (s + 1) & 0xffff;
 
-	cf = c->flg;
-	e86_set_flg_add_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_inc_16 (c, s);
 
 	e86_set_clk (c, 3);
 
@@ -1297,16 +1315,13 @@ static
 unsigned op_48 (e8086_t *c)
 {
 	unsigned       r;
-	unsigned short cf;
 	unsigned long  s;
 
 	r = c->pq[0] & 7;
 	s = c->dreg[r];
 	c->dreg[r] = (s - 1) & 0xffff;
 
-	cf = c->flg;
-	e86_set_flg_sub_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_dec_16 (c, s);
 
 	e86_set_clk (c, 3);
 
@@ -2435,10 +2450,10 @@ static
 unsigned op_9c (e8086_t *c)
 {
 	if (c->cpu & E86_CPU_FLAGS286) {
-		e86_push (c, c->flg & 0x0fd5);
+		e86_push (c, e86_get_flags (c) & 0x0fd5);
 	}
 	else {
-		e86_push (c, (c->flg & 0x0fd5) | 0xf002);
+		e86_push (c, (e86_get_flags (c) & 0x0fd5) | 0xf002);
 	}
 
 	e86_set_clk (c, 10);
@@ -2450,7 +2465,7 @@ unsigned op_9c (e8086_t *c)
 static
 unsigned op_9d (e8086_t *c)
 {
-	c->flg = (e86_pop (c) & 0x0fd5) | 0xf002;
+	e86_set_flags (c, (e86_pop (c) & 0x0fd5) | 0xf002);
 	e86_set_clk (c, 8);
 
 	return (1);
@@ -2460,9 +2475,9 @@ unsigned op_9d (e8086_t *c)
 static
 unsigned op_9e (e8086_t *c)
 {
-	c->flg &= 0xff00;
-	c->flg |= e86_get_ah (c) & 0xd5;
-	c->flg |= 0x02;
+	e86_set_flags (c,
+		(e86_get_flags (c) & 0xff00) | (e86_get_ah (c) & 0xd5) | 0x02
+	);
 
 	e86_set_clk (c, 4);
 
@@ -2473,7 +2488,7 @@ unsigned op_9e (e8086_t *c)
 static
 unsigned op_9f (e8086_t *c)
 {
-	e86_set_ah (c, (c->flg & 0xd5) | 0x02);
+	e86_set_ah (c, (e86_get_flags (c) & 0xd5) | 0x02);
 	e86_set_clk (c, 4);
 
 	return (1);
@@ -2541,6 +2556,449 @@ unsigned op_a3 (e8086_t *c)
 	return (3);
 }
 
+/**************************************************************************
+ * Repeated string instructions
+ *
+ * If all elements of a repeated string instruction are in RAM, as many
+ * elements as the clock budget of the current e86_clock() call allows
+ * are processed in one step. The timing is the same as if the elements
+ * were executed one by one. The e86_rep_*() functions return 0 if they
+ * did nothing, otherwise they account for all processed elements except
+ * the last one, which is accounted for by the caller. They process at
+ * least two elements, except for CMPS and SCAS, which stop after one
+ * element if the terminating condition holds for the first element.
+ **************************************************************************/
+
+/*
+ * Get the number of elements that can be processed in one step
+ */
+static
+unsigned e86_rep_get_cnt (e8086_t *c, unsigned clk)
+{
+	unsigned long cnt;
+
+	if ((c->op_stat != NULL) || e86_get_tf (c)) {
+		return (1);
+	}
+
+	if (c->irq && e86_get_if (c)) {
+		return (1);
+	}
+
+	if (c->clk_rem < c->delay) {
+		return (1);
+	}
+
+	cnt = (c->clk_rem - c->delay) / (clk + 10) + 1;
+
+	if (cnt > e86_get_cx (c)) {
+		cnt = e86_get_cx (c);
+	}
+
+	return (cnt);
+}
+
+/*
+ * Limit cnt such that the elements don't wrap around the segment end
+ */
+static
+unsigned e86_rep_clip (e8086_t *c, unsigned short ofs, unsigned cnt, unsigned size)
+{
+	unsigned max;
+
+	if (e86_get_df (c)) {
+		if ((ofs + size) > 0x10000) {
+			return (0);
+		}
+
+		max = ofs / size + 1;
+	}
+	else {
+		max = (0x10000 - ofs) / size;
+	}
+
+	return ((cnt < max) ? cnt : max);
+}
+
+/*
+ * Get a pointer to the lowest addressed element or NULL if not all
+ * elements are in RAM
+ */
+static
+unsigned char *e86_rep_get_ram (e8086_t *c, unsigned short seg, unsigned short ofs,
+	unsigned cnt, unsigned size)
+{
+	unsigned long addr, last;
+
+	if (e86_get_df (c)) {
+		ofs -= (cnt - 1) * size;
+	}
+
+	addr = e86_get_linear (seg, ofs);
+	last = addr + cnt * size - 1;
+
+	if ((addr & c->addr_mask) != addr) {
+		return (NULL);
+	}
+
+	if ((last >= c->ram_cnt) || ((last & c->addr_mask) != last)) {
+		return (NULL);
+	}
+
+	return (c->ram + addr);
+}
+
+/*
+ * Check if writing n bytes at dst overwrites the string instruction
+ * while it is not in the prefetch queue
+ */
+static
+int e86_rep_hits_code (e8086_t *c, const unsigned char *dst, unsigned long n)
+{
+	unsigned long addr;
+
+	if (c->pq_cnt > 0) {
+		return (0);
+	}
+
+	addr = e86_get_linear (e86_get_cs (c), e86_get_ip (c)) & c->addr_mask;
+
+	if ((addr < (unsigned long) (dst - c->ram)) || (addr >= (unsigned long) (dst - c->ram) + n)) {
+		return (0);
+	}
+
+	return (1);
+}
+
+static
+void e86_rep_finish (e8086_t *c, unsigned cnt, unsigned clk)
+{
+	e86_set_cx (c, e86_get_cx (c) - cnt);
+
+	e86_set_clk (c, (unsigned long) (cnt - 1) * (clk + 10));
+
+	c->instructions += cnt - 1;
+}
+
+static
+int e86_rep_movs (e8086_t *c, unsigned short seg1, unsigned short seg2,
+	unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned long  n;
+	unsigned short si, di;
+	unsigned char  *src, *dst, *s, *d;
+	unsigned char  v0, v1;
+
+	si = e86_get_si (c);
+	di = e86_get_di (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+	cnt = e86_rep_clip (c, si, cnt, size);
+	cnt = e86_rep_clip (c, di, cnt, size);
+
+	if (cnt < 2) {
+		return (0);
+	}
+
+	src = e86_rep_get_ram (c, seg1, si, cnt, size);
+	dst = e86_rep_get_ram (c, seg2, di, cnt, size);
+
+	if ((src == NULL) || (dst == NULL)) {
+		return (0);
+	}
+
+	n = (unsigned long) cnt * size;
+
+	if (e86_rep_hits_code (c, dst, n)) {
+		return (0);
+	}
+
+	if ((dst + n <= src) || (src + n <= dst)) {
+		memcpy (dst, src, n);
+	}
+	else if (e86_get_df (c) ? (dst >= src) : (dst <= src)) {
+		memmove (dst, src, n);
+	}
+	else {
+		/* overlapping in the direction of the copy */
+		for (i = 0; i < cnt; i++) {
+			if (e86_get_df (c)) {
+				s = src + (cnt - i - 1) * size;
+				d = dst + (cnt - i - 1) * size;
+			}
+			else {
+				s = src + i * size;
+				d = dst + i * size;
+			}
+
+			if (size == 1) {
+				d[0] = s[0];
+			}
+			else {
+				v0 = s[0];
+				v1 = s[1];
+				d[0] = v0;
+				d[1] = v1;
+			}
+		}
+	}
+
+	e86_icache_invalidate (c, dst - c->ram, n);
+
+	if (e86_get_df (c)) {
+		n = -n;
+	}
+
+	e86_set_si (c, si + n);
+	e86_set_di (c, di + n);
+
+	e86_rep_finish (c, cnt, clk);
+
+	return (1);
+}
+
+static
+int e86_rep_stos (e8086_t *c, unsigned short seg, unsigned size, unsigned clk)
+{
+	unsigned       i, cnt;
+	unsigned long  n;
+	unsigned short di, val;
+	unsigned char  *dst;
+
+	di = e86_get_di (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+	cnt = e86_rep_clip (c, di, cnt, size);
+
+	if (cnt < 2) {
+		return (0);
+	}
+
+	dst = e86_rep_get_ram (c, seg, di, cnt, size);
+
+	if (dst == NULL) {
+		return (0);
+	}
+
+	n = (unsigned long) cnt * size;
+
+	if (e86_rep_hits_code (c, dst, n)) {
+		return (0);
+	}
+
+	val = e86_get_ax (c);
+
+	if ((size == 1) || (((val >> 8) & 0xff) == (val & 0xff))) {
+		memset (dst, val & 0xff, n);
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			dst[2 * i] = val & 0xff;
+			dst[2 * i + 1] = (val >> 8) & 0xff;
+		}
+	}
+
+	e86_icache_invalidate (c, dst - c->ram, n);
+
+	if (e86_get_df (c)) {
+		n = -n;
+	}
+
+	e86_set_di (c, di + n);
+
+	e86_rep_finish (c, cnt, clk);
+
+	return (1);
+}
+
+static
+int e86_rep_lods (e8086_t *c, unsigned short seg, unsigned size, unsigned clk)
+{
+	unsigned       cnt;
+	unsigned long  n;
+	unsigned short si;
+	unsigned char  *src;
+
+	si = e86_get_si (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+	cnt = e86_rep_clip (c, si, cnt, size);
+
+	if (cnt < 2) {
+		return (0);
+	}
+
+	src = e86_rep_get_ram (c, seg, si, cnt, size);
+
+	if (src == NULL) {
+		return (0);
+	}
+
+	n = (unsigned long) cnt * size;
+
+	if (e86_get_df (c) == 0) {
+		src += n - size;
+	}
+
+	if (size == 1) {
+		e86_set_al (c, src[0]);
+	}
+	else {
+		e86_set_ax (c, e86_mk_uint16 (src[0], src[1]));
+	}
+
+	if (e86_get_df (c)) {
+		n = -n;
+	}
+
+	e86_set_si (c, si + n);
+
+	e86_rep_finish (c, cnt, clk);
+
+	return (1);
+}
+
+/*
+ * CMPS and SCAS. If src is NULL, the elements are compared to AL / AX.
+ */
+static
+int e86_rep_cmp (e8086_t *c, unsigned char *src, unsigned char *dst,
+	unsigned cnt, unsigned size, unsigned clk)
+{
+	unsigned       i, j;
+	unsigned short s1, s2;
+	unsigned char  *p;
+	int            z;
+
+	z = (c->prefix & E86_PREFIX_REP) ? 1 : 0;
+
+	s1 = e86_get_ax (c);
+	s2 = 0;
+
+	if ((src == NULL) && (size == 1) && (z == 0) && (e86_get_df (c) == 0)) {
+		p = memchr (dst, s1 & 0xff, cnt);
+
+		i = (p == NULL) ? cnt : (p - dst + 1);
+		s1 &= 0xff;
+		s2 = dst[i - 1];
+	}
+	else {
+		for (i = 0; i < cnt; i++) {
+			j = e86_get_df (c) ? (cnt - i - 1) : i;
+
+			if (size == 1) {
+				if (src != NULL) {
+					s1 = src[j];
+				}
+				else {
+					s1 &= 0xff;
+				}
+
+				s2 = dst[j];
+			}
+			else {
+				j *= 2;
+
+				if (src != NULL) {
+					s1 = e86_mk_uint16 (src[j], src[j + 1]);
+				}
+
+				s2 = e86_mk_uint16 (dst[j], dst[j + 1]);
+			}
+
+			if ((s1 == s2) != z) {
+				i += 1;
+				break;
+			}
+		}
+	}
+
+	if (size == 1) {
+		e86_set_flg_sub_8 (c, s1, s2);
+	}
+	else {
+		e86_set_flg_sub_16 (c, s1, s2);
+	}
+
+	e86_rep_finish (c, i, clk);
+
+	return (i);
+}
+
+static
+int e86_rep_cmps (e8086_t *c, unsigned short seg1, unsigned short seg2,
+	unsigned size, unsigned clk)
+{
+	unsigned       cnt;
+	unsigned long  n;
+	unsigned short si, di;
+	unsigned char  *src, *dst;
+
+	si = e86_get_si (c);
+	di = e86_get_di (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+	cnt = e86_rep_clip (c, si, cnt, size);
+	cnt = e86_rep_clip (c, di, cnt, size);
+
+	if (cnt < 2) {
+		return (0);
+	}
+
+	src = e86_rep_get_ram (c, seg1, si, cnt, size);
+	dst = e86_rep_get_ram (c, seg2, di, cnt, size);
+
+	if ((src == NULL) || (dst == NULL)) {
+		return (0);
+	}
+
+	n = (unsigned long) e86_rep_cmp (c, src, dst, cnt, size, clk) * size;
+
+	if (e86_get_df (c)) {
+		n = -n;
+	}
+
+	e86_set_si (c, si + n);
+	e86_set_di (c, di + n);
+
+	return (1);
+}
+
+static
+int e86_rep_scas (e8086_t *c, unsigned short seg, unsigned size, unsigned clk)
+{
+	unsigned       cnt;
+	unsigned long  n;
+	unsigned short di;
+	unsigned char  *dst;
+
+	di = e86_get_di (c);
+
+	cnt = e86_rep_get_cnt (c, clk);
+	cnt = e86_rep_clip (c, di, cnt, size);
+
+	if (cnt < 2) {
+		return (0);
+	}
+
+	dst = e86_rep_get_ram (c, seg, di, cnt, size);
+
+	if (dst == NULL) {
+		return (0);
+	}
+
+	n = (unsigned long) e86_rep_cmp (c, NULL, dst, cnt, size, clk) * size;
+
+	if (e86_get_df (c)) {
+		n = -n;
+	}
+
+	e86_set_di (c, di + n);
+
+	return (1);
+}
+
 /* OP A4: MOVSB */
 static
 unsigned op_a4 (e8086_t *c)
@@ -2555,12 +3013,14 @@ unsigned op_a4 (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			val = e86_get_mem8 (c, seg1, e86_get_si (c));
-			e86_set_mem8 (c, seg2, e86_get_di (c), val);
-
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+			if (e86_rep_movs (c, seg1, seg2, 1, 18) == 0) {
+				val = e86_get_mem8 (c, seg1, e86_get_si (c));
+				e86_set_mem8 (c, seg2, e86_get_di (c), val);
+
+				e86_set_si (c, e86_get_si (c) + inc);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
+			}
 		}
 
 		e86_set_clk (c, 18);
@@ -2601,12 +3061,14 @@ unsigned op_a5 (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			val = e86_get_mem16 (c, seg1, e86_get_si (c));
-			e86_set_mem16 (c, seg2, e86_get_di (c), val);
-
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+			if (e86_rep_movs (c, seg1, seg2, 2, 18) == 0) {
+				val = e86_get_mem16 (c, seg1, e86_get_si (c));
+				e86_set_mem16 (c, seg2, e86_get_di (c), val);
+
+				e86_set_si (c, e86_get_si (c) + inc);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
+			}
 		}
 
 		e86_set_clk (c, 18);
@@ -2649,14 +3111,16 @@ unsigned op_a6 (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_mem8 (c, seg1, e86_get_si (c));
-			s2 = e86_get_mem8 (c, seg2, e86_get_di (c));
+			if (e86_rep_cmps (c, seg1, seg2, 1, 22) == 0) {
+				s1 = e86_get_mem8 (c, seg1, e86_get_si (c));
+				s2 = e86_get_mem8 (c, seg2, e86_get_di (c));
 
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+				e86_set_si (c, e86_get_si (c) + inc);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
 
-			e86_set_flg_sub_8 (c, s1, s2);
+				e86_set_flg_sub_8 (c, s1, s2);
+			}
 		}
 
 		e86_set_clk (c, 22);
@@ -2703,14 +3167,16 @@ unsigned op_a7 (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_mem16 (c, seg1, e86_get_si (c));
-			s2 = e86_get_mem16 (c, seg2, e86_get_di (c));
+			if (e86_rep_cmps (c, seg1, seg2, 2, 22) == 0) {
+				s1 = e86_get_mem16 (c, seg1, e86_get_si (c));
+				s2 = e86_get_mem16 (c, seg2, e86_get_di (c));
 
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+				e86_set_si (c, e86_get_si (c) + inc);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
 
-			e86_set_flg_sub_16 (c, s1, s2);
+				e86_set_flg_sub_16 (c, s1, s2);
+			}
 		}
 
 		e86_set_clk (c, 22);
@@ -2783,10 +3249,12 @@ unsigned op_aa (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			e86_set_mem8 (c, seg, e86_get_di (c), e86_get_al (c));
+			if (e86_rep_stos (c, seg, 1, 11) == 0) {
+				e86_set_mem8 (c, seg, e86_get_di (c), e86_get_al (c));
 
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
+			}
 		}
 
 		e86_set_clk (c, 11);
@@ -2822,10 +3290,12 @@ unsigned op_ab (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			e86_set_mem16 (c, seg, e86_get_di (c), e86_get_ax (c));
+			if (e86_rep_stos (c, seg, 2, 11) == 0) {
+				e86_set_mem16 (c, seg, e86_get_di (c), e86_get_ax (c));
 
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
+			}
 		}
 
 		e86_set_clk (c, 11);
@@ -2861,9 +3331,11 @@ unsigned op_ac (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			e86_set_al (c, e86_get_mem8 (c, seg, e86_get_si (c)));
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+			if (e86_rep_lods (c, seg, 1, 12) == 0) {
+				e86_set_al (c, e86_get_mem8 (c, seg, e86_get_si (c)));
+				e86_set_si (c, e86_get_si (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
+			}
 		}
 
 		e86_set_clk (c, 12);
@@ -2898,9 +3370,11 @@ unsigned op_ad (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			e86_set_ax (c, e86_get_mem16 (c, seg, e86_get_si (c)));
-			e86_set_si (c, e86_get_si (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+			if (e86_rep_lods (c, seg, 2, 12) == 0) {
+				e86_set_ax (c, e86_get_mem16 (c, seg, e86_get_si (c)));
+				e86_set_si (c, e86_get_si (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
+			}
 		}
 
 		e86_set_clk (c, 12);
@@ -2937,13 +3411,15 @@ unsigned op_ae (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_al (c);
-			s2 = e86_get_mem8 (c, seg, e86_get_di (c));
+			if (e86_rep_scas (c, seg, 1, 15) == 0) {
+				s1 = e86_get_al (c);
+				s2 = e86_get_mem8 (c, seg, e86_get_di (c));
 
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
 
-			e86_set_flg_sub_8 (c, s1, s2);
+				e86_set_flg_sub_8 (c, s1, s2);
+			}
 		}
 
 		e86_set_clk (c, 15);
@@ -2986,13 +3462,15 @@ unsigned op_af (e8086_t *c)
 
 	if (c->prefix & (E86_PREFIX_REP | E86_PREFIX_REPN)) {
 		if (e86_get_cx (c) != 0) {
-			s1 = e86_get_ax (c);
-			s2 = e86_get_mem16 (c, seg, e86_get_di (c));
+			if (e86_rep_scas (c, seg, 2, 15) == 0) {
+				s1 = e86_get_ax (c);
+				s2 = e86_get_mem16 (c, seg, e86_get_di (c));
 
-			e86_set_di (c, e86_get_di (c) + inc);
-			e86_set_cx (c, e86_get_cx (c) - 1);
+				e86_set_di (c, e86_get_di (c) + inc);
+				e86_set_cx (c, e86_get_cx (c) - 1);
 
-			e86_set_flg_sub_16 (c, s1, s2);
+				e86_set_flg_sub_16 (c, s1, s2);
+			}
 		}
 
 		e86_set_clk (c, 15);
@@ -3347,7 +3825,7 @@ unsigned op_cf (e8086_t *c)
 {
 	e86_set_ip (c, e86_pop (c));
 	e86_set_cs (c, e86_pop (c));
-	c->flg = e86_pop (c);
+	e86_set_flags (c, e86_pop (c));
 
 	e86_pq_init (c);
 
@@ -3967,7 +4445,7 @@ unsigned op_f4 (e8086_t *c)
 static
 unsigned op_f5 (e8086_t *c)
 {
-	c->flg ^= E86_FLG_C;
+	e86_set_cf (c, !e86_get_cf (c));
 	e86_set_clk (c, 2);
 
 	return (1);
@@ -4430,7 +4908,6 @@ unsigned op_fe (e8086_t *c)
 {
 	unsigned       xop;
 	unsigned short d, s;
-	unsigned short cf;
 
 	xop = (c->pq[1] >> 3) & 7;
 
@@ -4443,9 +4920,7 @@ unsigned op_fe (e8086_t *c)
 
 			e86_set_ea8 (c, d);
 
-			cf = c->flg;
-			e86_set_flg_add_8 (c, s, 1);
-			c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+			e86_set_flg_inc_8 (c, s);
 
 			e86_set_clk_ea (c, 3, 15);
 
@@ -4459,9 +4934,7 @@ unsigned op_fe (e8086_t *c)
 
 			e86_set_ea8 (c, d);
 
-			cf = c->flg;
-			e86_set_flg_sub_8 (c, s, 1);
-			c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+			e86_set_flg_dec_8 (c, s);
 
 			e86_set_clk_ea (c, 3, 15);
 
@@ -4479,7 +4952,6 @@ static
 unsigned op_ff_00 (e8086_t *c)
 {
 	unsigned long  s, d;
-	unsigned short cf;
 
 	e86_get_ea_ptr (c, c->pq + 1);
 
@@ -4488,9 +4960,7 @@ unsigned op_ff_00 (e8086_t *c)
 
 	e86_set_ea16 (c, d);
 
-	cf = c->flg;
-	e86_set_flg_add_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_inc_16 (c, s);
 
 	e86_set_clk_ea (c, 3, 15);
 
@@ -4502,7 +4972,6 @@ static
 unsigned op_ff_01 (e8086_t *c)
 {
 	unsigned long  s, d;
-	unsigned short cf;
 
 	e86_get_ea_ptr (c, c->pq + 1);
 
@@ -4511,9 +4980,7 @@ unsigned op_ff_01 (e8086_t *c)
 
 	e86_set_ea16 (c, d);
 
-	cf = c->flg;
-	e86_set_flg_sub_16 (c, s, 1);
-	c->flg ^= (c->flg ^ cf) & E86_FLG_C;
+	e86_set_flg_dec_16 (c, s);
 
 	e86_set_clk_ea (c, 3, 15);
 
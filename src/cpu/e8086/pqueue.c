@@ -48,72 +48,5 @@ void e86_pq_init (e8086_t *c)
  */
 void e86_pq_fill (e8086_t *c)
 {
-	unsigned       i;
-	unsigned short val;
-	unsigned short seg, ofs;
-	unsigned       cnt;
-	unsigned long  addr;
-
-	seg = e86_get_cs (c);
-	ofs = e86_get_ip (c);
-
-	cnt = c->pq_fill;
-
-	if (ofs <= (0xffff - cnt)) {
-		/* all within one segment */
-
-		addr = e86_get_linear (seg, ofs) & c->addr_mask;
-
-		if ((addr + cnt) <= c->ram_cnt) {
-			for (i = c->pq_cnt; i < cnt; i++) {
-				c->pq[i] = c->ram[addr + i];
-			}
-		}
-		else {
-			i = c->pq_cnt;
-			while (i < cnt) {
-				val = c->mem_get_uint16 (c->mem, (addr + i) & c->addr_mask);
-				c->pq[i] = val & 0xff;
-				c->pq[i + 1] = (val >> 8) & 0xff;
-				i += 2;
-			}
-		}
-	}
-	else {
-		i = c->pq_cnt;
-		while (i < cnt) {
-			val = e86_get_mem16 (c, seg, ofs + i);
-			c->pq[i] = val & 0xff;
-			c->pq[i + 1] = (val >> 8) & 0xff;
-
-			i += 2;
-		}
-	}
-
-	c->pq_cnt = c->pq_size;
-}
-
-/*
- * Remove cnt bytes from the prefetch queue and copy the rest to the front
- */
-void e86_pq_adjust (e8086_t *c, unsigned cnt)
-{
-	unsigned      n;
-	unsigned char *d, *s;
-
-	if (cnt >= c->pq_cnt) {
-		c->pq_cnt = 0;
-		return;
-	}
-
-	n = c->pq_cnt - cnt;
-	s = c->pq + cnt;
-	d = c->pq;
-
-	while (n > 0) {
-		*(d++) = *(s++);
-		n -= 1;
-	}
-
-	c->pq_cnt -= cnt;
+	e86_pq_fill_n (c, c->pq_size, c->pq_fill);
 }
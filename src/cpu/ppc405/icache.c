@@ -0,0 +1,293 @@
+/*****************************************************************************
+ * pce                                                                       *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * File name:   src/cpu/ppc405/icache.c                                      *
+ * Created:     2026-10-18 by the pce authors                                *
+ * Copyright:   (C) 2026 the pce authors                                     *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This program is free software. You can redistribute it and / or modify it *
+ * under the terms of the GNU General Public License version 2 as  published *
+ * by the Free Software Foundation.                                          *
+ *                                                                           *
+ * This program is distributed in the hope  that  it  will  be  useful,  but *
+ * WITHOUT  ANY   WARRANTY,   without   even   the   implied   warranty   of *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU  General *
+ * Public License for more details.                                          *
+ *****************************************************************************/
+
+
+#include <stdlib.h>
+
+#include "ppc405.h"
+#include "internal.h"
+
+
+/*
+ * The instruction cache holds instructions in ram together with their
+ * final opcode handler, indexed by real address.
+ *
+ * p405_icache_fetch_page() translates the virtual PC, checks the execute
+ * permission and remembers the virtual page in ic_vpage, together with
+ * its real page and the msr and pid it was translated with. As long as
+ * the PC stays in that page and msr and pid are unchanged,
+ * p405_icache_fetch() adds the remembered offset to the PC and does not
+ * translate it again. ic_vpage is cleared if a TLB entry is written, if
+ * the translation buffers are cleared (tlbia and writes to the zpr) and
+ * if the cache is flushed. A change of msr or pid makes the comparison
+ * in p405_icache_fetch() fail.
+ *
+ * The cache entries themselves do not depend on the translation. They
+ * are tagged with the real address and the endian bit of the page, so
+ * they stay valid across these events. Only the path from the virtual
+ * PC to the entry is translated again.
+ *
+ * Each ram page has a generation number. The lowest bit of the generation
+ * number is set if there are cached instructions in the page. A store to
+ * such a page increments the generation number, which invalidates all
+ * entries in that page. icbi invalidates the page of its address.
+ */
+
+
+/* an entry address that never matches, bit 1 is never set otherwise */
+#define P405_IC_INVALID 0x02
+
+
+static
+void p405_icache_clear (p405_t *c)
+{
+	unsigned long i;
+
+	c->ic_vpage = 0;
+
+	if (c->ic != NULL) {
+		for (i = 0; i < P405_IC_CNT; i++) {
+			c->ic[i].addr = P405_IC_INVALID;
+			c->ic[i].gen = 0;
+		}
+	}
+
+	if (c->ic_pgen != NULL) {
+		for (i = 0; i < c->ic_pcnt; i++) {
+			c->ic_pgen[i] = 0;
+		}
+	}
+}
+
+void p405_icache_init (p405_t *c)
+{
+	c->ic = NULL;
+	c->ic_pgen = NULL;
+	c->ic_pcnt = 0;
+
+	c->ic_tmp.addr = P405_IC_INVALID;
+	c->ic_tmp.ir = 0;
+	c->ic_tmp.gen = 0;
+	c->ic_tmp.op = &p405_op_undefined;
+
+	c->ic_vpage = 0;
+	c->ic_radd = 0;
+	c->ic_msr = 0;
+	c->ic_pid = 0;
+	c->ic_e = 0;
+	c->ic_pg = NULL;
+}
+
+void p405_icache_free (p405_t *c)
+{
+	free (c->ic);
+	free (c->ic_pgen);
+
+	c->ic = NULL;
+	c->ic_pgen = NULL;
+	c->ic_pcnt = 0;
+
+	c->ic_vpage = 0;
+}
+
+void p405_icache_set_ram (p405_t *c)
+{
+	unsigned long cnt;
+	unsigned long *pgen;
+
+	cnt = (c->ram_cnt + (1UL << P405_IC_PAGE_BITS) - 1) >> P405_IC_PAGE_BITS;
+
+	if (cnt == 0) {
+		p405_icache_free (c);
+		return;
+	}
+
+	if (c->ic == NULL) {
+		c->ic = malloc (P405_IC_CNT * sizeof (p405_icache_ent_t));
+
+		if (c->ic == NULL) {
+			p405_icache_free (c);
+			return;
+		}
+	}
+
+	pgen = realloc (c->ic_pgen, cnt * sizeof (unsigned long));
+
+	if (pgen == NULL) {
+		p405_icache_free (c);
+		return;
+	}
+
+	c->ic_pgen = pgen;
+	c->ic_pcnt = cnt;
+
+	p405_icache_clear (c);
+}
+
+void p405_icache_invalidate (p405_t *c, unsigned long addr, unsigned long cnt)
+{
+	unsigned long i, n;
+
+	if ((c->ic_pgen == NULL) || (cnt == 0)) {
+		return;
+	}
+
+	addr &= 0xffffffff;
+
+	i = addr >> P405_IC_PAGE_BITS;
+	n = (addr + cnt - 1) >> P405_IC_PAGE_BITS;
+
+	while ((i <= n) && (i < c->ic_pcnt)) {
+		if (c->ic_pgen[i] & 1) {
+			c->ic_pgen[i] += 1;
+		}
+
+		i += 1;
+	}
+}
+
+void p405_icache_flush (p405_t *c)
+{
+	unsigned long i;
+
+	if (c->ic_pgen == NULL) {
+		return;
+	}
+
+	for (i = 0; i < c->ic_pcnt; i++) {
+		if (c->ic_pgen[i] & 1) {
+			c->ic_pgen[i] += 1;
+		}
+	}
+}
+
+/*
+ * Get the final opcode handler for ir, without going through the
+ * second level dispatch functions
+ */
+static
+p405_opcode_f p405_icache_decode (p405_t *c, uint32_t ir)
+{
+	switch ((ir >> 26) & 0x3f) {
+	case 0x13:
+		return (c->opcodes.op13[(ir >> 1) & 0x3ff]);
+
+	case 0x1f:
+		return (c->opcodes.op1f[(ir >> 1) & 0x3ff]);
+	}
+
+	return (c->opcodes.op[(ir >> 26) & 0x3f]);
+}
+
+/*
+ * Get the cache entry for the instruction at the real address addr
+ * in ram
+ */
+static
+p405_icache_ent_t *p405_icache_get (p405_t *c, uint32_t addr, int e)
+{
+	uint32_t          tag;
+	unsigned char     *mem;
+	unsigned long     *pg;
+	p405_icache_ent_t *ent;
+
+	tag = addr | (e != 0);
+
+	pg = &c->ic_pgen[addr >> P405_IC_PAGE_BITS];
+	ent = &c->ic[(addr >> 2) & (P405_IC_CNT - 1)];
+
+	if ((ent->addr == tag) && (ent->gen == *pg)) {
+		return (ent);
+	}
+
+	mem = &c->ram[addr];
+
+	if (e) {
+		ent->ir = (mem[3] << 24) | (mem[2] << 16) | (mem[1] << 8) | mem[0];
+	}
+	else {
+		ent->ir = (mem[0] << 24) | (mem[1] << 16) | (mem[2] << 8) | mem[3];
+	}
+
+	*pg |= 1;
+
+	ent->addr = tag;
+	ent->gen = *pg;
+	ent->op = p405_icache_decode (c, ent->ir);
+
+	return (ent);
+}
+
+/*
+ * Fetch the instruction at the PC, remembering the page that it is in
+ * for p405_icache_fetch(). Returns the cache entry or NULL if the fetch
+ * caused an exception.
+ */
+p405_icache_ent_t *p405_icache_fetch_page (p405_t *c)
+{
+	p405_icache_ent_t *ent;
+
+#ifndef P405_LOG_MEM
+	if (c->ic != NULL) {
+		int      e;
+		uint32_t addr, page;
+
+		addr = c->pc;
+
+		if (p405_translate_exec (c, &addr, &e)) {
+			return (NULL);
+		}
+
+		addr &= ~0x03UL;
+
+		if (addr < (c->ram_cnt & ~0x03UL)) {
+			page = addr & 0xfffff000;
+
+			c->ic_vpage = 0;
+
+			if (((unsigned long) page + 0x1000) <= c->ram_cnt) {
+				if (!p405_get_msr_ir (c) || p405_tbuf_check_exec (c, c->pc)) {
+					c->ic_vpage = (c->pc & 0xfffff000) | 1;
+					c->ic_radd = page - (c->pc & 0xfffff000);
+					c->ic_msr = c->msr;
+					c->ic_pid = c->pid;
+					c->ic_e = (e != 0);
+					c->ic_pg = &c->ic_pgen[page >> P405_IC_PAGE_BITS];
+				}
+			}
+
+			return (p405_icache_get (c, addr, e));
+		}
+	}
+#endif
+
+	/* not in ram, use the memory functions */
+
+	ent = &c->ic_tmp;
+
+	if (p405_ifetch (c, c->pc, &ent->ir)) {
+		return (NULL);
+	}
+
+	ent->op = p405_icache_decode (c, ent->ir);
+
+	return (ent);
+}
@@ -41,6 +41,9 @@
 void p405_tlb_init (p405_tlb_t *tlb);
 
 void p405_tbuf_clear (p405_t *c);
+int p405_tbuf_check_exec (p405_t *c, uint32_t ea);
+
+int p405_translate_exec (p405_t *c, uint32_t *ea, int *e);
 
 void p405_set_tlb_entry_hi (p405_t *c, unsigned idx, uint32_t tlbhi, uint8_t pid);
 void p405_set_tlb_entry_lo (p405_t *c, unsigned idx, uint32_t tlblo);
@@ -62,6 +65,57 @@ int p405_dstore16 (p405_t *c, uint32_t addr, uint16_t val);
 int p405_dstore32 (p405_t *c, uint32_t addr, uint32_t val);
 
 
+/*****************************************************************************
+ * instruction cache
+ *****************************************************************************/
+
+void p405_icache_init (p405_t *c);
+void p405_icache_free (p405_t *c);
+void p405_icache_set_ram (p405_t *c);
+
+p405_icache_ent_t *p405_icache_fetch_page (p405_t *c);
+
+/*
+ * Fetch the instruction at the PC. Returns the cache entry or NULL
+ * if the fetch caused an exception.
+ */
+static inline
+p405_icache_ent_t *p405_icache_fetch (p405_t *c)
+{
+	uint32_t          addr;
+	p405_icache_ent_t *ent;
+
+	if ((((c->pc & 0xfffff000) | 1) == c->ic_vpage) && (c->msr == c->ic_msr) && (c->pid == c->ic_pid)) {
+		addr = (c->pc + c->ic_radd) & 0xfffffffc;
+		ent = &c->ic[(addr >> 2) & (P405_IC_CNT - 1)];
+
+		if ((ent->addr == (addr | c->ic_e)) && (ent->gen == *c->ic_pg)) {
+			return (ent);
+		}
+	}
+
+	return (p405_icache_fetch_page (c));
+}
+
+/*
+ * Invalidate the instruction cache entries in the page that contains
+ * the ram address addr
+ */
+static inline
+void p405_icache_write (p405_t *c, uint32_t addr)
+{
+	unsigned long *pg;
+
+	if (c->ic_pgen != NULL) {
+		pg = &c->ic_pgen[addr >> P405_IC_PAGE_BITS];
+
+		if (*pg & 1) {
+			*pg += 1;
+		}
+	}
+}
+
+
 /*****************************************************************************
  * PPC
  *****************************************************************************/
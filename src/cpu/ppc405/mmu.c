@@ -33,6 +33,18 @@
 #include "internal.h"
 
 
+static
+void p405_tbuf_init (p405_tlb_t *tlb)
+{
+	unsigned i;
+
+	for (i = 0; i < P405_TBUF_SIZE; i++) {
+		tlb->tbuf_exec[i].tag = 0;
+		tlb->tbuf_read[i].tag = 0;
+		tlb->tbuf_write[i].tag = 0;
+	}
+}
+
 void p405_tlb_init (p405_tlb_t *tlb)
 {
 	unsigned i;
@@ -57,39 +69,121 @@ void p405_tlb_init (p405_tlb_t *tlb)
 
 	tlb->first = &tlb->entry[0];
 
-	tlb->tbuf_exec = NULL;
-	tlb->tbuf_read = NULL;
-	tlb->tbuf_write = NULL;
+	p405_tbuf_init (tlb);
 }
 
 void p405_tbuf_clear (p405_t *c)
 {
-	c->tlb.tbuf_exec = NULL;
-	c->tlb.tbuf_read = NULL;
-	c->tlb.tbuf_write = NULL;
+	p405_tbuf_init (&c->tlb);
+
+	c->ic_vpage = 0;
 }
 
-static inline
-int p405_tlb_match (p405_tlbe_t *ent, uint32_t ea, uint32_t pid)
+/*
+ * Invalidate the translation buffer entries that were made from TLB
+ * entry idx. Only the buffer entries that the virtual pages of the
+ * TLB entry map to need to be checked.
+ */
+static
+void p405_tbuf_invalidate (p405_t *c, unsigned idx)
 {
+	unsigned    i, j, cnt;
+	uint32_t    page;
+	p405_tlbe_t *ent;
+	p405_tlb_t  *tlb;
+
+	tlb = &c->tlb;
+	ent = &tlb->entry[idx];
+
+	c->ic_vpage = 0;
+
 	if ((ent->tlbhi & P405_TLBHI_V) == 0) {
-		return (0);
+		return;
 	}
 
-	if ((ea & ent->mask) != ent->vaddr) {
-		return (0);
+	if (p405_get_tlbe_size (ent) == 0) {
+		/* 1K pages are not buffered */
+		return;
 	}
 
-	if ((ent->tid != 0) && (ent->tid != pid)) {
-		return (0);
+	cnt = (~ent->mask >> 12) + 1;
+
+	if (cnt > P405_TBUF_SIZE) {
+		cnt = P405_TBUF_SIZE;
 	}
 
-	return (1);
+	page = ent->vaddr >> 12;
+
+	for (i = 0; i < cnt; i++) {
+		j = (page + i) & (P405_TBUF_SIZE - 1);
+
+		if (tlb->tbuf_exec[j].idx == idx) {
+			tlb->tbuf_exec[j].tag = 0;
+		}
+
+		if (tlb->tbuf_read[j].idx == idx) {
+			tlb->tbuf_read[j].tag = 0;
+		}
+
+		if (tlb->tbuf_write[j].idx == idx) {
+			tlb->tbuf_write[j].tag = 0;
+		}
+	}
 }
 
 static inline
-int p405_tlb_match_valid (p405_tlbe_t *ent, uint32_t ea, uint32_t pid)
+uint32_t p405_tbuf_tag (p405_t *c, uint32_t ea)
 {
+	uint32_t tag;
+
+	tag = (ea & 0xfffff000UL) | ((c->pid & 0xff) << 2) | 1;
+
+	if (p405_get_msr_pr (c)) {
+		tag |= 2;
+	}
+
+	return (tag);
+}
+
+static inline
+p405_tbuf_t *p405_tbuf_get (p405_tbuf_t *tbuf, uint32_t ea)
+{
+	return (&tbuf[(ea >> 12) & (P405_TBUF_SIZE - 1)]);
+}
+
+/*
+ * Enter a translation into a translation buffer entry. ea is the real
+ * address that the TLB entry ent translated to.
+ */
+static inline
+void p405_tbuf_set (p405_tbuf_t *buf, uint32_t tag, uint32_t ea, const p405_tlbe_t *ent)
+{
+	if (p405_get_tlbe_size (ent) == 0) {
+		return;
+	}
+
+	buf->tag = tag;
+	buf->raddr = ea & 0xfffff000UL;
+	buf->endian = ent->endian;
+	buf->idx = ent->idx;
+}
+
+/*
+ * Check if the translation of ea for execution is buffered. This is
+ * the case if ea is mapped by a page of at least 4K.
+ */
+int p405_tbuf_check_exec (p405_t *c, uint32_t ea)
+{
+	return (p405_tbuf_get (c->tlb.tbuf_exec, ea)->tag == p405_tbuf_tag (c, ea));
+}
+
+static inline
+int p405_tlb_match (p405_tlbe_t *ent, uint32_t ea, uint32_t pid)
+{
+	if ((ent->tlbhi & P405_TLBHI_V) == 0) {
+		return (0);
+	}
+
 	if ((ea & ent->mask) != ent->vaddr) {
 		return (0);
 	}
@@ -158,6 +252,8 @@ void p405_set_tlb_entry_hi (p405_t *c, unsigned idx, uint32_t tlbhi, uint8_t pid
 {
 	p405_tlbe_t *ent;
 
+	p405_tbuf_invalidate (c, idx % P405_TLB_ENTRIES);
+
 	ent = &c->tlb.entry[idx % P405_TLB_ENTRIES];
 
 	ent->tlbhi = tlbhi;
@@ -165,15 +261,13 @@ void p405_set_tlb_entry_hi (p405_t *c, unsigned idx, uint32_t tlbhi, uint8_t pid
 	ent->mask = 0xfffffc00UL << (2 * p405_get_tlbe_size (ent));
 	ent->vaddr = tlbhi & ent->mask;
 	ent->endian = (tlbhi & P405_TLBHI_E) != 0;
-
-	p405_tbuf_clear (c);
 }
 
 void p405_set_tlb_entry_lo (p405_t *c, unsigned idx, uint32_t tlblo)
 {
-	c->tlb.entry[idx % P405_TLB_ENTRIES].tlblo = tlblo;
+	p405_tbuf_invalidate (c, idx % P405_TLB_ENTRIES);
 
-	p405_tbuf_clear (c);
+	c->tlb.entry[idx % P405_TLB_ENTRIES].tlblo = tlblo;
 }
 
 uint32_t p405_get_tlb_entry_hi (p405_t *c, unsigned idx)
@@ -225,6 +319,8 @@ int p405_translate (p405_t *c, uint32_t *ea, int *e, unsigned xlat)
 
 int p405_translate_read (p405_t *c, uint32_t *ea, int *e)
 {
+	uint32_t    tag;
+	p405_tbuf_t *buf;
 	p405_tlbe_t *ent;
 
 	if (p405_get_msr_dr (c) == 0) {
@@ -232,13 +328,13 @@ int p405_translate_read (p405_t *c, uint32_t *ea, int *e)
 		return (0);
 	}
 
-	if (c->tlb.tbuf_read != NULL) {
-		ent = c->tlb.tbuf_read;
-		if (p405_tlb_match_valid (ent, *ea, c->pid)) {
-			*ea = (*ea & ~ent->mask) | (ent->tlblo & ent->mask);
-			*e = ent->endian;
-			return (0);
-		}
+	tag = p405_tbuf_tag (c, *ea);
+	buf = p405_tbuf_get (c->tlb.tbuf_read, *ea);
+
+	if (buf->tag == tag) {
+		*ea = buf->raddr | (*ea & 0x0fff);
+		*e = buf->endian;
+		return (0);
 	}
 
 	ent = p405_get_tlb_entry_ea (c, *ea);
@@ -259,13 +355,15 @@ int p405_translate_read (p405_t *c, uint32_t *ea, int *e)
 	*ea = (*ea & ~ent->mask) | (ent->tlblo & ent->mask);
 	*e = ent->endian;
 
-	c->tlb.tbuf_read = ent;
+	p405_tbuf_set (buf, tag, *ea, ent);
 
 	return (0);
 }
 
 int p405_translate_write (p405_t *c, uint32_t *ea, int *e)
 {
+	uint32_t    tag;
+	p405_tbuf_t *buf;
 	p405_tlbe_t *ent;
 
 	if (p405_get_msr_dr (c) == 0) {
@@ -273,13 +371,13 @@ int p405_translate_write (p405_t *c, uint32_t *ea, int *e)
 		return (0);
 	}
 
-	if (c->tlb.tbuf_write != NULL) {
-		ent = c->tlb.tbuf_write;
-		if (p405_tlb_match_valid (ent, *ea, c->pid)) {
-			*ea = (*ea & ~ent->mask) | (ent->tlblo & ent->mask);
-			*e = ent->endian;
-			return (0);
-		}
+	tag = p405_tbuf_tag (c, *ea);
+	buf = p405_tbuf_get (c->tlb.tbuf_write, *ea);
+
+	if (buf->tag == tag) {
+		*ea = buf->raddr | (*ea & 0x0fff);
+		*e = buf->endian;
+		return (0);
 	}
 
 	ent = p405_get_tlb_entry_ea (c, *ea);
@@ -330,13 +428,15 @@ int p405_translate_write (p405_t *c, uint32_t *ea, int *e)
 	*ea = (*ea & ~ent->mask) | (ent->tlblo & ent->mask);
 	*e = ent->endian;
 
-	c->tlb.tbuf_write = ent;
+	p405_tbuf_set (buf, tag, *ea, ent);
 
 	return (0);
 }
 
 int p405_translate_exec (p405_t *c, uint32_t *ea, int *e)
 {
+	uint32_t    tag;
+	p405_tbuf_t *buf;
 	p405_tlbe_t *ent;
 
 	if (p405_get_msr_ir (c) == 0) {
@@ -344,13 +444,13 @@ int p405_translate_exec (p405_t *c, uint32_t *ea, int *e)
 		return (0);
 	}
 
-	if (c->tlb.tbuf_exec != NULL) {
-		ent = c->tlb.tbuf_exec;
-		if (p405_tlb_match_valid (ent, *ea, c->pid)) {
-			*ea = (*ea & ~ent->mask) | (ent->tlblo & ent->mask);
-			*e = ent->endian;
-			return (0);
-		}
+	tag = p405_tbuf_tag (c, *ea);
+	buf = p405_tbuf_get (c->tlb.tbuf_exec, *ea);
+
+	if (buf->tag == tag) {
+		*ea = buf->raddr | (*ea & 0x0fff);
+		*e = buf->endian;
+		return (0);
 	}
 
 	ent = p405_get_tlb_entry_ea (c, *ea);
@@ -401,7 +501,7 @@ int p405_translate_exec (p405_t *c, uint32_t *ea, int *e)
 	*ea = (*ea & ~ent->mask) | (ent->tlblo & ent->mask);
 	*e = ent->endian;
 
-	c->tlb.tbuf_exec = ent;
+	p405_tbuf_set (buf, tag, *ea, ent);
 
 	return (0);
 }
@@ -611,6 +711,7 @@ int p405_dstore8 (p405_t *c, uint32_t addr, uint8_t val)
 
 	if (addr < c->ram_cnt) {
 		c->ram[addr] = val;
+		p405_icache_write (c, addr);
 	}
 	else if (c->set_uint8 != NULL) {
 		c->set_uint8 (c->mem_ext, addr, val);
@@ -659,6 +760,8 @@ int p405_dstore16 (p405_t *c, uint32_t addr, uint16_t val)
 			mem[0] = (val >> 8) & 0xff;
 			mem[1] = val & 0xff;
 		}
+
+		p405_icache_write (c, addr);
 	}
 	else if (c->set_uint16 != NULL) {
 		if (e) {
@@ -722,6 +825,8 @@ int p405_dstore32 (p405_t *c, uint32_t addr, uint32_t val)
 			mem[2] = (val >> 8) & 0xff;
 			mem[3] = val & 0xff;
 		}
+
+		p405_icache_write (c, addr);
 	}
 	else if (c->set_uint32 != NULL) {
 		if (e) {
@@ -1451,7 +1451,6 @@ void op_1f_1d3 (p405_t *c)
 
 	case P405_SPRN_PID:
 		p405_set_pid (c, rs);
-		p405_tbuf_clear (c);
 		break;
 
 	case P405_SPRN_PIT:
@@ -1549,6 +1548,7 @@ void op_1f_1d3 (p405_t *c)
 
 	case P405_SPRN_ZPR:
 		p405_set_zpr (c, rs);
+		p405_tbuf_clear (c);
 		break;
 
 	default:
@@ -2439,10 +2439,22 @@ void op_1f_3d2 (p405_t *c)
 static
 void op_1f_3d6 (p405_t *c)
 {
+	int      e;
+	uint32_t ea;
+
 	if (p405_check_reserved (c, 0x03e00001UL)) {
 		return;
 	}
 
+	if (p405_get_ea (c, &ea, 1, 0)) {
+		return;
+	}
+
+	if (p405_translate (c, &ea, &e, P405_XLAT_CPU) == 0) {
+		ea &= ~(unsigned long) (P405_CACHE_LINE_SIZE - 1);
+		p405_icache_invalidate (c, ea, P405_CACHE_LINE_SIZE);
+	}
+
 	p405_set_clk (c, 4, 1);
 }
 
@@ -49,6 +49,8 @@ void p405_init (p405_t *c)
 	c->ram = NULL;
 	c->ram_cnt = 0;
 
+	p405_icache_init (c);
+
 	c->dcr_ext = NULL;
 	c->get_dcr = NULL;
 	c->set_dcr = NULL;
@@ -86,6 +88,7 @@ p405_t *p405_new (void)
 
 void p405_free (p405_t *c)
 {
+	p405_icache_free (c);
 }
 
 void p405_del (p405_t *c)
@@ -116,6 +119,8 @@ void p405_set_ram (p405_t *c, unsigned char *ram, unsigned long cnt)
 {
 	c->ram = ram;
 	c->ram_cnt = cnt;
+
+	p405_icache_set_ram (c);
 }
 
 void p405_set_dcr_fct (p405_t *c, void *ext, void *get, void *set)
@@ -365,6 +370,7 @@ int p405_set_reg (p405_t *c, const char *reg, unsigned long val)
 	}
 	else if (strcmp (reg, "zpr") == 0) {
 		p405_set_zpr (c, val);
+		p405_tbuf_clear (c);
 		return (0);
 	}
 
@@ -434,6 +440,8 @@ void p405_set_mem8 (p405_t *c, uint32_t addr, uint8_t val)
 	if (c->set_uint8 != NULL) {
 		c->set_uint8 (c->mem_ext, addr, val);
 	}
+
+	p405_icache_invalidate (c, addr, 1);
 }
 
 void p405_set_mem16 (p405_t *c, uint32_t addr, uint16_t val)
@@ -441,6 +449,8 @@ void p405_set_mem16 (p405_t *c, uint32_t addr, uint16_t val)
 	if (c->set_uint16 != NULL) {
 		c->set_uint16 (c->mem_ext, addr, val);
 	}
+
+	p405_icache_invalidate (c, addr, 2);
 }
 
 void p405_set_mem32 (p405_t *c, uint32_t addr, uint32_t val)
@@ -448,6 +458,8 @@ void p405_set_mem32 (p405_t *c, uint32_t addr, uint32_t val)
 	if (c->set_uint32 != NULL) {
 		c->set_uint32 (c->mem_ext, addr, val);
 	}
+
+	p405_icache_invalidate (c, addr, 4);
 }
 
 unsigned long p405_get_dcr (p405_t *c, unsigned long dcrn)
@@ -476,8 +488,6 @@ void p405_undefined (p405_t *c)
 static
 void p405_exception (p405_t *c, uint32_t ofs)
 {
-	p405_tbuf_clear (c);
-
 	if (c->log_exception != NULL) {
 		c->log_exception (c->log_ext, ofs);
 	}
@@ -652,21 +662,23 @@ void p405_reset (p405_t *c)
 
 void p405_execute (p405_t *c)
 {
-	unsigned op;
+	p405_icache_ent_t *ent;
+
+	ent = p405_icache_fetch (c);
 
-	if (p405_ifetch (c, c->pc, &c->ir)) {
+	if (ent == NULL) {
 		return;
 	}
 
+	c->ir = ent->ir;
+
 #ifdef P405_LOG_OPCODE
 	if (c->log_opcode != NULL) {
 		c->log_opcode (c->log_ext, c->ir);
 	}
 #endif
 
-	op = (c->ir >> 26) & 0x3f;
-
-	c->opcodes.op[op] (c);
+	ent->op (c);
 
 	c->oprcnt += 1;
 
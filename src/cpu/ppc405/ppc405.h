@@ -47,6 +47,14 @@ struct p405_s;
 
 #define P405_TLB_ENTRIES 64
 
+/* the number of entries in each translation buffer */
+#define P405_TBUF_SIZE 256
+
+/* the predecoded instruction cache */
+#define P405_IC_BITS      13
+#define P405_IC_CNT       (1U << P405_IC_BITS)
+#define P405_IC_PAGE_BITS 12
+
 #define P405_XLAT_CPU     0
 #define P405_XLAT_REAL    1
 #define P405_XLAT_VIRTUAL 2
@@ -104,13 +112,27 @@ typedef struct p405_tlbe_s {
 } p405_tlbe_t;
 
 
+/*
+ * A translation buffer entry maps a 4K virtual page to a real page. The
+ * tag contains the virtual page, the PID in bits 2-9, MSR[PR] in bit 1
+ * and a valid bit in bit 0.
+ */
+typedef struct {
+	uint32_t           tag;
+	uint32_t           raddr;
+	unsigned char      endian;
+	unsigned char      idx;
+} p405_tbuf_t;
+
+
 typedef struct {
 	p405_tlbe_t entry[P405_TLB_ENTRIES];
 	p405_tlbe_t *first;
 
-	p405_tlbe_t *tbuf_exec;
-	p405_tlbe_t *tbuf_read;
-	p405_tlbe_t *tbuf_write;
+	/* direct mapped translation buffers, indexed by virtual page */
+	p405_tbuf_t tbuf_exec[P405_TBUF_SIZE];
+	p405_tbuf_t tbuf_read[P405_TBUF_SIZE];
+	p405_tbuf_t tbuf_write[P405_TBUF_SIZE];
 } p405_tlb_t;
 
 
@@ -344,6 +366,20 @@ typedef struct {
 } p405_opcode_map_t;
 
 
+/*
+ * A predecoded instruction cache entry, holding the instruction at the
+ * real address addr and its opcode handler. Bit 0 of addr is set if the
+ * instruction was fetched little-endian. The entry is valid if gen is
+ * equal to the generation number of its page.
+ */
+typedef struct {
+	uint32_t      addr;
+	uint32_t      ir;
+	unsigned long gen;
+	p405_opcode_f op;
+} p405_icache_ent_t;
+
+
 typedef struct p405_s {
 	void               *mem_ext;
 
@@ -358,6 +394,25 @@ typedef struct p405_s {
 	unsigned char      *ram;
 	unsigned long      ram_cnt;
 
+	/*
+	 * The predecoded instruction cache for instructions in ram. ic_tmp
+	 * holds instructions fetched from outside of ram. ic_vpage is the
+	 * virtual page (with bit 0 set) that the last instruction was
+	 * fetched from while msr was ic_msr and pid was ic_pid. Its real
+	 * page is ic_vpage + ic_radd. ic_vpage is 0 if there is no such page.
+	 */
+	p405_icache_ent_t  *ic;
+	unsigned long      *ic_pgen;
+	unsigned long      ic_pcnt;
+	p405_icache_ent_t  ic_tmp;
+
+	uint32_t           ic_vpage;
+	uint32_t           ic_radd;
+	uint32_t           ic_msr;
+	uint32_t           ic_pid;
+	unsigned char      ic_e;
+	unsigned long      *ic_pg;
+
 	void               *dcr_ext;
 	p405_get_uint32_f  get_dcr;
 	p405_set_uint32_f  set_dcr;
@@ -503,6 +558,23 @@ void p405_set_mem_fct (p405_t *c, void *ext,
 
 void p405_set_ram (p405_t *c, unsigned char *ram, unsigned long cnt);
 
+/*!***************************************************************************
+ * @short Invalidate the instruction cache for a range of real addresses
+ * @param c    The cpu context
+ * @param addr The real start address
+ * @param cnt  The size of the range in bytes
+ *
+ * Stores by the cpu and writes through p405_set_mem8/16/32() invalidate
+ * the instruction cache. Other writes to ram must be reported with this
+ * function.
+ *****************************************************************************/
+void p405_icache_invalidate (p405_t *c, unsigned long addr, unsigned long cnt);
+
+/*!***************************************************************************
+ * @short Invalidate the entire instruction cache
+ *****************************************************************************/
+void p405_icache_flush (p405_t *c);
+
 /*!***************************************************************************
  * @short Set the DCR access functions
  * @param c The cpu context
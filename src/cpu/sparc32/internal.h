@@ -88,8 +88,7 @@ int s32_dstore32 (sparc32_t *c, uint32_t addr, uint8_t asi, uint32_t val);
 } while (0)
 
 
-void s32_regstk_load (sparc32_t *c, unsigned wdw);
-void s32_regstk_save (sparc32_t *c, unsigned wdw);
+void s32_regstk_set (sparc32_t *c, unsigned wdw);
 
 void s32_set_opcodes (sparc32_t *c);
 
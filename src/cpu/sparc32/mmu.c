@@ -27,13 +27,25 @@
 #include "internal.h"
 
 
+/*
+ * The text and data address spaces are mapped directly to the
+ * physical address space, so accesses to them can use the ram.
+ */
+#define s32_asi_ram(asi) (((asi) & 0xfc) == S32_ASI_UTEXT)
+
+
 int s32_ifetch (sparc32_t *c, uint32_t addr, uint8_t asi, uint32_t *val)
 {
 	addr &= ~0x03UL;
 
 	s32_set_asi (c, asi);
 
-	if (c->get_uint32 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		unsigned char *mem = &c->ram[addr];
+
+		*val = (mem[0] << 24) | (mem[1] << 16) | (mem[2] << 8) | mem[3];
+	}
+	else if (c->get_uint32 != NULL) {
 		*val = c->get_uint32 (c->mem_ext, addr);
 	}
 	else {
@@ -47,7 +59,10 @@ int s32_dload8 (sparc32_t *c, uint32_t addr, uint8_t asi, uint8_t *val)
 {
 	s32_set_asi (c, asi);
 
-	if (c->get_uint8 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		*val = c->ram[addr];
+	}
+	else if (c->get_uint8 != NULL) {
 		*val = c->get_uint8 (c->mem_ext, addr);
 	}
 	else {
@@ -61,7 +76,12 @@ int s32_dload16 (sparc32_t *c, uint32_t addr, uint8_t asi, uint16_t *val)
 {
 	s32_set_asi (c, asi);
 
-	if (c->get_uint16 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		unsigned char *mem = &c->ram[addr];
+
+		*val = (mem[0] << 8) | mem[1];
+	}
+	else if (c->get_uint16 != NULL) {
 		*val = c->get_uint16 (c->mem_ext, addr);
 	}
 	else {
@@ -75,7 +95,12 @@ int s32_dload32 (sparc32_t *c, uint32_t addr, uint8_t asi, uint32_t *val)
 {
 	s32_set_asi (c, asi);
 
-	if (c->get_uint32 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		unsigned char *mem = &c->ram[addr];
+
+		*val = (mem[0] << 24) | (mem[1] << 16) | (mem[2] << 8) | mem[3];
+	}
+	else if (c->get_uint32 != NULL) {
 		*val = c->get_uint32 (c->mem_ext, addr);
 	}
 	else {
@@ -89,7 +114,10 @@ int s32_dstore8 (sparc32_t *c, uint32_t addr, uint8_t asi, uint8_t val)
 {
 	s32_set_asi (c, asi);
 
-	if (c->set_uint8 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		c->ram[addr] = val;
+	}
+	else if (c->set_uint8 != NULL) {
 		c->set_uint8 (c->mem_ext, addr, val);
 	}
 
@@ -100,7 +128,13 @@ int s32_dstore16 (sparc32_t *c, uint32_t addr, uint8_t asi, uint16_t val)
 {
 	s32_set_asi (c, asi);
 
-	if (c->set_uint16 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		unsigned char *mem = &c->ram[addr];
+
+		mem[0] = (val >> 8) & 0xff;
+		mem[1] = val & 0xff;
+	}
+	else if (c->set_uint16 != NULL) {
 		c->set_uint16 (c->mem_ext, addr, val);
 	}
 
@@ -111,7 +145,15 @@ int s32_dstore32 (sparc32_t *c, uint32_t addr, uint8_t asi, uint32_t val)
 {
 	s32_set_asi (c, asi);
 
-	if (c->set_uint32 != NULL) {
+	if ((addr < c->ram_cnt) && s32_asi_ram (asi)) {
+		unsigned char *mem = &c->ram[addr];
+
+		mem[0] = (val >> 24) & 0xff;
+		mem[1] = (val >> 16) & 0xff;
+		mem[2] = (val >> 8) & 0xff;
+		mem[3] = val & 0xff;
+	}
+	else if (c->set_uint32 != NULL) {
 		c->set_uint32 (c->mem_ext, addr, val);
 	}
 
@@ -1121,8 +1121,7 @@ void op231 (sparc32_t *c)
 			return;
 		}
 
-		s32_regstk_save (c, cwp1);
-		s32_regstk_load (c, cwp2);
+		s32_regstk_set (c, cwp2);
 	}
 
 	if (cwp2 & S32_PSR_S) {
@@ -2130,16 +2129,28 @@ s32_opcode_f s32_opcodes[4][64] = {
 
 void s32_set_opcodes (sparc32_t *c)
 {
-	unsigned i, j;
+	unsigned     i, j;
+	s32_opcode_f fct;
 
 	for (j = 0; j < 4; j++) {
 		for (i = 0; i < 64; i++) {
-			if (s32_opcodes[j][i] != NULL) {
-				c->opcodes[j][i] = s32_opcodes[j][i];
+			if (j == 0) {
+				/* format 2, op2 is in bits 22-24 */
+				fct = s32_opcodes[0][i >> 3];
+			}
+			else if (j == 1) {
+				/* format 1, call */
+				fct = s32_opcodes[1][0];
 			}
 			else {
-				c->opcodes[j][i] = &s32_op_undefined;
+				fct = s32_opcodes[j][i];
+			}
+
+			if (fct == NULL) {
+				fct = &s32_op_undefined;
 			}
+
+			c->opcodes[64 * j + i] = fct;
 		}
 	}
 }
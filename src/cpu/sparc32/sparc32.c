@@ -40,6 +40,9 @@ void s32_init (sparc32_t *c)
 	c->set_uint16 = NULL;
 	c->set_uint32 = NULL;
 
+	c->ram = NULL;
+	c->ram_cnt = 0;
+
 	c->log_ext = NULL;
 	c->log_opcode = NULL;
 	c->log_undef = NULL;
@@ -51,6 +54,10 @@ void s32_init (sparc32_t *c)
 
 	c->psr = 0;
 
+	c->wdw = 0;
+	c->regp[0] = c->greg;
+	s32_regstk_set (c, 0);
+
 	c->oprcnt = 0;
 	c->clkcnt = 0;
 }
@@ -97,6 +104,12 @@ void s32_set_mem_fct (sparc32_t *c, void *ext,
 	c->set_uint32 = set32;
 }
 
+void s32_set_ram (sparc32_t *c, unsigned char *ram, unsigned long cnt)
+{
+	c->ram = ram;
+	c->ram_cnt = cnt;
+}
+
 void s32_set_nwindows (sparc32_t *c, unsigned n)
 {
 	if (n < 2) {
@@ -251,15 +264,18 @@ void s32_reset (sparc32_t *c)
 {
 	unsigned i, n;
 
-	for (i = 0; i < 32; i++) {
-		c->reg[i] = 0;
+	for (i = 0; i < 8; i++) {
+		c->greg[i] = 0;
 	}
 
-	n = 16 * c->nwindows;
+	n = 16 * c->nwindows + 8;
 	for (i = 0; i < n; i++) {
 		c->regstk[i] = 0;
 	}
 
+	c->wdw = 0;
+	s32_regstk_set (c, 0);
+
 	c->psr = S32_PSR_S;
 
 	c->pc = 0x00000000UL;
@@ -282,26 +298,35 @@ void s32_reset (sparc32_t *c)
 	c->clkcnt = 0;
 }
 
-void s32_regstk_load (sparc32_t *c, unsigned wdw)
+/*
+ * The outs, locals and ins of window w are at regstk[16 * w] to
+ * regstk[16 * w + 23], so that the ins of window w are the outs of
+ * window w + 1. The ins of the last window are the outs of window 0.
+ * They are kept in the 8 extra entries at the end of regstk while the
+ * last window is the current window.
+ */
+void s32_regstk_set (sparc32_t *c, unsigned wdw)
 {
-	if (wdw == 0) {
-		memcpy (c->reg + 16, c->regstk, 16 * sizeof (uint32_t));
-		memcpy (c->reg + 8, c->regstk + (16 * c->nwindows - 8), 8 * sizeof (uint32_t));
-	}
-	else {
-		memcpy (c->reg + 8, c->regstk + (16 * wdw - 8), 24 * sizeof (uint32_t));
-	}
-}
+	uint32_t *p;
+	unsigned last;
 
-void s32_regstk_save (sparc32_t *c, unsigned wdw)
-{
-	if (wdw == 0) {
-		memcpy (c->regstk, c->reg + 16, 16 * sizeof (uint32_t));
-		memcpy (c->regstk + (16 * c->nwindows - 8), c->reg + 8, 8 * sizeof (uint32_t));
+	last = c->nwindows - 1;
+
+	if (c->wdw == last) {
+		memcpy (c->regstk, c->regstk + 16 * c->nwindows, 8 * sizeof (uint32_t));
 	}
-	else {
-		memcpy (c->regstk + (16 * wdw - 8), c->reg + 8, 24 * sizeof (uint32_t));
+
+	if (wdw == last) {
+		memcpy (c->regstk + 16 * c->nwindows, c->regstk, 8 * sizeof (uint32_t));
 	}
+
+	p = c->regstk + 16 * wdw;
+
+	c->regp[1] = p;
+	c->regp[2] = p + 8;
+	c->regp[3] = p + 16;
+
+	c->wdw = wdw;
 }
 
 int s32_save (sparc32_t *c, int check)
@@ -317,9 +342,8 @@ int s32_save (sparc32_t *c, int check)
 		}
 	}
 
-	s32_regstk_save (c, cwp1);
 	s32_set_cwp (c, cwp2);
-	s32_regstk_load (c, cwp2);
+	s32_regstk_set (c, cwp2);
 
 	if (s32_get_wim (c) & (1UL << cwp2)) {
 		return (1);
@@ -344,9 +368,8 @@ int s32_restore (sparc32_t *c, int check)
 		}
 	}
 
-	s32_regstk_save (c, cwp1);
 	s32_set_cwp (c, cwp2);
-	s32_regstk_load (c, cwp2);
+	s32_regstk_set (c, cwp2);
 
 	if (s32_get_wim (c) & (1UL << cwp2)) {
 		return (1);
@@ -422,23 +445,7 @@ void s32_execute (sparc32_t *c)
 		c->log_opcode (c->log_ext, c->ir);
 	}
 
-	switch ((c->ir >> 30) & 0x03) {
-	case 0:
-		c->opcodes[0][(c->ir >> 22) & 0x07] (c);
-		break;
-
-	case 1:
-		c->opcodes[1][0] (c);
-		break;
-
-	case 2:
-		c->opcodes[2][(c->ir >> 19) & 0x3f] (c);
-		break;
-
-	case 3:
-		c->opcodes[3][(c->ir >> 19) & 0x3f] (c);
-		break;
-	}
+	c->opcodes[((c->ir >> 24) & 0xc0) | ((c->ir >> 19) & 0x3f)] (c);
 
 	c->oprcnt += 1;
 
@@ -82,7 +82,7 @@ struct sparc32_s;
 		if (val) (var) |= (bits); else (var) &= ~(bits); \
 	} while (0)
 
-#define s32_get_gpr(c, n) (((n) == 0) ? 0 : (c)->reg[(n)])
+#define s32_get_gpr(c, n) (((n) == 0) ? 0 : (c)->regp[(n) >> 3][(n) & 7])
 #define s32_get_pc(c) ((c)->pc)
 #define s32_get_npc(c) ((c)->npc)
 #define s32_get_psr(c) ((c)->psr)
@@ -90,7 +90,9 @@ struct sparc32_s;
 #define s32_get_tbr(c) ((c)->tbr)
 #define s32_get_y(c) ((c)->y)
 
-#define s32_set_gpr(c, n, v) do { if ((n) != 0) (c)->reg[(n)] = (v); } while (0)
+#define s32_set_gpr(c, n, v) do { \
+	if ((n) != 0) (c)->regp[(n) >> 3][(n) & 7] = (v); \
+	} while (0)
 #define s32_set_pc(c, v) do { (c)->pc = (v); } while (0)
 #define s32_set_npc(c, v) do { (c)->npc = (v); } while (0)
 #define s32_set_psr(c, v) do { (c)->psr = (v); } while (0)
@@ -152,12 +154,23 @@ typedef struct sparc32_s {
 	s32_set_uint16_f   set_uint16;
 	s32_set_uint32_f   set_uint32;
 
+	unsigned char      *ram;
+	unsigned long      ram_cnt;
+
 	void               *log_ext;
 	void               (*log_opcode) (void *ext, unsigned long ir);
 	void               (*log_undef) (void *ext, unsigned long ir);
 	void               (*log_exception) (void *ext, unsigned tn);
 
-	uint32_t           reg[32];
+	/*
+	 * The global registers and the current register window. regp[0]
+	 * points to the globals, regp[1] to regp[3] point to the outs,
+	 * locals and ins of window wdw in regstk.
+	 */
+	uint32_t           greg[8];
+	uint32_t           *regp[4];
+	unsigned           wdw;
+
 	uint32_t           pc;
 	uint32_t           npc;
 	uint32_t           psr;
@@ -166,7 +179,7 @@ typedef struct sparc32_s {
 	uint32_t           y;
 
 	unsigned           nwindows;
-	uint32_t           regstk[16 * S32_MWINDOWS];
+	uint32_t           regstk[16 * S32_MWINDOWS + 8];
 
 	uint8_t            asi;
 	uint8_t            asi_text;
@@ -181,7 +194,8 @@ typedef struct sparc32_s {
 	unsigned long long oprcnt;
 	unsigned long long clkcnt;
 
-	s32_opcode_f       opcodes[4][64];
+	/* indexed by bits 30-31 and 19-24 of the instruction */
+	s32_opcode_f       opcodes[256];
 } sparc32_t;
 
 
@@ -225,6 +239,17 @@ void s32_set_mem_fct (sparc32_t *c, void *ext,
 	void *set8, void *set16, void *set32
 );
 
+/*!***************************************************************************
+ * @short Set the ram
+ * @param c   The sparc32 context struct
+ * @param ram The ram at address 0
+ * @param cnt The ram size in bytes
+ *
+ * Instruction fetches, loads and stores in the text and data address
+ * spaces access the ram directly instead of using the memory functions.
+ *****************************************************************************/
+void s32_set_ram (sparc32_t *c, unsigned char *ram, unsigned long cnt);
+
 /*!***************************************************************************
  * @short Set the number of register windows
  * @param c The sparc32 context struct
@@ -26,6 +26,23 @@
 #include "memory.h"
 
 
+unsigned long mem_map_gen = 1;
+
+/* This marks pages that are not completely covered by one block */
+mem_blk_t mem_page_mixed;
+
+
+static
+void mem_map_changed (void)
+{
+	mem_map_gen += 1;
+
+	if (mem_map_gen == 0) {
+		mem_map_gen = 1;
+	}
+}
+
+
 int mem_blk_init (mem_blk_t *blk, unsigned long base, unsigned long size, int alloc)
 {
 	if (alloc) {
@@ -147,6 +164,7 @@ void mem_blk_set_fget (mem_blk_t *blk, void *ext, void *g8, void *g16, void *g32
 	blk->get_uint32 = g32;
 
 	mem_blk_fix_fct (blk);
+	mem_map_changed ();
 }
 
 void mem_blk_set_fset (mem_blk_t *blk, void *ext, void *s8, void *s16, void *s32)
@@ -157,6 +175,7 @@ void mem_blk_set_fset (mem_blk_t *blk, void *ext, void *s8, void *s16, void *s32
 	blk->set_uint32 = s32;
 
 	mem_blk_fix_fct (blk);
+	mem_map_changed ();
 }
 
 void mem_blk_set_fct (mem_blk_t *blk, void *ext,
@@ -173,6 +192,7 @@ void mem_blk_set_fct (mem_blk_t *blk, void *ext,
 	blk->set_uint32 = s32;
 
 	mem_blk_fix_fct (blk);
+	mem_map_changed ();
 }
 
 void mem_blk_set_ext (mem_blk_t *blk, void *ext)
@@ -200,6 +220,8 @@ void mem_blk_set_data (mem_blk_t *blk, void *data, int del)
 
 	blk->data = data;
 	blk->data_del = (data != NULL) && del;
+
+	mem_map_changed ();
 }
 
 int mem_blk_get_active (mem_blk_t *blk)
@@ -210,6 +232,8 @@ int mem_blk_get_active (mem_blk_t *blk)
 void mem_blk_set_active (mem_blk_t *blk, int val)
 {
 	blk->active = (val != 0);
+
+	mem_map_changed ();
 }
 
 int mem_blk_get_readonly (mem_blk_t *blk)
@@ -220,6 +244,8 @@ int mem_blk_get_readonly (mem_blk_t *blk)
 void mem_blk_set_readonly (mem_blk_t *blk, int val)
 {
 	blk->readonly = (val != 0);
+
+	mem_map_changed ();
 }
 
 unsigned long mem_blk_get_addr (const mem_blk_t *blk)
@@ -231,6 +257,8 @@ void mem_blk_set_addr (mem_blk_t *blk, unsigned long addr)
 {
 	blk->addr1 = addr;
 	blk->addr2 = addr + blk->size - 1;
+
+	mem_map_changed ();
 }
 
 unsigned long mem_blk_get_size (const mem_blk_t *blk)
@@ -242,6 +270,8 @@ void mem_blk_set_size (mem_blk_t *blk, unsigned long size)
 {
 	blk->size = size;
 	blk->addr2 = blk->addr1 + size - 1;
+
+	mem_map_changed ();
 }
 
 
@@ -471,6 +501,10 @@ void mem_init (memory_t *mem)
 
 	mem_init_last (mem);
 
+	mem->pcnt = 0;
+	mem->page = NULL;
+	mem->gen = 0;
+
 	mem->ext = NULL;
 	mem->get_uint8 = NULL;
 	mem->get_uint16 = NULL;
@@ -508,6 +542,7 @@ void mem_free (memory_t *mem)
 		}
 
 		free (mem->lst);
+		free (mem->page);
 	}
 }
 
@@ -581,6 +616,8 @@ void mem_add_blk (memory_t *mem, mem_blk_t *blk, int del)
 	lst->del = (del != 0);
 
 	mem_init_last (mem);
+
+	mem_map_changed ();
 }
 
 void mem_rmv_blk (memory_t *mem, const mem_blk_t *blk)
@@ -603,6 +640,8 @@ void mem_rmv_blk (memory_t *mem, const mem_blk_t *blk)
 	mem->cnt = j;
 
 	mem_init_last (mem);
+
+	mem_map_changed ();
 }
 
 void mem_rmv_all (memory_t *mem)
@@ -618,6 +657,8 @@ void mem_rmv_all (memory_t *mem)
 	mem->cnt = 0;
 
 	mem_init_last (mem);
+
+	mem_map_changed ();
 }
 
 void mem_move_to_front (memory_t *mem, unsigned long addr)
@@ -640,17 +681,135 @@ void mem_move_to_front (memory_t *mem, unsigned long addr)
 
 			mem->lst[0].blk = blk;
 
+			mem_init_last (mem);
+			mem_map_changed ();
+
 			return;
 		}
 	}
 }
 
+static
+void mem_map_set_page (mem_page_t *pg, mem_blk_t *blk, unsigned long addr)
+{
+	pg->blk = blk;
+	pg->rd = NULL;
+	pg->wr = NULL;
+
+	if ((blk == NULL) || (blk == &mem_page_mixed) || (blk->data == NULL)) {
+		return;
+	}
+
+	if ((blk->get_uint8 == NULL) && (blk->get_uint16 == NULL) && (blk->get_uint32 == NULL)) {
+		pg->rd = blk->data + (addr - blk->addr1);
+	}
+
+	if (blk->readonly) {
+		return;
+	}
+
+	if ((blk->set_uint8 == NULL) && (blk->set_uint16 == NULL) && (blk->set_uint32 == NULL)) {
+		pg->wr = blk->data + (addr - blk->addr1);
+	}
+}
+
+void mem_map_update (memory_t *mem)
+{
+	unsigned      i;
+	unsigned long j, cnt, p1, p2, addr;
+	mem_blk_t     *blk;
+
+	mem->gen = mem_map_gen;
+
+	cnt = 0;
+
+	for (i = 0; i < mem->cnt; i++) {
+		blk = mem->lst[i].blk;
+
+		if (blk->active && (blk->size > 0)) {
+			if ((blk->addr2 >> MEM_PAGE_BITS) >= cnt) {
+				cnt = (blk->addr2 >> MEM_PAGE_BITS) + 1;
+			}
+		}
+	}
+
+	if (cnt > MEM_PAGE_MAX) {
+		cnt = MEM_PAGE_MAX;
+	}
+
+	if (cnt != mem->pcnt) {
+		free (mem->page);
+
+		mem->pcnt = 0;
+		mem->page = NULL;
+
+		if (cnt == 0) {
+			return;
+		}
+
+		mem->page = malloc (cnt * sizeof (mem_page_t));
+
+		if (mem->page == NULL) {
+			return;
+		}
+
+		mem->pcnt = cnt;
+	}
+
+	for (j = 0; j < cnt; j++) {
+		mem_map_set_page (&mem->page[j], NULL, 0);
+	}
+
+	/*
+	 * Blocks earlier in the list take precedence, so the list is
+	 * processed back to front.
+	 */
+	i = mem->cnt;
+
+	while (i > 0) {
+		i -= 1;
+
+		blk = mem->lst[i].blk;
+
+		if ((blk->active == 0) || (blk->size == 0)) {
+			continue;
+		}
+
+		p1 = blk->addr1 >> MEM_PAGE_BITS;
+		p2 = blk->addr2 >> MEM_PAGE_BITS;
+
+		for (j = p1; (j <= p2) && (j < cnt); j++) {
+			addr = j << MEM_PAGE_BITS;
+
+			if ((blk->addr1 > addr) || (blk->addr2 < (addr + MEM_PAGE_MASK))) {
+				mem_map_set_page (&mem->page[j], &mem_page_mixed, addr);
+			}
+			else {
+				mem_map_set_page (&mem->page[j], blk, addr);
+			}
+		}
+	}
+}
+
 static inline
 mem_blk_t *mem_get_blk_inline (memory_t *mem, unsigned long addr, unsigned last)
 {
-	unsigned  i;
-	mem_blk_t *blk;
-	mem_lst_t *lst;
+	unsigned   i;
+	mem_blk_t  *blk;
+	mem_lst_t  *lst;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if (pg != NULL) {
+		if (pg->blk != &mem_page_mixed) {
+			return (pg->blk);
+		}
+	}
+	else if ((mem->pcnt < MEM_PAGE_MAX) && (mem->page != NULL)) {
+		/* there are no blocks above the page table */
+		return (NULL);
+	}
 
 	last &= (MEM_LAST_CNT - 1);
 
@@ -704,7 +863,14 @@ void *mem_get_ptr (memory_t *mem, unsigned long addr, unsigned long size)
 
 unsigned char mem_get_uint8 (memory_t *mem, unsigned long addr)
 {
-	mem_blk_t *blk;
+	mem_blk_t  *blk;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->rd != NULL)) {
+		return (pg->rd[addr & MEM_PAGE_MASK]);
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 1);
 
@@ -730,6 +896,13 @@ unsigned short mem_get_uint16_be (memory_t *mem, unsigned long addr)
 {
 	unsigned short val;
 	mem_blk_t      *blk;
+	mem_page_t     *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->rd != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 1))) {
+		return (buf_get_uint16_be (pg->rd, addr & MEM_PAGE_MASK));
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 1);
 
@@ -763,6 +936,13 @@ unsigned short mem_get_uint16_le (memory_t *mem, unsigned long addr)
 {
 	unsigned short val;
 	mem_blk_t      *blk;
+	mem_page_t     *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->rd != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 1))) {
+		return (buf_get_uint16_le (pg->rd, addr & MEM_PAGE_MASK));
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 1);
 
@@ -796,6 +976,13 @@ unsigned long mem_get_uint32_be (memory_t *mem, unsigned long addr)
 {
 	unsigned long val;
 	mem_blk_t     *blk;
+	mem_page_t    *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->rd != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 3))) {
+		return (buf_get_uint32_be (pg->rd, addr & MEM_PAGE_MASK));
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 1);
 
@@ -833,6 +1020,13 @@ unsigned long mem_get_uint32_le (memory_t *mem, unsigned long addr)
 {
 	unsigned long val;
 	mem_blk_t     *blk;
+	mem_page_t    *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->rd != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 3))) {
+		return (buf_get_uint32_le (pg->rd, addr & MEM_PAGE_MASK));
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 1);
 
@@ -889,7 +1083,15 @@ void mem_set_uint8_rw (memory_t *mem, unsigned long addr, unsigned char val)
 
 void mem_set_uint8 (memory_t *mem, unsigned long addr, unsigned char val)
 {
-	mem_blk_t *blk;
+	mem_blk_t  *blk;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->wr != NULL)) {
+		pg->wr[addr & MEM_PAGE_MASK] = val;
+		return;
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 2);
 
@@ -914,7 +1116,15 @@ void mem_set_uint8 (memory_t *mem, unsigned long addr, unsigned char val)
 
 void mem_set_uint16_be (memory_t *mem, unsigned long addr, unsigned short val)
 {
-	mem_blk_t *blk;
+	mem_blk_t  *blk;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->wr != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 1))) {
+		buf_set_uint16_be (pg->wr, addr & MEM_PAGE_MASK, val);
+		return;
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 2);
 
@@ -946,7 +1156,15 @@ void mem_set_uint16_be (memory_t *mem, unsigned long addr, unsigned short val)
 
 void mem_set_uint16_le (memory_t *mem, unsigned long addr, unsigned short val)
 {
-	mem_blk_t *blk;
+	mem_blk_t  *blk;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->wr != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 1))) {
+		buf_set_uint16_le (pg->wr, addr & MEM_PAGE_MASK, val);
+		return;
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 2);
 
@@ -978,7 +1196,15 @@ void mem_set_uint16_le (memory_t *mem, unsigned long addr, unsigned short val)
 
 void mem_set_uint32_be (memory_t *mem, unsigned long addr, unsigned long val)
 {
-	mem_blk_t *blk;
+	mem_blk_t  *blk;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->wr != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 3))) {
+		buf_set_uint32_be (pg->wr, addr & MEM_PAGE_MASK, val);
+		return;
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 2);
 
@@ -1014,7 +1240,15 @@ void mem_set_uint32_be (memory_t *mem, unsigned long addr, unsigned long val)
 
 void mem_set_uint32_le (memory_t *mem, unsigned long addr, unsigned long val)
 {
-	mem_blk_t *blk;
+	mem_blk_t  *blk;
+	mem_page_t *pg;
+
+	pg = mem_get_page (mem, addr);
+
+	if ((pg != NULL) && (pg->wr != NULL) && ((addr & MEM_PAGE_MASK) <= (MEM_PAGE_MASK - 3))) {
+		buf_set_uint32_le (pg->wr, addr & MEM_PAGE_MASK, val);
+		return;
+	}
 
 	blk = mem_get_blk_inline (mem, addr, 2);
 
@@ -29,6 +29,13 @@
 
 #define MEM_LAST_CNT 4
 
+#define MEM_PAGE_BITS 12
+#define MEM_PAGE_SIZE (1UL << MEM_PAGE_BITS)
+#define MEM_PAGE_MASK (MEM_PAGE_SIZE - 1)
+
+/* The maximum number of pages in the page table (256 MiB) */
+#define MEM_PAGE_MAX  65536
+
 
 typedef unsigned char (*mem_get_uint8_f) (void *blk, unsigned long addr);
 typedef unsigned short (*mem_get_uint16_f) (void *blk, unsigned long addr);
@@ -81,12 +88,34 @@ typedef struct {
 } mem_lst_t;
 
 
+/*!***************************************************************************
+ * @short A page table entry
+ *****************************************************************************/
+typedef struct {
+	/*
+	 * The memory block that covers the whole page, NULL if there is
+	 * no block in the page or mem_page_mixed if the block list must
+	 * be searched.
+	 */
+	mem_blk_t     *blk;
+
+	/* Direct pointers to the page data or NULL if blk must be used */
+	unsigned char *rd;
+	unsigned char *wr;
+} mem_page_t;
+
+
 typedef struct {
 	unsigned         cnt;
 	mem_lst_t        *lst;
 
 	mem_lst_t        *last[MEM_LAST_CNT];
 
+	/* The page table, rebuilt if gen != mem_map_gen */
+	unsigned long    pcnt;
+	mem_page_t       *page;
+	unsigned long    gen;
+
 	/* these functions are used if no block is found */
 	void             *ext;
 	mem_get_uint8_f  get_uint8;
@@ -100,6 +129,12 @@ typedef struct {
 } memory_t;
 
 
+/* This is incremented whenever the memory map of any memory_t changes */
+extern unsigned long mem_map_gen;
+
+extern mem_blk_t mem_page_mixed;
+
+
 
 /*!***************************************************************************
  * @short  Initialize a static memory block structure
@@ -299,6 +334,37 @@ void mem_rmv_all (memory_t *mem);
  *****************************************************************************/
 void mem_move_to_front (memory_t *mem, unsigned long addr);
 
+/*!***************************************************************************
+ * @short Rebuild the page table
+ * @param mem The memory structure
+ *
+ * This is done automatically on the next access after the memory map
+ * changed.
+ *****************************************************************************/
+void mem_map_update (memory_t *mem);
+
+/*!***************************************************************************
+ * @short  Get the page table entry for an address
+ * @param  mem  The memory structure
+ * @param  addr The address
+ * @return The page table entry or NULL if addr is not covered
+ *****************************************************************************/
+static inline
+mem_page_t *mem_get_page (memory_t *mem, unsigned long addr)
+{
+	addr >>= MEM_PAGE_BITS;
+
+	if (mem->gen != mem_map_gen) {
+		mem_map_update (mem);
+	}
+
+	if (addr >= mem->pcnt) {
+		return (NULL);
+	}
+
+	return (&mem->page[addr]);
+}
+
 /*!***************************************************************************
  * @short Get a memory block containing an address
  * @param  mem The memory structure